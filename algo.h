@@ -2427,8 +2427,9 @@ template <class RandomIter>
 void unchecked_insertion_sort(RandomIter first, RandomIter last)
 {
   for (auto i = first; i != last; ++i)
-  {
-    mystl::unchecked_linear_insert(i, *i);
+  { // 先复制一份，插入过程中 *i 会被覆盖
+    auto value = *i;
+    mystl::unchecked_linear_insert(i, value);
   }
 }
 
@@ -2513,7 +2514,7 @@ void intro_sort(RandomIter first, RandomIter last,
       return;
     }
     --depth_limit;
-    auto mid = mystl::median(*(first), *(first + (last - first) / 2), *(last - 1));
+    auto mid = mystl::median(*(first), *(first + (last - first) / 2), *(last - 1), comp);
     auto cut = mystl::unchecked_partition(first, last, mid, comp);
     mystl::intro_sort(cut, last, depth_limit, comp);
     last = cut;
@@ -2541,8 +2542,9 @@ void unchecked_insertion_sort(RandomIter first, RandomIter last,
                               Compared comp)
 {
   for (auto i = first; i != last; ++i)
-  {
-    mystl::unchecked_linear_insert(i, *i, comp);
+  { // 先复制一份，插入过程中 *i 会被覆盖
+    auto value = *i;
+    mystl::unchecked_linear_insert(i, value, comp);
   }
 }
 
@@ -1,9 +1,15 @@
 ﻿#ifndef MYTINYSTL_ASTRING_H_
 #define MYTINYSTL_ASTRING_H_
 
-// 定义了 string, wstring, u16string, u32string 类型
+// 定义了 string, wstring, u16string, u32string 类型，以及 string 与数值之间的转换函数
+
+#include <cctype>
+#include <limits>
+#include <type_traits>
 
 #include "basic_string.h"
+#include "charconv.h"
+#include "exceptdef.h"
 
 namespace mystl
 {
@@ -13,6 +19,111 @@ using wstring   = mystl::basic_string<wchar_t>;
 using u16string = mystl::basic_string<char16_t>;
 using u32string = mystl::basic_string<char32_t>;
 
+/*****************************************************************************************/
+// to_string：结果与 to_chars 相同，浮点数给出能还原原值的最短表示，而不是 std::to_string 的 "%f"
+
+template <class T>
+string charconv_to_string(T value)
+{
+  char buf[64];
+  const to_chars_result r = mystl::to_chars(buf, buf + sizeof(buf), value);
+  return string(buf, static_cast<size_t>(r.ptr - buf));
 }
-#endif // !MYTINYSTL_ASTRING_H_
 
+inline string to_string(int value)                { return charconv_to_string(value); }
+inline string to_string(long value)               { return charconv_to_string(value); }
+inline string to_string(long long value)          { return charconv_to_string(value); }
+inline string to_string(unsigned value)           { return charconv_to_string(value); }
+inline string to_string(unsigned long value)      { return charconv_to_string(value); }
+inline string to_string(unsigned long long value) { return charconv_to_string(value); }
+inline string to_string(float value)              { return charconv_to_string(value); }
+inline string to_string(double value)             { return charconv_to_string(value); }
+
+/*****************************************************************************************/
+// stoi / stol / stoll / stoul / stoull / stof / stod
+// 与 std 版本一样跳过开头的空白，接受 '+'，无法转换时抛出 std::invalid_argument，超出范围时抛出 std::out_of_range
+// 整数：base 为 16 或 0 时接受 "0x" 前缀，base 为 0 时按前缀决定进制
+// 浮点数：基于 from_chars，不接受十六进制浮点数
+
+template <class T>
+T sto_integer(const string& str, size_t* idx, int base, const char* name)
+{
+  const char* first = str.begin();
+  const char* last = str.end();
+  const char* p = first;
+  while (p != last && std::isspace(static_cast<unsigned char>(*p)))
+    ++p;
+  bool neg = false;
+  if (p != last && (*p == '+' || *p == '-'))
+  {
+    neg = *p == '-';
+    ++p;
+  }
+  if ((base == 0 || base == 16) && last - p > 2 && p[0] == '0' && (p[1] | 0x20) == 'x' &&
+      charconv_digit_value(p[2]) < 16)
+  {
+    p += 2;
+    base = 16;
+  }
+  else if (base == 0)
+  {
+    base = (p != last && *p == '0') ? 8 : 10;
+  }
+  unsigned long long mag = 0;
+  const from_chars_result r = mystl::from_chars(p, last, mag, base);
+  THROW_INVALID_ARGUMENT_IF(r.ec == std::errc::invalid_argument, name);
+  // 与 strtoul 一样，无符号类型接受 '-'，结果为取负后的值
+  const unsigned long long max = static_cast<unsigned long long>(std::numeric_limits<T>::max());
+  const unsigned long long limit = (std::is_signed<T>::value && neg) ? max + 1 : max;
+  THROW_OUT_OF_RANGE_IF(r.ec == std::errc::result_out_of_range || mag > limit, name);
+  if (idx != nullptr)
+    *idx = static_cast<size_t>(r.ptr - first);
+  if (!neg)
+    return static_cast<T>(mag);
+  if (std::is_signed<T>::value)
+    return mag == 0 ? static_cast<T>(0) : static_cast<T>(-static_cast<T>(mag - 1) - 1);
+  return static_cast<T>(0 - mag);
+}
+
+template <class T>
+T sto_float(const string& str, size_t* idx, const char* name)
+{
+  const char* first = str.begin();
+  const char* last = str.end();
+  const char* p = first;
+  while (p != last && std::isspace(static_cast<unsigned char>(*p)))
+    ++p;
+  if (p != last && *p == '+' && (p + 1 == last || p[1] != '-'))
+    ++p;
+  T value = 0;
+  const from_chars_result r = mystl::from_chars(p, last, value);
+  THROW_INVALID_ARGUMENT_IF(r.ec == std::errc::invalid_argument, name);
+  THROW_OUT_OF_RANGE_IF(r.ec == std::errc::result_out_of_range, name);
+  if (idx != nullptr)
+    *idx = static_cast<size_t>(r.ptr - first);
+  return value;
+}
+
+inline int stoi(const string& str, size_t* idx = nullptr, int base = 10)
+{ return sto_integer<int>(str, idx, base, "stoi"); }
+
+inline long stol(const string& str, size_t* idx = nullptr, int base = 10)
+{ return sto_integer<long>(str, idx, base, "stol"); }
+
+inline long long stoll(const string& str, size_t* idx = nullptr, int base = 10)
+{ return sto_integer<long long>(str, idx, base, "stoll"); }
+
+inline unsigned long stoul(const string& str, size_t* idx = nullptr, int base = 10)
+{ return sto_integer<unsigned long>(str, idx, base, "stoul"); }
+
+inline unsigned long long stoull(const string& str, size_t* idx = nullptr, int base = 10)
+{ return sto_integer<unsigned long long>(str, idx, base, "stoull"); }
+
+inline float stof(const string& str, size_t* idx = nullptr)
+{ return sto_float<float>(str, idx, "stof"); }
+
+inline double stod(const string& str, size_t* idx = nullptr)
+{ return sto_float<double>(str, idx, "stod"); }
+
+}
+#endif // !MYTINYSTL_ASTRING_H_
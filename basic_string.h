@@ -312,7 +312,7 @@ public:
 private://注意这里是私有的，对象无法访问
   iterator  buffer_;  // 储存字符串的起始位置，其实是个指针
   size_type size_;    // 大小
-  size_type cap_;     // 容量
+  size_type cap_;     // 容量，不含结尾空字符：buffer_ 总是多分配一个元素，c_str() 写入 buffer_[size_] 不会越界
 
 public:
   // 构造、复制、移动、析构函数
@@ -419,7 +419,8 @@ public:
   size_type capacity() const noexcept
   { return cap_; }
   size_type max_size() const noexcept
-  { return static_cast<size_type>(-1); }//-1的二进制表示全都是1，将其转换为size_type就能得到最大的值，这样在各种机器上都能适用
+  { return static_cast<size_type>(-1) - 1; }//-1的二进制表示全都是1，将其转换为size_type就能得到最大的值，这样在各种机器上都能适用
+                                             //再减去结尾空字符占用的一个位置
 
   void      reserve(size_type n);
   //reserve：调整string大小，使之可以容纳n个元素，如果当前容量小于n，则扩展容量至n，其他情况则不进行存储重新分配，对容量没有影响
@@ -772,10 +773,10 @@ operator=(const_pointer str)
   const size_type len = char_traits::length(str);
   if (cap_ < len)
   {
-    auto new_buffer = data_allocator::allocate(len + 1);//新申请一块内存
+    auto new_buffer = data_allocator::allocate(len + 1);//新申请一块内存，多出的一个位置留给结尾的空字符
     data_allocator::deallocate(buffer_);//销毁当前内存
     buffer_ = new_buffer;//变成新的内存地址
-    cap_ = len + 1;
+    cap_ = len;
   }
   char_traits::copy(buffer_, str, len);//内存拷贝
   size_ = len;
@@ -793,7 +794,7 @@ operator=(value_type ch)
     auto new_buffer = data_allocator::allocate(2);
     data_allocator::deallocate(buffer_);
     buffer_ = new_buffer;
-    cap_ = 2;
+    cap_ = 1;
   }
   *buffer_ = ch;
   size_ = 1;
@@ -809,8 +810,9 @@ reserve(size_type n)
   {
     THROW_LENGTH_ERROR_IF(n > max_size(), "n can not larger than max_size()"
                           "in basic_string<Char,Traits>::reserve(n)");
-    auto new_buffer = data_allocator::allocate(n);//申请一块新内存
+    auto new_buffer = data_allocator::allocate(n + 1);//申请一块新内存
     char_traits::move(new_buffer, buffer_, size_);//把内容转移过去，move是内存操作，更快
+    data_allocator::deallocate(buffer_);//释放旧内存
     buffer_ = new_buffer;//新地址
     cap_ = n;
   }
@@ -1598,9 +1600,9 @@ try_init() noexcept
 {
   try
   {
-    buffer_ = data_allocator::allocate(static_cast<size_type>(STRING_INIT_SIZE));//尝试分配32字节大小的空间
-    size_ = 0;//分配成功为什么size和cap还是0？因为调用这个函数只有是默认构造函数里面，没有任何初始化工作
-    cap_ = 0;
+    buffer_ = data_allocator::allocate(static_cast<size_type>(STRING_INIT_SIZE) + 1);//尝试分配32字节大小的空间
+    size_ = 0;
+    cap_ = static_cast<size_type>(STRING_INIT_SIZE);//记录已分配的空间，之后追加的字符不超过它时不用重新分配
   }
   catch (...)
   {
@@ -1616,9 +1618,9 @@ template <class CharType, class CharTraits>
 void basic_string<CharType, CharTraits>::
 fill_init(size_type n, value_type ch)
 {
-  const auto init_size = mystl::max(static_cast<size_type>(STRING_INIT_SIZE), n + 1);//最后一个空间用来存放\0
-  //如果申请的空间小于32字节，那么仍然申请32字节大小的空间
-  buffer_ = data_allocator::allocate(init_size);
+  const auto init_size = mystl::max(static_cast<size_type>(STRING_INIT_SIZE), n);
+  //如果申请的空间小于32字节，那么仍然申请32字节大小的空间，多申请的一个空间用来存放\0
+  buffer_ = data_allocator::allocate(init_size + 1);
   char_traits::fill(buffer_, ch, n);//调用的是20-210那些char_traits中的fill函数
   size_ = n;//size是实际容量，而cap是总容量
   cap_ = init_size;
@@ -1631,10 +1633,10 @@ void basic_string<CharType, CharTraits>::
 copy_init(Iter first, Iter last, mystl::input_iterator_tag)
 {
   size_type n = mystl::distance(first, last);
-  const auto init_size = mystl::max(static_cast<size_type>(STRING_INIT_SIZE), n + 1);
+  const auto init_size = mystl::max(static_cast<size_type>(STRING_INIT_SIZE), n);
   try
   {
-    buffer_ = data_allocator::allocate(init_size);//这里只是申请内存，有可能会有异常，所以要写到try里面
+    buffer_ = data_allocator::allocate(init_size + 1);//这里只是申请内存，有可能会有异常，所以要写到try里面
     size_ = n;//为什么这里就不是0了？因为这里初始化了，需要往内存里构造对象
     cap_ = init_size;
   }
@@ -1655,10 +1657,10 @@ void basic_string<CharType, CharTraits>::
 copy_init(Iter first, Iter last, mystl::forward_iterator_tag)//常用的是这个前向迭代器版本的
 {
   const size_type n = mystl::distance(first, last);
-  const auto init_size = mystl::max(static_cast<size_type>(STRING_INIT_SIZE), n + 1);
+  const auto init_size = mystl::max(static_cast<size_type>(STRING_INIT_SIZE), n);
   try
   {
-    buffer_ = data_allocator::allocate(init_size);
+    buffer_ = data_allocator::allocate(init_size + 1);
     size_ = n;
     cap_ = init_size;
     mystl::uninitialized_copy(first, last, buffer_);
@@ -1678,8 +1680,8 @@ void basic_string<CharType, CharTraits>::
 init_from(const_pointer src, size_type pos, size_type count)
 {//可以给一个常量形参传入非常量，就比如这里我们给const_pointer传入的是other.buffer_，只是一个普通的指针
     //从别的basic_string的内存中拷贝字符，src就是原地址，pos是从原地址的哪个字符开始拷贝，count是拷贝字符的个数
-  const auto init_size = mystl::max(static_cast<size_type>(STRING_INIT_SIZE), count + 1);
-  buffer_ = data_allocator::allocate(init_size);
+  const auto init_size = mystl::max(static_cast<size_type>(STRING_INIT_SIZE), count);
+  buffer_ = data_allocator::allocate(init_size + 1);
   //allocate返回的指针指向开始(最低的字节地址)分配的存储地址
   char_traits::copy(buffer_, src + pos, count);//从src+pos的地址开始，拷贝count个字符到buffer_这块新申请的内存上
   size_ = count;//实际大小是count个字符
@@ -1693,7 +1695,7 @@ destroy_buffer()
 {
   if (buffer_ != nullptr)
   {
-    data_allocator::deallocate(buffer_, cap_);//销毁内存空间
+    data_allocator::deallocate(buffer_, cap_ + 1);//销毁内存空间
     buffer_ = nullptr;
     size_ = 0;
     cap_ = 0;
@@ -1706,9 +1708,15 @@ typename basic_string<CharType, CharTraits>::const_pointer//返回值是一个
 basic_string<CharType, CharTraits>::
 to_raw_pointer() const
 {
+  if (buffer_ == nullptr)
+  { // 被移动后没有 buffer，返回一个空字符串
+    static const value_type empty = value_type();
+    return &empty;
+  }
   *(buffer_ + size_) = value_type();//在末尾的位置构造一个默认对象（就是字符数组末尾默认的/0），如果没有这个构造，转换成指针后，如果用指针去访问内存，那么最后一个内存
                                     //的地方由于没有构造结束符/0。那么会越界访问出错，而上层迭代器就不需要担心这个，因为封装以后保证迭代器
                                     //不会越界访问，指针没有约束就无法保证
+                                    //size_ 不超过 cap_，而分配的空间有 cap_ + 1 个元素，所以这个位置总是有效的
   return buffer_;
 }
 
@@ -1717,7 +1725,7 @@ template <class CharType, class CharTraits>
 void basic_string<CharType, CharTraits>::
 reinsert(size_type size)
 {
-  auto new_buffer = data_allocator::allocate(size);//申请新内存
+  auto new_buffer = data_allocator::allocate(size + 1);//申请新内存
   try
   {
     char_traits::move(new_buffer, buffer_, size);//尝试转移
@@ -1726,6 +1734,7 @@ reinsert(size_type size)
   {
     data_allocator::deallocate(new_buffer);//抛出任何异常都把新内存释放掉，然后结束此函数运行
   }
+  data_allocator::deallocate(buffer_);//释放旧内存
   buffer_ = new_buffer;//没有发生异常就把新地址换过去，数据已经在try里面转移了
   size_ = size;
   cap_ = size;
@@ -1869,7 +1878,7 @@ void basic_string<CharType, CharTraits>::
 reallocate(size_type need)
 {
   const auto new_cap = mystl::max(cap_ + need, cap_ + (cap_ >> 1));
-  auto new_buffer = data_allocator::allocate(new_cap);//新内存的地址
+  auto new_buffer = data_allocator::allocate(new_cap + 1);//新内存的地址
   char_traits::move(new_buffer, buffer_, size_);//转移数据
   data_allocator::deallocate(buffer_);//释放原有内存
   buffer_ = new_buffer;
@@ -1885,11 +1894,11 @@ reallocate_and_fill(iterator pos, size_type n, value_type ch)
   const auto r = pos - buffer_;
   const auto old_cap = cap_;
   const auto new_cap = mystl::max(old_cap + n, old_cap + (old_cap >> 1));//如果n小于old_cap的一半，则直接申请一半的内存
-  auto new_buffer = data_allocator::allocate(new_cap);
+  auto new_buffer = data_allocator::allocate(new_cap + 1);
   auto e1 = char_traits::move(new_buffer, buffer_, r) + r;//move把原始数据的r个元素移动到新内存，返回的是新地址的首迭代器，再加上r
   auto e2 = char_traits::fill(e1, ch, n) + n;//然后填充n个ch到新内存的末尾
   char_traits::move(e2, buffer_ + r, size_ - r);//再把原始数据剩余的元素移动到新内存
-  data_allocator::deallocate(buffer_, old_cap);//析构原内存
+  data_allocator::deallocate(buffer_, old_cap + 1);//析构原内存
   buffer_ = new_buffer;
   size_ += n;
   cap_ = new_cap;
@@ -1906,11 +1915,11 @@ reallocate_and_copy(iterator pos, const_iterator first, const_iterator last)
   const auto old_cap = cap_;
   const size_type n = mystl::distance(first, last);
   const auto new_cap = mystl::max(old_cap + n, old_cap + (old_cap >> 1));
-  auto new_buffer = data_allocator::allocate(new_cap);
+  auto new_buffer = data_allocator::allocate(new_cap + 1);
   auto e1 = char_traits::move(new_buffer, buffer_, r) + r;
   auto e2 = mystl::uninitialized_copy_n(first, n, e1) + n;
   char_traits::move(e2, buffer_ + r, size_ - r);
-  data_allocator::deallocate(buffer_, old_cap);
+  data_allocator::deallocate(buffer_, old_cap + 1);
   buffer_ = new_buffer;
   size_ += n;
   cap_ = new_cap;
@@ -2099,7 +2108,8 @@ void swap(basic_string<CharType, CharTraits>& lhs,
 template <class CharType, class CharTraits>
 struct hash<basic_string<CharType, CharTraits>>
 {
-  size_t operator()(const basic_string<CharType, CharTraits>& str)
+  typedef void is_avalanching;
+  size_t operator()(const basic_string<CharType, CharTraits>& str) const noexcept
   {
     return bitwise_hash((const unsigned char*)str.c_str(),
                         str.size() * sizeof(CharType));
@@ -0,0 +1,187 @@
+﻿#ifndef MYTINYSTL_BLOOM_FILTER_H_
+#define MYTINYSTL_BLOOM_FILTER_H_
+
+// 这个头文件包含一个模板类 bloom_filter
+// bloom_filter : 分块布隆过滤器，判断一个元素是否可能存在，不存在时可以确定，存在时有一定误判率
+
+#include <cstdint>
+
+#include "algobase.h"
+#include "functional.h"
+#include "vector.h"
+#include "util.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// 每个块的大小为 512 位，恰好是一条 cache line，同一元素的所有位都落在同一个块中，
+// 因此每次插入和查询只访问一条 cache line
+static constexpr size_t bloom_block_words = 8;
+static constexpr size_t bloom_block_bits  = bloom_block_words * 64;
+
+// 模板类 bloom_filter
+// 参数一代表数据类型，参数二代表哈希函数，缺省使用 mystl 的 hash
+template <class T, class Hash = mystl::hash<T>>
+class bloom_filter
+{
+public:
+  typedef T      key_type;
+  typedef T      value_type;
+  typedef Hash   hasher;
+  typedef size_t size_type;
+
+private:
+  // 用以下三个数据表现 bloom_filter
+  mystl::vector<uint64_t> blocks_;      // 位数组，每 bloom_block_words 个字为一块
+  size_type               hash_count_;  // 每个元素在块中设置的位数
+  hasher                  hash_;
+
+public:
+  // 构造、复制、移动函数
+
+  // 默认构造的 bloom_filter 不占用空间，也不提供任何信息，查询总是返回 true
+  bloom_filter() :hash_count_(0) {}
+
+  // n 为预计插入的元素个数，bits_per_value 为平均每个元素占用的位数，误判率随之降低，
+  // 每元素 10 位时误判率约为 1%
+  explicit bloom_filter(size_type n, size_type bits_per_value = 10,
+                        const Hash& hash = Hash())
+    :hash_(hash)
+  {
+    THROW_LENGTH_ERROR_IF(bits_per_value == 0, "bloom_filter<T>'s bits_per_value can not be zero");
+    const size_type nblocks = (n * bits_per_value + bloom_block_bits - 1) / bloom_block_bits;
+    blocks_.assign((nblocks == 0 ? 1 : nblocks) * bloom_block_words, 0);
+    // 最优的哈希次数为 bits_per_value * ln2
+    hash_count_ = (bits_per_value * 693 + 500) / 1000;
+    hash_count_ = mystl::max(static_cast<size_type>(1), mystl::min(hash_count_, static_cast<size_type>(16)));
+  }
+
+  bloom_filter(const bloom_filter&) = default;
+  bloom_filter(bloom_filter&& rhs) noexcept
+    :blocks_(mystl::move(rhs.blocks_)), hash_count_(rhs.hash_count_), hash_(rhs.hash_)
+  {
+    rhs.hash_count_ = 0;
+  }
+
+  bloom_filter& operator=(const bloom_filter&) = default;
+  bloom_filter& operator=(bloom_filter&& rhs) noexcept
+  {
+    bloom_filter tmp(mystl::move(rhs));
+    swap(tmp);
+    return *this;
+  }
+
+  // 容量相关操作
+  bool      empty()      const noexcept { return blocks_.empty(); }
+  size_type bit_count()  const noexcept { return blocks_.size() * 64; }
+  size_type hash_count() const noexcept { return hash_count_; }
+  hasher    hash_fcn()   const          { return hash_; }
+
+  // 插入与查询
+  void insert(const key_type& key)
+  { insert_hash(hash_(key)); }
+
+  bool may_contain(const key_type& key) const
+  { return may_contain_hash(hash_(key)); }
+
+  // 以下函数直接使用调用者已经求出的哈希值，hashtable 借此避免重复计算
+  void insert_hash(size_t code) noexcept;
+  bool may_contain_hash(size_t code) const noexcept;
+  void prefetch_hash(size_t code) const noexcept
+  {
+    if (!blocks_.empty())
+      MYSTL_PREFETCH(blocks_.data() + block_of(mix(code)));
+  }
+
+  // 修改容器相关操作
+
+  // 清除所有位，保留空间
+  void clear() noexcept
+  { mystl::fill(blocks_.begin(), blocks_.end(), static_cast<uint64_t>(0)); }
+
+  // 合并另一个相同大小、相同哈希次数的 bloom_filter，结果包含两者的所有元素
+  void merge(const bloom_filter& rhs)
+  {
+    THROW_LENGTH_ERROR_IF(blocks_.size() != rhs.blocks_.size() ||
+                          hash_count_ != rhs.hash_count_,
+                          "bloom_filter<T>'s merge requires the same shape");
+    for (size_type i = 0; i < blocks_.size(); ++i)
+      blocks_[i] |= rhs.blocks_[i];
+  }
+
+  void swap(bloom_filter& rhs) noexcept
+  {
+    blocks_.swap(rhs.blocks_);
+    mystl::swap(hash_count_, rhs.hash_count_);
+    mystl::swap(hash_, rhs.hash_);
+  }
+
+private:
+  // 下面用高 32 位选块、低 32 位选位，哈希值未充分混合或者不足 64 位时先打散
+  static uint64_t mix(size_t code) noexcept
+  {
+    return mix(code, m_bool_constant<is_avalanching_hash<Hash>::value && sizeof(size_t) >= 8>());
+  }
+  static uint64_t mix(size_t code, m_true_type) noexcept
+  { return static_cast<uint64_t>(code); }
+  static uint64_t mix(size_t code, m_false_type) noexcept
+  { return hash_mum(static_cast<uint64_t>(code), 0x9e3779b97f4a7c15ull); }
+
+  // 用高 32 位选择块，返回块中第一个字的下标
+  size_type block_of(uint64_t h) const noexcept
+  {
+    const uint64_t nblocks = blocks_.size() / bloom_block_words;
+    return static_cast<size_type>(((h >> 32) * nblocks) >> 32) * bloom_block_words;
+  }
+};
+
+/*****************************************************************************************/
+
+// 用低 32 位做二次哈希，生成块中的 hash_count_ 个位置
+template <class T, class Hash>
+void bloom_filter<T, Hash>::
+insert_hash(size_t code) noexcept
+{
+  if (blocks_.empty())
+    return;
+  const uint64_t h = mix(code);
+  uint64_t* block = blocks_.data() + block_of(h);
+  uint32_t a = static_cast<uint32_t>(h);
+  const uint32_t b = (a >> 16 | a << 16) | 1;
+  for (size_type i = 0; i < hash_count_; ++i, a += b)
+  {
+    const uint32_t bit = a % bloom_block_bits;
+    block[bit >> 6] |= static_cast<uint64_t>(1) << (bit & 63);
+  }
+}
+
+template <class T, class Hash>
+bool bloom_filter<T, Hash>::
+may_contain_hash(size_t code) const noexcept
+{
+  if (blocks_.empty())
+    return true;
+  const uint64_t h = mix(code);
+  const uint64_t* block = blocks_.data() + block_of(h);
+  uint32_t a = static_cast<uint32_t>(h);
+  const uint32_t b = (a >> 16 | a << 16) | 1;
+  for (size_type i = 0; i < hash_count_; ++i, a += b)
+  {
+    const uint32_t bit = a % bloom_block_bits;
+    if ((block[bit >> 6] & (static_cast<uint64_t>(1) << (bit & 63))) == 0)
+      return false;
+  }
+  return true;
+}
+
+// 重载 mystl 的 swap
+template <class T, class Hash>
+void swap(bloom_filter<T, Hash>& lhs, bloom_filter<T, Hash>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_BLOOM_FILTER_H_
+
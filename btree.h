@@ -0,0 +1,1579 @@
+﻿#ifndef MYTINYSTL_BTREE_H_
+#define MYTINYSTL_BTREE_H_
+
+// 这个头文件包含一个模板类 btree
+// btree : B 树，每个节点连续存放多个元素，作为 btree_set / btree_multiset / btree_map / btree_multimap 的底层机制
+//
+// 与 rb_tree 相比，一个节点的大小约为 256 字节（四条缓存行），存放几十个元素，
+// 树高只有 rb_tree 的几分之一，查找与遍历访问的缓存行更少，每个元素分摊的指针开销也更小
+// 节点内的查找：键值为算术类型时使用线性查找，其它类型使用二分查找
+//
+// notes:
+//
+// 插入与删除会移动节点内的元素，使所有迭代器失效
+// 元素在节点之间移动时使用移动构造，要求元素的移动构造不抛出异常
+
+#include <functional>
+#include <initializer_list>
+
+#include "functional.h"
+#include "iterator.h"
+#include "memory.h"
+#include "vector.h"
+#include "algo.h"
+#include "util.h"
+#include "type_traits.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// forward declaration
+
+template <class T> struct btree_node;
+template <class T> struct btree_internal_node;
+
+template <class T> struct btree_iterator;
+template <class T> struct btree_const_iterator;
+
+// btree value traits
+
+template <class T, bool>
+struct btree_value_traits_imp
+{
+  typedef T key_type;
+  typedef T mapped_type;
+  typedef T value_type;
+
+  template <class Ty>
+  static const key_type& get_key(const Ty& value)
+  {
+    return value;
+  }
+};
+
+template <class T>
+struct btree_value_traits_imp<T, true>
+{
+  typedef typename std::remove_cv<typename T::first_type>::type key_type;
+  typedef typename T::second_type                               mapped_type;
+  typedef T                                                     value_type;
+
+  template <class Ty>
+  static const key_type& get_key(const Ty& value)
+  {
+    return value.first;
+  }
+};
+
+template <class T>
+struct btree_value_traits : public btree_value_traits_imp<T, mystl::is_pair<T>::value>
+{
+};
+
+// btree 节点的大小
+// 节点的目标大小为 256 字节，即四条缓存行，每个节点至少存放 3 个元素
+
+template <class T>
+struct btree_node_params
+{
+  static constexpr size_t target_bytes = 256;
+  static constexpr size_t header_bytes = sizeof(void*) + 3 * sizeof(unsigned short);
+  static constexpr size_t fit_values   = (target_bytes - header_bytes) / sizeof(T);
+
+  static constexpr size_t max_values = fit_values < 3 ? 3 : (fit_values > 255 ? 255 : fit_values);
+  static constexpr size_t min_values = max_values / 2;
+};
+
+// btree 的节点设计
+// 叶子节点只存放元素，内部节点另外存放 count + 1 个子节点
+
+template <class T>
+struct btree_node
+{
+  typedef btree_node<T>*                                        node_ptr;
+  typedef btree_internal_node<T>*                               internal_ptr;
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot_type;
+
+  static constexpr size_t max_values = btree_node_params<T>::max_values;
+
+  node_ptr       parent;    // 父节点，根节点的父节点为空
+  unsigned short position;  // 在父节点中的位置
+  unsigned short count;     // 元素个数
+  unsigned short leaf;      // 是否为叶子节点
+  slot_type      slots[max_values];
+
+  T*       value(size_t i)       { return reinterpret_cast<T*>(&slots[i]); }
+  const T* value(size_t i) const { return reinterpret_cast<const T*>(&slots[i]); }
+
+  node_ptr child(size_t i) const
+  {
+    return static_cast<const btree_internal_node<T>*>(this)->children[i];
+  }
+
+  void set_child(size_t i, node_ptr c)
+  {
+    static_cast<internal_ptr>(this)->children[i] = c;
+    c->parent = this;
+    c->position = static_cast<unsigned short>(i);
+  }
+};
+
+template <class T>
+struct btree_internal_node :public btree_node<T>
+{
+  btree_node<T>* children[btree_node<T>::max_values + 1];
+};
+
+// btree 的迭代器设计
+
+template <class T>
+struct btree_iterator_base :public mystl::iterator<mystl::bidirectional_iterator_tag, T>
+{
+  typedef btree_node<T>* node_ptr;
+
+  node_ptr node;      // 指向所在的节点
+  int      position;  // 在节点中的位置
+
+  btree_iterator_base() :node(nullptr), position(0) {}
+  btree_iterator_base(node_ptr n, int pos) :node(n), position(pos) {}
+
+  // 使迭代器前进
+  void inc()
+  {
+    if (node->leaf)
+    {
+      if (++position < node->count)
+        return;
+      // 到达叶子节点的末尾，向上寻找第一个还有后继元素的祖先
+      auto save = *this;
+      while (position == node->count && node->parent != nullptr)
+      {
+        position = node->position;
+        node = node->parent;
+      }
+      if (position == node->count)  // 已经是最后一个元素
+        *this = save;
+    }
+    else
+    { // 后继为右侧子树的最小元素
+      node = node->child(position + 1);
+      while (!node->leaf)
+        node = node->child(0);
+      position = 0;
+    }
+  }
+
+  // 使迭代器后退
+  void dec()
+  {
+    if (node->leaf)
+    {
+      if (--position >= 0)
+        return;
+      auto save = *this;
+      while (position < 0 && node->parent != nullptr)
+      {
+        position = node->position - 1;
+        node = node->parent;
+      }
+      if (position < 0)  // 已经是第一个元素
+        *this = save;
+    }
+    else
+    { // 前驱为左侧子树的最大元素
+      node = node->child(position);
+      while (!node->leaf)
+        node = node->child(node->count);
+      position = node->count - 1;
+    }
+  }
+
+  bool operator==(const btree_iterator_base& rhs) const
+  { return node == rhs.node && position == rhs.position; }
+  bool operator!=(const btree_iterator_base& rhs) const
+  { return !(*this == rhs); }
+};
+
+template <class T>
+struct btree_iterator :public btree_iterator_base<T>
+{
+  typedef T                        value_type;
+  typedef T*                       pointer;
+  typedef T&                       reference;
+  typedef btree_node<T>*           node_ptr;
+
+  typedef btree_iterator<T>        iterator;
+  typedef btree_const_iterator<T>  const_iterator;
+  typedef iterator                 self;
+
+  using btree_iterator_base<T>::node;
+  using btree_iterator_base<T>::position;
+
+  // 构造函数
+  btree_iterator() {}
+  btree_iterator(node_ptr n, int pos) :btree_iterator_base<T>(n, pos) {}
+  btree_iterator(const const_iterator& rhs) :btree_iterator_base<T>(rhs.node, rhs.position) {}
+
+  // 重载操作符
+  reference operator*()  const { return *node->value(position); }
+  pointer   operator->() const { return &(operator*()); }
+
+  self& operator++()
+  {
+    this->inc();
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp(*this);
+    this->inc();
+    return tmp;
+  }
+  self& operator--()
+  {
+    this->dec();
+    return *this;
+  }
+  self operator--(int)
+  {
+    self tmp(*this);
+    this->dec();
+    return tmp;
+  }
+};
+
+template <class T>
+struct btree_const_iterator :public btree_iterator_base<T>
+{
+  typedef T                        value_type;
+  typedef const T*                 pointer;
+  typedef const T&                 reference;
+  typedef btree_node<T>*           node_ptr;
+
+  typedef btree_iterator<T>        iterator;
+  typedef btree_const_iterator<T>  const_iterator;
+  typedef const_iterator           self;
+
+  using btree_iterator_base<T>::node;
+  using btree_iterator_base<T>::position;
+
+  // 构造函数
+  btree_const_iterator() {}
+  btree_const_iterator(node_ptr n, int pos) :btree_iterator_base<T>(n, pos) {}
+  btree_const_iterator(const iterator& rhs) :btree_iterator_base<T>(rhs.node, rhs.position) {}
+
+  // 重载操作符
+  reference operator*()  const { return *node->value(position); }
+  pointer   operator->() const { return &(operator*()); }
+
+  self& operator++()
+  {
+    this->inc();
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp(*this);
+    this->inc();
+    return tmp;
+  }
+  self& operator--()
+  {
+    this->dec();
+    return *this;
+  }
+  self operator--(int)
+  {
+    self tmp(*this);
+    this->dec();
+    return tmp;
+  }
+};
+
+// 模板类 btree
+// 参数一代表数据类型，参数二代表键值比较类型
+template <class T, class Compare>
+class btree
+{
+public:
+  // btree 的嵌套型别定义
+
+  typedef btree_value_traits<T>                    value_traits;
+  typedef typename value_traits::key_type          key_type;
+  typedef typename value_traits::mapped_type       mapped_type;
+  typedef typename value_traits::value_type        value_type;
+  typedef Compare                                  key_compare;
+
+  typedef btree_node<T>                            node_type;
+  typedef btree_internal_node<T>                   internal_node_type;
+  typedef node_type*                               node_ptr;
+
+  typedef mystl::allocator<T>                      allocator_type;
+  typedef mystl::allocator<T>                      data_allocator;
+  typedef mystl::allocator<node_type>              leaf_allocator;
+  typedef mystl::allocator<internal_node_type>     internal_allocator;
+
+  typedef typename allocator_type::pointer         pointer;
+  typedef typename allocator_type::const_pointer   const_pointer;
+  typedef typename allocator_type::reference       reference;
+  typedef typename allocator_type::const_reference const_reference;
+  typedef typename allocator_type::size_type       size_type;
+  typedef typename allocator_type::difference_type difference_type;
+
+  typedef btree_iterator<T>                        iterator;
+  typedef btree_const_iterator<T>                  const_iterator;
+  typedef mystl::reverse_iterator<iterator>        reverse_iterator;
+  typedef mystl::reverse_iterator<const_iterator>  const_reverse_iterator;
+
+  static constexpr size_type max_node_values = btree_node_params<T>::max_values;
+  static constexpr size_type min_node_values = btree_node_params<T>::min_values;
+
+  allocator_type get_allocator() const { return allocator_type(); }
+  key_compare    key_comp()      const { return key_comp_; }
+
+private:
+  // 用以下数据来表现 btree
+  node_ptr    root_;        // 根节点，空树时为空
+  node_ptr    leftmost_;    // 最左侧的叶子节点
+  node_ptr    rightmost_;   // 最右侧的叶子节点
+  size_type   node_count_;  // 元素个数
+  key_compare key_comp_;    // 键值的比较准则
+
+public:
+  // 构造、复制、析构函数
+  btree() :root_(nullptr), leftmost_(nullptr), rightmost_(nullptr), node_count_(0), key_comp_() {}
+
+  btree(const btree& rhs);
+  btree(btree&& rhs) noexcept;
+
+  btree& operator=(const btree& rhs);
+  btree& operator=(btree&& rhs);
+
+  ~btree() { clear(); }
+
+public:
+  // 迭代器相关操作
+
+  iterator               begin()         noexcept
+  { return iterator(leftmost_, 0); }
+  const_iterator         begin()   const noexcept
+  { return const_iterator(leftmost_, 0); }
+  iterator               end()           noexcept
+  { return iterator(rightmost_, end_position()); }
+  const_iterator         end()     const noexcept
+  { return const_iterator(rightmost_, end_position()); }
+
+  reverse_iterator       rbegin()        noexcept
+  { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin()  const noexcept
+  { return const_reverse_iterator(end()); }
+  reverse_iterator       rend()          noexcept
+  { return reverse_iterator(begin()); }
+  const_reverse_iterator rend()    const noexcept
+  { return const_reverse_iterator(begin()); }
+
+  const_iterator         cbegin()  const noexcept
+  { return begin(); }
+  const_iterator         cend()    const noexcept
+  { return end(); }
+  const_reverse_iterator crbegin() const noexcept
+  { return rbegin(); }
+  const_reverse_iterator crend()   const noexcept
+  { return rend(); }
+
+  // 容量相关操作
+
+  bool      empty()    const noexcept { return node_count_ == 0; }
+  size_type size()     const noexcept { return node_count_; }
+  size_type max_size() const noexcept { return static_cast<size_type>(-1) / sizeof(T); }
+
+  // 插入删除相关操作
+
+  // emplace
+
+  template <class ...Args>
+  iterator  emplace_multi(Args&& ...args);
+
+  template <class ...Args>
+  mystl::pair<iterator, bool> emplace_unique(Args&& ...args);
+
+  template <class ...Args>
+  iterator  emplace_multi_use_hint(const_iterator hint, Args&& ...args);
+
+  template <class ...Args>
+  iterator  emplace_unique_use_hint(const_iterator hint, Args&& ...args);
+
+  // 键值不存在时才构造元素，仅用于 map 类容器
+  template <class K, class ...Args>
+  mystl::pair<iterator, bool> try_emplace_unique(K&& key, Args&& ...args);
+
+  // 键值存在时对实值赋值，否则插入新元素，仅用于 map 类容器
+  template <class K, class M>
+  mystl::pair<iterator, bool> insert_or_assign_unique(K&& key, M&& obj);
+
+  // insert
+
+  iterator  insert_multi(const value_type& value)
+  { return emplace_multi(value); }
+  iterator  insert_multi(value_type&& value)
+  { return emplace_multi(mystl::move(value)); }
+
+  iterator  insert_multi(const_iterator hint, const value_type& value)
+  { return emplace_multi_use_hint(hint, value); }
+  iterator  insert_multi(const_iterator hint, value_type&& value)
+  { return emplace_multi_use_hint(hint, mystl::move(value)); }
+
+  mystl::pair<iterator, bool> insert_unique(const value_type& value)
+  { return emplace_unique(value); }
+  mystl::pair<iterator, bool> insert_unique(value_type&& value)
+  { return emplace_unique(mystl::move(value)); }
+
+  iterator  insert_unique(const_iterator hint, const value_type& value)
+  { return emplace_unique_use_hint(hint, value); }
+  iterator  insert_unique(const_iterator hint, value_type&& value)
+  { return emplace_unique_use_hint(hint, mystl::move(value)); }
+
+  // 批量插入，排序后与已有元素归并，再按顺序装入节点，节点几乎是满的
+  template <class InputIterator>
+  void      insert_multi(InputIterator first, InputIterator last)
+  { bulk_insert(first, last, false, false); }
+  template <class InputIterator>
+  void      insert_multi(mystl::sorted_equivalent_tag, InputIterator first, InputIterator last)
+  { bulk_insert(first, last, false, true); }
+
+  template <class InputIterator>
+  void      insert_unique(InputIterator first, InputIterator last)
+  { bulk_insert(first, last, true, false); }
+  template <class InputIterator>
+  void      insert_unique(mystl::sorted_unique_tag, InputIterator first, InputIterator last)
+  { bulk_insert(first, last, true, true); }
+
+  // erase
+
+  iterator  erase(const_iterator position);
+  size_type erase_multi(const key_type& key);
+  size_type erase_unique(const key_type& key);
+  iterator  erase(const_iterator first, const_iterator last);
+
+  void      clear();
+
+  // btree 相关操作
+
+  iterator       find(const key_type& key);
+  const_iterator find(const key_type& key) const;
+
+  size_type      count_multi(const key_type& key) const
+  {
+    auto p = equal_range_multi(key);
+    return static_cast<size_type>(mystl::distance(p.first, p.second));
+  }
+  size_type      count_unique(const key_type& key) const
+  {
+    return find(key) != end() ? 1 : 0;
+  }
+
+  iterator       lower_bound(const key_type& key)
+  { return iterator(lower_bound_pos(key)); }
+  const_iterator lower_bound(const key_type& key) const
+  { return lower_bound_pos(key); }
+
+  iterator       upper_bound(const key_type& key)
+  { return iterator(upper_bound_pos(key)); }
+  const_iterator upper_bound(const key_type& key) const
+  { return upper_bound_pos(key); }
+
+  mystl::pair<iterator, iterator>
+  equal_range_multi(const key_type& key)
+  { return mystl::pair<iterator, iterator>(lower_bound(key), upper_bound(key)); }
+  mystl::pair<const_iterator, const_iterator>
+  equal_range_multi(const key_type& key) const
+  { return mystl::pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key)); }
+
+  mystl::pair<iterator, iterator>
+  equal_range_unique(const key_type& key)
+  {
+    iterator it = find(key);
+    auto next = it;
+    return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+  }
+  mystl::pair<const_iterator, const_iterator>
+  equal_range_unique(const key_type& key) const
+  {
+    const_iterator it = find(key);
+    auto next = it;
+    return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+  }
+
+  void      swap(btree& rhs) noexcept;
+
+private:
+  int       end_position() const
+  { return rightmost_ == nullptr ? 0 : rightmost_->count; }
+
+  static const key_type& key_at(node_ptr node, size_type i)
+  { return value_traits::get_key(*node->value(i)); }
+
+  // 从 emplace 的参数中取得键值
+  template <class Arg>
+  static const key_type& extract_key(const Arg& arg)
+  { return value_traits::get_key(arg); }
+  template <class Arg1, class Arg2>
+  static const key_type& extract_key(const Arg1& key, const Arg2&)
+  { return key; }
+
+  // node related
+  node_ptr  create_leaf();
+  node_ptr  create_internal();
+  void      destroy_node(node_ptr node);
+  void      destroy_subtree(node_ptr node);
+
+  template <class ...Args>
+  void      node_insert_value(node_ptr node, size_type i, Args&& ...args);
+  void      node_remove_value(node_ptr node, size_type i);
+  void      move_value(node_ptr dst, size_type di, node_ptr src, size_type si);
+
+  // 节点内的查找
+  size_type lower_bound_in(node_ptr node, const key_type& key) const
+  { return lower_bound_in(node, key, mystl::m_bool_constant<std::is_arithmetic<key_type>::value>()); }
+  size_type upper_bound_in(node_ptr node, const key_type& key) const
+  { return upper_bound_in(node, key, mystl::m_bool_constant<std::is_arithmetic<key_type>::value>()); }
+  size_type lower_bound_in(node_ptr node, const key_type& key, mystl::m_true_type) const;
+  size_type lower_bound_in(node_ptr node, const key_type& key, mystl::m_false_type) const;
+  size_type upper_bound_in(node_ptr node, const key_type& key, mystl::m_true_type) const;
+  size_type upper_bound_in(node_ptr node, const key_type& key, mystl::m_false_type) const;
+
+  const_iterator lower_bound_pos(const key_type& key) const;
+  const_iterator upper_bound_pos(const key_type& key) const;
+
+  // insert
+  mystl::pair<iterator, bool> get_insert_unique_pos(const key_type& key);
+  iterator  get_insert_multi_pos(const key_type& key);
+  iterator  get_insert_hint_pos(const_iterator hint);
+  iterator  insert_value_at(iterator pos, value_type&& value);
+  void      split_node(node_ptr& node, size_type& pos);
+
+  template <class ...Args>
+  mystl::pair<iterator, bool> emplace_unique_key(mystl::m_true_type, Args&& ...args);
+  template <class ...Args>
+  mystl::pair<iterator, bool> emplace_unique_key(mystl::m_false_type, Args&& ...args);
+
+  // erase
+  iterator  rebalance_after_erase(iterator it);
+  bool      merge_or_rebalance(iterator& it);
+  void      merge_nodes(node_ptr left, node_ptr right);
+  void      rebalance_right_to_left(node_ptr node, node_ptr right, size_type to_move);
+  void      rebalance_left_to_right(node_ptr left, node_ptr node, size_type to_move);
+  void      try_shrink();
+
+  // bulk insert
+  template <class InputIterator>
+  void      bulk_insert(InputIterator first, InputIterator last, bool unique, bool sorted);
+};
+
+/*****************************************************************************************/
+
+// 复制构造函数，按顺序装入节点
+template <class T, class Compare>
+btree<T, Compare>::
+btree(const btree& rhs)
+  :root_(nullptr), leftmost_(nullptr), rightmost_(nullptr), node_count_(0), key_comp_(rhs.key_comp_)
+{
+  try
+  {
+    for (auto it = rhs.begin(); it != rhs.end(); ++it)
+      insert_value_at(end(), value_type(*it));
+  }
+  catch (...)
+  {
+    clear();
+    throw;
+  }
+}
+
+// 移动构造函数
+template <class T, class Compare>
+btree<T, Compare>::
+btree(btree&& rhs) noexcept
+  :root_(rhs.root_), leftmost_(rhs.leftmost_), rightmost_(rhs.rightmost_),
+   node_count_(rhs.node_count_), key_comp_(rhs.key_comp_)
+{
+  rhs.root_ = rhs.leftmost_ = rhs.rightmost_ = nullptr;
+  rhs.node_count_ = 0;
+}
+
+// 复制赋值操作符
+template <class T, class Compare>
+btree<T, Compare>&
+btree<T, Compare>::
+operator=(const btree& rhs)
+{
+  if (this != &rhs)
+  {
+    btree tmp(rhs);
+    swap(tmp);
+  }
+  return *this;
+}
+
+// 移动赋值操作符
+template <class T, class Compare>
+btree<T, Compare>&
+btree<T, Compare>::
+operator=(btree&& rhs)
+{
+  if (this != &rhs)
+  {
+    clear();
+    root_ = rhs.root_;
+    leftmost_ = rhs.leftmost_;
+    rightmost_ = rhs.rightmost_;
+    node_count_ = rhs.node_count_;
+    key_comp_ = mystl::move(rhs.key_comp_);
+    rhs.root_ = rhs.leftmost_ = rhs.rightmost_ = nullptr;
+    rhs.node_count_ = 0;
+  }
+  return *this;
+}
+
+// 就地插入元素，键值允许重复
+template <class T, class Compare>
+template <class ...Args>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+emplace_multi(Args&& ...args)
+{
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "btree<T, Comp>'s size too big");
+  value_type value(mystl::forward<Args>(args)...);
+  return insert_value_at(get_insert_multi_pos(value_traits::get_key(value)), mystl::move(value));
+}
+
+// 就地插入元素，键值不允许重复
+template <class T, class Compare>
+template <class ...Args>
+mystl::pair<typename btree<T, Compare>::iterator, bool>
+btree<T, Compare>::
+emplace_unique(Args&& ...args)
+{
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "btree<T, Comp>'s size too big");
+  return emplace_unique_key(mystl::can_extract_key<key_type, value_type, Args...>{},
+                            mystl::forward<Args>(args)...);
+}
+
+// emplace_unique_key 函数
+// 能够直接从参数中取得键值时，先查找插入位置，键值已经存在时不会构造元素
+template <class T, class Compare>
+template <class ...Args>
+mystl::pair<typename btree<T, Compare>::iterator, bool>
+btree<T, Compare>::
+emplace_unique_key(mystl::m_true_type, Args&& ...args)
+{
+  auto res = get_insert_unique_pos(extract_key(args...));
+  if (!res.second)
+    return res;
+  return mystl::make_pair(insert_value_at(res.first, value_type(mystl::forward<Args>(args)...)), true);
+}
+
+template <class T, class Compare>
+template <class ...Args>
+mystl::pair<typename btree<T, Compare>::iterator, bool>
+btree<T, Compare>::
+emplace_unique_key(mystl::m_false_type, Args&& ...args)
+{
+  value_type value(mystl::forward<Args>(args)...);
+  auto res = get_insert_unique_pos(value_traits::get_key(value));
+  if (!res.second)
+    return res;
+  return mystl::make_pair(insert_value_at(res.first, mystl::move(value)), true);
+}
+
+// 就地插入元素，键值允许重复，当 hint 位置正确时可以省去查找
+template <class T, class Compare>
+template <class ...Args>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+emplace_multi_use_hint(const_iterator hint, Args&& ...args)
+{
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "btree<T, Comp>'s size too big");
+  value_type value(mystl::forward<Args>(args)...);
+  const auto& key = value_traits::get_key(value);
+  if (node_count_ != 0)
+  {
+    auto prev = hint;
+    if ((hint == begin() || !key_comp_(key, value_traits::get_key(*--prev))) &&
+        (hint == end() || !key_comp_(value_traits::get_key(*hint), key)))
+    { // hint 位置正确
+      return insert_value_at(get_insert_hint_pos(hint), mystl::move(value));
+    }
+  }
+  return insert_value_at(get_insert_multi_pos(key), mystl::move(value));
+}
+
+// 就地插入元素，键值不允许重复，当 hint 位置正确时可以省去查找
+template <class T, class Compare>
+template <class ...Args>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+emplace_unique_use_hint(const_iterator hint, Args&& ...args)
+{
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "btree<T, Comp>'s size too big");
+  value_type value(mystl::forward<Args>(args)...);
+  const auto& key = value_traits::get_key(value);
+  if (node_count_ != 0)
+  {
+    auto prev = hint;
+    if ((hint == begin() || key_comp_(value_traits::get_key(*--prev), key)) &&
+        (hint == end() || key_comp_(key, value_traits::get_key(*hint))))
+    { // hint 位置正确
+      return insert_value_at(get_insert_hint_pos(hint), mystl::move(value));
+    }
+  }
+  auto res = get_insert_unique_pos(key);
+  if (!res.second)
+    return res.first;
+  return insert_value_at(res.first, mystl::move(value));
+}
+
+// 键值不存在时，以 key 和由 args 构造的实值插入新元素，否则什么也不做
+template <class T, class Compare>
+template <class K, class ...Args>
+mystl::pair<typename btree<T, Compare>::iterator, bool>
+btree<T, Compare>::
+try_emplace_unique(K&& key, Args&& ...args)
+{
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "btree<T, Comp>'s size too big");
+  auto res = get_insert_unique_pos(key);
+  if (!res.second)
+    return res;
+  return mystl::make_pair(insert_value_at(res.first, value_type(mystl::piecewise_second,
+                          mystl::forward<K>(key), mystl::forward<Args>(args)...)), true);
+}
+
+// 键值存在时，把 obj 赋值给它的实值，否则以 key 和 obj 插入新元素
+template <class T, class Compare>
+template <class K, class M>
+mystl::pair<typename btree<T, Compare>::iterator, bool>
+btree<T, Compare>::
+insert_or_assign_unique(K&& key, M&& obj)
+{
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "btree<T, Comp>'s size too big");
+  auto res = get_insert_unique_pos(key);
+  if (!res.second)
+  {
+    res.first->second = mystl::forward<M>(obj);
+    return res;
+  }
+  return mystl::make_pair(insert_value_at(res.first, value_type(mystl::forward<K>(key),
+                          mystl::forward<M>(obj))), true);
+}
+
+// 删除 position 位置的元素，返回指向下一个元素的迭代器
+// 删除内部节点的元素时，用它在叶子节点中的前驱代替它，再从叶子节点删除前驱
+template <class T, class Compare>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+erase(const_iterator position)
+{
+  MYSTL_DEBUG(position != end());
+  iterator it(position);
+  const bool internal_delete = !it.node->leaf;
+  if (internal_delete)
+  {
+    iterator internal_it = it;
+    --it;
+    data_allocator::destroy(internal_it.node->value(internal_it.position));
+    data_allocator::construct(internal_it.node->value(internal_it.position),
+                              mystl::move(*it));
+  }
+  node_remove_value(it.node, it.position);
+  --node_count_;
+  // 此时 it 指向被删除元素在叶子节点中的后继位置
+  iterator res = rebalance_after_erase(it);
+  // 从内部节点删除时，res 指向移动上去的前驱，还要再前进一步
+  if (internal_delete)
+    ++res;
+  return res;
+}
+
+// 删除键值等于 key 的元素，返回删除的个数
+template <class T, class Compare>
+typename btree<T, Compare>::size_type
+btree<T, Compare>::
+erase_multi(const key_type& key)
+{
+  auto p = equal_range_multi(key);
+  size_type n = mystl::distance(p.first, p.second);
+  iterator it = p.first;
+  for (size_type i = 0; i < n; ++i)
+    it = erase(it);
+  return n;
+}
+
+// 删除键值等于 key 的元素，返回删除的个数
+template <class T, class Compare>
+typename btree<T, Compare>::size_type
+btree<T, Compare>::
+erase_unique(const key_type& key)
+{
+  auto it = find(key);
+  if (it != end())
+  {
+    erase(it);
+    return 1;
+  }
+  return 0;
+}
+
+// 删除[first, last)区间内的元素
+// 删除会移动元素，last 会失效，因此先计算需要删除的个数
+template <class T, class Compare>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+erase(const_iterator first, const_iterator last)
+{
+  if (first == begin() && last == end())
+  {
+    clear();
+    return end();
+  }
+  size_type n = mystl::distance(first, last);
+  iterator it(first);
+  for (size_type i = 0; i < n; ++i)
+    it = erase(it);
+  return it;
+}
+
+// 清空 btree
+template <class T, class Compare>
+void btree<T, Compare>::
+clear()
+{
+  if (root_ != nullptr)
+  {
+    destroy_subtree(root_);
+    root_ = leftmost_ = rightmost_ = nullptr;
+    node_count_ = 0;
+  }
+}
+
+// 查找键值为 key 的元素，返回指向它的迭代器
+template <class T, class Compare>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+find(const key_type& key)
+{
+  iterator it = lower_bound(key);
+  return (it == end() || key_comp_(key, value_traits::get_key(*it))) ? end() : it;
+}
+
+template <class T, class Compare>
+typename btree<T, Compare>::const_iterator
+btree<T, Compare>::
+find(const key_type& key) const
+{
+  const_iterator it = lower_bound(key);
+  return (it == end() || key_comp_(key, value_traits::get_key(*it))) ? end() : it;
+}
+
+// 交换 btree
+template <class T, class Compare>
+void btree<T, Compare>::
+swap(btree& rhs) noexcept
+{
+  if (this != &rhs)
+  {
+    mystl::swap(root_, rhs.root_);
+    mystl::swap(leftmost_, rhs.leftmost_);
+    mystl::swap(rightmost_, rhs.rightmost_);
+    mystl::swap(node_count_, rhs.node_count_);
+    mystl::swap(key_comp_, rhs.key_comp_);
+  }
+}
+
+/*****************************************************************************************/
+// helper function
+
+// 创建一个空的叶子节点
+template <class T, class Compare>
+typename btree<T, Compare>::node_ptr
+btree<T, Compare>::
+create_leaf()
+{
+  node_ptr node = leaf_allocator::allocate(1);
+  node->parent = nullptr;
+  node->position = 0;
+  node->count = 0;
+  node->leaf = 1;
+  return node;
+}
+
+// 创建一个空的内部节点
+template <class T, class Compare>
+typename btree<T, Compare>::node_ptr
+btree<T, Compare>::
+create_internal()
+{
+  node_ptr node = internal_allocator::allocate(1);
+  node->parent = nullptr;
+  node->position = 0;
+  node->count = 0;
+  node->leaf = 0;
+  return node;
+}
+
+// 释放一个节点，节点中的元素需要已经销毁或移走
+template <class T, class Compare>
+void btree<T, Compare>::
+destroy_node(node_ptr node)
+{
+  if (node->leaf)
+    leaf_allocator::deallocate(node);
+  else
+    internal_allocator::deallocate(static_cast<internal_node_type*>(node));
+}
+
+// 销毁以 node 为根的子树
+template <class T, class Compare>
+void btree<T, Compare>::
+destroy_subtree(node_ptr node)
+{
+  if (!node->leaf)
+  {
+    for (size_type i = 0; i <= node->count; ++i)
+      destroy_subtree(node->child(i));
+  }
+  data_allocator::destroy(node->value(0), node->value(0) + node->count);
+  destroy_node(node);
+}
+
+// 把 src 的第 si 个元素移动到 dst 的第 di 个空位上
+template <class T, class Compare>
+void btree<T, Compare>::
+move_value(node_ptr dst, size_type di, node_ptr src, size_type si)
+{
+  data_allocator::construct(dst->value(di), mystl::move(*src->value(si)));
+  data_allocator::destroy(src->value(si));
+}
+
+// 在节点的第 i 个位置构造元素，节点必须还有空位
+// 内部节点的第 i + 1 个子节点之后的子节点同时后移，由调用者设置新的第 i + 1 个子节点
+template <class T, class Compare>
+template <class ...Args>
+void btree<T, Compare>::
+node_insert_value(node_ptr node, size_type i, Args&& ...args)
+{
+  MYSTL_DEBUG(node->count < max_node_values);
+  for (size_type j = node->count; j > i; --j)
+    move_value(node, j, node, j - 1);
+  try
+  {
+    data_allocator::construct(node->value(i), mystl::forward<Args>(args)...);
+  }
+  catch (...)
+  {
+    for (size_type j = i; j < node->count; ++j)
+      move_value(node, j, node, j + 1);
+    throw;
+  }
+  if (!node->leaf)
+  {
+    for (size_type j = node->count + 1; j > i + 1; --j)
+      node->set_child(j, node->child(j - 1));
+  }
+  ++node->count;
+}
+
+// 删除节点的第 i 个元素，内部节点同时删除第 i + 1 个子节点
+template <class T, class Compare>
+void btree<T, Compare>::
+node_remove_value(node_ptr node, size_type i)
+{
+  data_allocator::destroy(node->value(i));
+  for (size_type j = i + 1; j < node->count; ++j)
+    move_value(node, j - 1, node, j);
+  if (!node->leaf)
+  {
+    for (size_type j = i + 2; j <= node->count; ++j)
+      node->set_child(j - 1, node->child(j));
+  }
+  --node->count;
+}
+
+// 节点内的线性查找，适用于比较代价很小的算术类型
+template <class T, class Compare>
+typename btree<T, Compare>::size_type
+btree<T, Compare>::
+lower_bound_in(node_ptr node, const key_type& key, mystl::m_true_type) const
+{
+  size_type i = 0;
+  const size_type n = node->count;
+  while (i < n && key_comp_(key_at(node, i), key))
+    ++i;
+  return i;
+}
+
+// 节点内的二分查找
+template <class T, class Compare>
+typename btree<T, Compare>::size_type
+btree<T, Compare>::
+lower_bound_in(node_ptr node, const key_type& key, mystl::m_false_type) const
+{
+  size_type first = 0;
+  size_type len = node->count;
+  while (len > 0)
+  {
+    const size_type half = len >> 1;
+    if (key_comp_(key_at(node, first + half), key))
+    {
+      first += half + 1;
+      len -= half + 1;
+    }
+    else
+    {
+      len = half;
+    }
+  }
+  return first;
+}
+
+template <class T, class Compare>
+typename btree<T, Compare>::size_type
+btree<T, Compare>::
+upper_bound_in(node_ptr node, const key_type& key, mystl::m_true_type) const
+{
+  size_type i = 0;
+  const size_type n = node->count;
+  while (i < n && !key_comp_(key, key_at(node, i)))
+    ++i;
+  return i;
+}
+
+template <class T, class Compare>
+typename btree<T, Compare>::size_type
+btree<T, Compare>::
+upper_bound_in(node_ptr node, const key_type& key, mystl::m_false_type) const
+{
+  size_type first = 0;
+  size_type len = node->count;
+  while (len > 0)
+  {
+    const size_type half = len >> 1;
+    if (!key_comp_(key, key_at(node, first + half)))
+    {
+      first += half + 1;
+      len -= half + 1;
+    }
+    else
+    {
+      len = half;
+    }
+  }
+  return first;
+}
+
+// 从根节点向下查找第一个不小于 key 的元素，最后一个找到的候选位置就是答案
+template <class T, class Compare>
+typename btree<T, Compare>::const_iterator
+btree<T, Compare>::
+lower_bound_pos(const key_type& key) const
+{
+  const_iterator res = end();
+  node_ptr node = root_;
+  while (node != nullptr)
+  {
+    const size_type pos = lower_bound_in(node, key);
+    if (pos < node->count)
+      res = const_iterator(node, static_cast<int>(pos));
+    if (node->leaf)
+      break;
+    node = node->child(pos);
+  }
+  return res;
+}
+
+// 从根节点向下查找第一个大于 key 的元素
+template <class T, class Compare>
+typename btree<T, Compare>::const_iterator
+btree<T, Compare>::
+upper_bound_pos(const key_type& key) const
+{
+  const_iterator res = end();
+  node_ptr node = root_;
+  while (node != nullptr)
+  {
+    const size_type pos = upper_bound_in(node, key);
+    if (pos < node->count)
+      res = const_iterator(node, static_cast<int>(pos));
+    if (node->leaf)
+      break;
+    node = node->child(pos);
+  }
+  return res;
+}
+
+// 找到键值不重复时的插入位置，插入位置总是在叶子节点中
+// 返回一个 pair，第二个值为 false 时第一个值指向键值相等的元素
+template <class T, class Compare>
+mystl::pair<typename btree<T, Compare>::iterator, bool>
+btree<T, Compare>::
+get_insert_unique_pos(const key_type& key)
+{
+  node_ptr node = root_;
+  size_type pos = 0;
+  while (node != nullptr)
+  {
+    pos = lower_bound_in(node, key);
+    if (pos < node->count && !key_comp_(key, key_at(node, pos)))
+      return mystl::make_pair(iterator(node, static_cast<int>(pos)), false);
+    if (node->leaf)
+      break;
+    node = node->child(pos);
+  }
+  return mystl::make_pair(iterator(node, static_cast<int>(pos)), true);
+}
+
+// 找到键值允许重复时的插入位置，插入到键值相等的元素之后
+template <class T, class Compare>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+get_insert_multi_pos(const key_type& key)
+{
+  node_ptr node = root_;
+  size_type pos = 0;
+  while (node != nullptr)
+  {
+    pos = upper_bound_in(node, key);
+    if (node->leaf)
+      break;
+    node = node->child(pos);
+  }
+  return iterator(node, static_cast<int>(pos));
+}
+
+// 把 hint 之前的位置转换为叶子节点中的插入位置
+// hint 位于内部节点时，插入到它的前驱（一定在叶子节点中）之后
+template <class T, class Compare>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+get_insert_hint_pos(const_iterator hint)
+{
+  iterator it(hint);
+  if (!it.node->leaf)
+  {
+    --it;
+    ++it.position;
+  }
+  return it;
+}
+
+// 在叶子节点的 pos 位置插入元素，节点已满时先分裂
+template <class T, class Compare>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+insert_value_at(iterator pos, value_type&& value)
+{
+  node_ptr node = pos.node;
+  size_type i = static_cast<size_type>(pos.position);
+  if (root_ == nullptr)
+  {
+    root_ = leftmost_ = rightmost_ = node = create_leaf();
+    i = 0;
+  }
+  else if (node->count == max_node_values)
+  {
+    split_node(node, i);
+  }
+  node_insert_value(node, i, mystl::move(value));
+  ++node_count_;
+  return iterator(node, static_cast<int>(i));
+}
+
+// 分裂已满的节点 node，使第 pos 个位置可以插入新的元素，并更新 node 与 pos 为实际的插入位置
+// 在末尾插入时右侧的新节点为空，在开头插入时左侧只留下待插入的位置，
+// 使顺序插入时节点几乎是满的
+template <class T, class Compare>
+void btree<T, Compare>::
+split_node(node_ptr& node, size_type& pos)
+{
+  node_ptr parent = node->parent;
+  if (parent == nullptr)
+  { // 分裂根节点，树长高一层
+    parent = create_internal();
+    parent->set_child(0, node);
+    root_ = parent;
+  }
+  else if (parent->count == max_node_values)
+  { // 父节点也满了，先分裂父节点
+    size_type parent_pos = node->position;
+    split_node(parent, parent_pos);
+    parent = node->parent;
+  }
+  node_ptr dest = node->leaf ? create_leaf() : create_internal();
+
+  size_type to_move;
+  if (pos == 0)
+    to_move = node->count - 1;
+  else if (pos == max_node_values)
+    to_move = 0;
+  else
+    to_move = node->count / 2;
+  const size_type left = node->count - to_move;
+
+  // 把后 to_move 个元素与对应的子节点移动到 dest
+  for (size_type i = 0; i < to_move; ++i)
+    move_value(dest, i, node, left + i);
+  if (!node->leaf)
+  {
+    for (size_type i = 0; i <= to_move; ++i)
+      dest->set_child(i, node->child(left + i));
+  }
+  dest->count = static_cast<unsigned short>(to_move);
+  node->count = static_cast<unsigned short>(left - 1);
+
+  // 左侧的最后一个元素上移到父节点，作为两个节点的分隔
+  const size_type index = node->position;
+  node_insert_value(parent, index, mystl::move(*node->value(left - 1)));
+  data_allocator::destroy(node->value(left - 1));
+  parent->set_child(index + 1, dest);
+  if (rightmost_ == node)
+    rightmost_ = dest;
+
+  if (pos > node->count)
+  {
+    pos -= node->count + 1;
+    node = dest;
+  }
+}
+
+// 删除后自下而上地合并或平衡元素过少的节点，返回删除位置的下一个元素
+template <class T, class Compare>
+typename btree<T, Compare>::iterator
+btree<T, Compare>::
+rebalance_after_erase(iterator it)
+{
+  iterator res = it;
+  bool first_iteration = true;
+  while (true)
+  {
+    if (it.node == root_)
+    {
+      try_shrink();
+      if (empty())
+        return end();
+      break;
+    }
+    if (it.node->count >= min_node_values)
+      break;
+    const bool merged = merge_or_rebalance(it);
+    // 第一轮调整可能移动了 res 指向的元素
+    if (first_iteration)
+    {
+      res = it;
+      first_iteration = false;
+    }
+    if (!merged)
+      break;
+    it.position = it.node->position;
+    it.node = it.node->parent;
+  }
+  // 指向节点末尾时，前进到下一个元素
+  if (res.position == res.node->count)
+  {
+    res.position = res.node->count - 1;
+    ++res;
+  }
+  return res;
+}
+
+// 与相邻节点合并，不能合并时从相邻节点借入元素，返回是否发生了合并
+template <class T, class Compare>
+bool btree<T, Compare>::
+merge_or_rebalance(iterator& it)
+{
+  node_ptr node = it.node;
+  node_ptr parent = node->parent;
+  if (node->position > 0)
+  { // 尝试与左侧节点合并
+    node_ptr left = parent->child(node->position - 1);
+    if (static_cast<size_type>(1 + left->count + node->count) <= max_node_values)
+    {
+      it.position += 1 + left->count;
+      merge_nodes(left, node);
+      it.node = left;
+      return true;
+    }
+  }
+  if (node->position < parent->count)
+  {
+    node_ptr right = parent->child(node->position + 1);
+    if (static_cast<size_type>(1 + node->count + right->count) <= max_node_values)
+    { // 与右侧节点合并
+      merge_nodes(node, right);
+      return true;
+    }
+    if (right->count > min_node_values)
+    { // 从右侧节点借入元素
+      size_type to_move = (right->count - node->count) / 2;
+      to_move = mystl::min(to_move, static_cast<size_type>(right->count - 1));
+      rebalance_right_to_left(node, right, to_move);
+      return false;
+    }
+  }
+  if (node->position > 0)
+  {
+    node_ptr left = parent->child(node->position - 1);
+    if (left->count > min_node_values)
+    { // 从左侧节点借入元素
+      size_type to_move = (left->count - node->count) / 2;
+      to_move = mystl::min(to_move, static_cast<size_type>(left->count - 1));
+      rebalance_left_to_right(left, node, to_move);
+      it.position += static_cast<int>(to_move);
+      return false;
+    }
+  }
+  return false;
+}
+
+// 把 right 与父节点中的分隔元素并入 left，并释放 right
+template <class T, class Compare>
+void btree<T, Compare>::
+merge_nodes(node_ptr left, node_ptr right)
+{
+  node_ptr parent = left->parent;
+  const size_type index = left->position;
+  const size_type n = left->count;
+  data_allocator::construct(left->value(n), mystl::move(*parent->value(index)));
+  for (size_type i = 0; i < right->count; ++i)
+    move_value(left, n + 1 + i, right, i);
+  if (!left->leaf)
+  {
+    for (size_type i = 0; i <= right->count; ++i)
+      left->set_child(n + 1 + i, right->child(i));
+  }
+  left->count = static_cast<unsigned short>(n + 1 + right->count);
+  right->count = 0;
+  if (rightmost_ == right)
+    rightmost_ = left;
+  // 删除父节点中的分隔元素以及指向 right 的子节点指针
+  node_remove_value(parent, index);
+  destroy_node(right);
+}
+
+// 把 right 的前 to_move 个元素经过父节点移动到 node 的末尾
+template <class T, class Compare>
+void btree<T, Compare>::
+rebalance_right_to_left(node_ptr node, node_ptr right, size_type to_move)
+{
+  node_ptr parent = node->parent;
+  const size_type index = node->position;
+  const size_type n = node->count;
+  move_value(node, n, parent, index);
+  for (size_type i = 0; i + 1 < to_move; ++i)
+    move_value(node, n + 1 + i, right, i);
+  move_value(parent, index, right, to_move - 1);
+  for (size_type i = to_move; i < right->count; ++i)
+    move_value(right, i - to_move, right, i);
+  if (!node->leaf)
+  {
+    for (size_type i = 0; i < to_move; ++i)
+      node->set_child(n + 1 + i, right->child(i));
+    for (size_type i = to_move; i <= right->count; ++i)
+      right->set_child(i - to_move, right->child(i));
+  }
+  node->count = static_cast<unsigned short>(n + to_move);
+  right->count = static_cast<unsigned short>(right->count - to_move);
+}
+
+// 把 left 的后 to_move 个元素经过父节点移动到 node 的开头
+template <class T, class Compare>
+void btree<T, Compare>::
+rebalance_left_to_right(node_ptr left, node_ptr node, size_type to_move)
+{
+  node_ptr parent = node->parent;
+  const size_type index = left->position;
+  const size_type lc = left->count;
+  for (size_type i = node->count; i > 0; --i)
+    move_value(node, i - 1 + to_move, node, i - 1);
+  move_value(node, to_move - 1, parent, index);
+  for (size_type i = 0; i + 1 < to_move; ++i)
+    move_value(node, i, left, lc - to_move + 1 + i);
+  move_value(parent, index, left, lc - to_move);
+  if (!node->leaf)
+  {
+    for (size_type i = node->count + 1; i > 0; --i)
+      node->set_child(i - 1 + to_move, node->child(i - 1));
+    for (size_type i = 0; i < to_move; ++i)
+      node->set_child(i, left->child(lc - to_move + 1 + i));
+  }
+  left->count = static_cast<unsigned short>(lc - to_move);
+  node->count = static_cast<unsigned short>(node->count + to_move);
+}
+
+// 根节点没有元素时，树降低一层
+template <class T, class Compare>
+void btree<T, Compare>::
+try_shrink()
+{
+  if (root_->count > 0)
+    return;
+  if (root_->leaf)
+  {
+    destroy_node(root_);
+    root_ = leftmost_ = rightmost_ = nullptr;
+  }
+  else
+  {
+    node_ptr child = root_->child(0);
+    child->parent = nullptr;
+    child->position = 0;
+    destroy_node(root_);
+    root_ = child;
+  }
+}
+
+// 批量插入
+// 新元素较少时逐个插入，否则把新元素排序后与已有元素归并，再依次追加到一棵新树的末尾
+// 追加时节点只在末尾分裂，除最右侧外的节点都是满的
+// 异常安全：逐个插入时每个元素的插入满足强异常安全保证，已经插入的元素保留，即基本异常安全保证；
+// 归并时先只做比较，确定所有元素的次序之后才移动元素，比较函数抛出异常时没有任何改变，
+// 申请节点失败时把已经移走的原有元素移回原处，满足强异常安全保证（要求元素的移动构造不抛出异常）
+template <class T, class Compare>
+template <class InputIterator>
+void btree<T, Compare>::
+bulk_insert(InputIterator first, InputIterator last, bool unique, bool sorted)
+{
+  mystl::vector<value_type> values;
+  for (; first != last; ++first)
+    values.emplace_back(*first);
+  const size_type n = values.size();
+  if (n == 0)
+    return;
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - n, "btree<T, Comp>'s size too big");
+  if (n < (node_count_ >> 3))
+  {
+    for (size_type i = 0; i < n; ++i)
+    {
+      if (unique)
+        emplace_unique(mystl::move(values[i]));
+      else
+        emplace_multi(mystl::move(values[i]));
+    }
+    return;
+  }
+
+  // 对新元素的下标排序，键值相等时按下标排序，使排序是稳定的
+  mystl::vector<size_type> index;
+  index.reserve(n);
+  for (size_type i = 0; i < n; ++i)
+    index.push_back(i);
+  if (!sorted)
+  {
+    mystl::sort(index.begin(), index.end(), [&](size_type a, size_type b)
+    {
+      const auto& ka = value_traits::get_key(values[a]);
+      const auto& kb = value_traits::get_key(values[b]);
+      return key_comp_(ka, kb) || (!key_comp_(kb, ka) && a < b);
+    });
+  }
+
+  // 归并，键值相等时已有元素在前，unique 为 true 时跳过与上一个元素键值相等的元素
+  // 这一步只记录元素的位置，不移动元素
+  mystl::vector<value_type*> order;
+  order.reserve(node_count_ + n);
+  auto it = begin();
+  const auto last_it = end();
+  size_type j = 0;
+  while (it != last_it || j != n)
+  {
+    value_type* p;
+    if (j == n || (it != last_it &&
+        !key_comp_(value_traits::get_key(values[index[j]]), value_traits::get_key(*it))))
+    {
+      p = &*it;
+      ++it;
+    }
+    else
+    {
+      p = &values[index[j++]];
+    }
+    if (unique && !order.empty() &&
+        !key_comp_(value_traits::get_key(*order.back()), value_traits::get_key(*p)))
+      continue;
+    order.push_back(p);
+  }
+
+  // 依次追加到新树的末尾，只有申请节点可能失败
+  btree result;
+  result.key_comp_ = key_comp_;
+  size_type k = 0;
+  try
+  {
+    for (; k < order.size(); ++k)
+      result.insert_value_at(result.end(), mystl::move(*order[k]));
+  }
+  catch (...)
+  { // 把已经移到 result 中的原有元素移回原处，新元素只是 values 中的副本，不需要恢复
+    std::less<const value_type*> less;
+    const value_type* values_first = values.data();
+    const value_type* values_last = values.data() + n;
+    auto rit = result.begin();
+    for (size_type i = 0; i < k; ++i, ++rit)
+    {
+      if (less(order[i], values_first) || !less(order[i], values_last))
+      {
+        data_allocator::destroy(order[i]);
+        data_allocator::construct(order[i], mystl::move(*rit));
+      }
+    }
+    throw;
+  }
+  swap(result);
+}
+
+// 重载比较操作符
+template <class T, class Compare>
+bool operator==(const btree<T, Compare>& lhs, const btree<T, Compare>& rhs)
+{
+  return lhs.size() == rhs.size() && mystl::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class T, class Compare>
+bool operator!=(const btree<T, Compare>& lhs, const btree<T, Compare>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class T, class Compare>
+bool operator<(const btree<T, Compare>& lhs, const btree<T, Compare>& rhs)
+{
+  return mystl::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <class T, class Compare>
+bool operator>(const btree<T, Compare>& lhs, const btree<T, Compare>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class T, class Compare>
+bool operator<=(const btree<T, Compare>& lhs, const btree<T, Compare>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class T, class Compare>
+bool operator>=(const btree<T, Compare>& lhs, const btree<T, Compare>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class T, class Compare>
+void swap(btree<T, Compare>& lhs, btree<T, Compare>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_BTREE_H_
+
@@ -0,0 +1,807 @@
+﻿#ifndef MYTINYSTL_CHUNKED_LIST_H_
+#define MYTINYSTL_CHUNKED_LIST_H_
+
+// 这个头文件包含一个模板类 chunked_list
+// chunked_list : 分块链表，元素存放在链接起来的定长块中，每块用一个位图记录哪些位置有元素
+
+// notes:
+//
+// chunked_list 与 list 一样保证元素的地址稳定，插入和删除都是 O(1)，但遍历时按块连续访问内存，
+// 速度接近 vector：
+//   * 插入的元素放在任意一个有空位的块中，不能指定位置，遍历顺序与插入顺序无关
+//   * 删除元素只析构它并清除位图中对应的位，其它元素的地址和迭代器都不受影响
+//   * 块变空时从链表中摘下并释放，最多保留一个空块，避免在块的边界上反复申请和释放
+//   * for_each 与 erase_if 按块处理元素，满块上是对连续内存的简单循环，比逐个移动迭代器更快
+//
+// 异常保证：
+// emplace / insert 满足强异常安全保证，其余修改操作不抛出异常（复制构造与赋值除外）
+
+#include <initializer_list>
+#include <cstdint>
+
+#include "iterator.h"
+#include "memory.h"
+#include "util.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// 每个块的元素个数，恰好对应一个 64 位的位图
+static constexpr size_t chunked_list_chunk_size = 64;
+
+// 位图中最低 / 最高的非零位的位置，x 不能为 0
+inline unsigned chunk_lowest_bit(uint64_t x) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+  unsigned n = 0;
+  for (; (x & 1) == 0; x >>= 1)
+    ++n;
+  return n;
+#endif
+}
+
+inline unsigned chunk_highest_bit(uint64_t x) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return 63u - static_cast<unsigned>(__builtin_clzll(x));
+#else
+  unsigned n = 0;
+  for (; x >>= 1; )
+    ++n;
+  return n;
+#endif
+}
+
+// chunked_list 的块设计
+// 所有块串成一条带哨兵的双向循环链表，哨兵的位图为 0，其余块的位图都不为 0
+
+struct chunked_list_chunk_base
+{
+  chunked_list_chunk_base* prev;  // 前一块
+  chunked_list_chunk_base* next;  // 下一块
+  uint64_t                 mask;  // 第 i 位为 1 表示第 i 个位置有元素
+};
+
+template <class T>
+struct chunked_list_chunk : public chunked_list_chunk_base
+{
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot_type;
+
+  chunked_list_chunk* free_prev;  // 有空位的块串成另一条双向链表
+  chunked_list_chunk* free_next;
+  slot_type           slots[chunked_list_chunk_size];
+
+  T*       value(size_t i)       { return reinterpret_cast<T*>(&slots[i]); }
+  const T* value(size_t i) const { return reinterpret_cast<const T*>(&slots[i]); }
+};
+
+// chunked_list 的迭代器设计
+
+template <class T>
+struct chunked_list_iterator_base : public mystl::iterator<mystl::bidirectional_iterator_tag, T>
+{
+  typedef chunked_list_chunk_base* base_ptr;
+  typedef chunked_list_chunk<T>*   chunk_ptr;
+
+  base_ptr chunk;     // 所在的块，尾后迭代器指向哨兵
+  unsigned position;  // 在块中的位置
+
+  chunked_list_iterator_base() :chunk(nullptr), position(0) {}
+  chunked_list_iterator_base(base_ptr c, unsigned pos) :chunk(c), position(pos) {}
+
+  // 前进到位图中下一个为 1 的位，本块没有时进入下一块
+  void increment()
+  {
+    MYSTL_DEBUG(chunk != nullptr && chunk->mask != 0);
+    const uint64_t rest = chunk->mask & ~((static_cast<uint64_t>(2) << position) - 1);
+    if (rest != 0)
+    {
+      position = chunk_lowest_bit(rest);
+    }
+    else
+    {
+      chunk = chunk->next;
+      position = chunk->mask != 0 ? chunk_lowest_bit(chunk->mask) : 0;
+    }
+  }
+
+  void decrement()
+  {
+    MYSTL_DEBUG(chunk != nullptr);
+    const uint64_t rest = chunk->mask & ((static_cast<uint64_t>(1) << position) - 1);
+    if (rest != 0)
+    {
+      position = chunk_highest_bit(rest);
+    }
+    else
+    {
+      chunk = chunk->prev;
+      MYSTL_DEBUG(chunk->mask != 0);
+      position = chunk_highest_bit(chunk->mask);
+    }
+  }
+
+  bool operator==(const chunked_list_iterator_base& rhs) const
+  { return chunk == rhs.chunk && position == rhs.position; }
+  bool operator!=(const chunked_list_iterator_base& rhs) const
+  { return !(*this == rhs); }
+};
+
+template <class T>
+struct chunked_list_iterator : public chunked_list_iterator_base<T>
+{
+  typedef chunked_list_iterator_base<T> base;
+  typedef T                             value_type;
+  typedef T*                            pointer;
+  typedef T&                            reference;
+  typedef chunked_list_iterator<T>      self;
+
+  chunked_list_iterator() = default;
+  chunked_list_iterator(typename base::base_ptr c, unsigned pos) :base(c, pos) {}
+
+  reference operator*()  const
+  { return *static_cast<typename base::chunk_ptr>(this->chunk)->value(this->position); }
+  pointer   operator->() const { return &(operator*()); }
+
+  self& operator++()
+  {
+    this->increment();
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp = *this;
+    this->increment();
+    return tmp;
+  }
+  self& operator--()
+  {
+    this->decrement();
+    return *this;
+  }
+  self operator--(int)
+  {
+    self tmp = *this;
+    this->decrement();
+    return tmp;
+  }
+};
+
+template <class T>
+struct chunked_list_const_iterator : public chunked_list_iterator_base<T>
+{
+  typedef chunked_list_iterator_base<T> base;
+  typedef T                             value_type;
+  typedef const T*                      pointer;
+  typedef const T&                      reference;
+  typedef chunked_list_const_iterator<T> self;
+
+  chunked_list_const_iterator() = default;
+  chunked_list_const_iterator(typename base::base_ptr c, unsigned pos) :base(c, pos) {}
+  chunked_list_const_iterator(const chunked_list_iterator<T>& rhs)
+    :base(rhs.chunk, rhs.position) {}
+
+  reference operator*()  const
+  { return *static_cast<typename base::chunk_ptr>(this->chunk)->value(this->position); }
+  pointer   operator->() const { return &(operator*()); }
+
+  self& operator++()
+  {
+    this->increment();
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp = *this;
+    this->increment();
+    return tmp;
+  }
+  self& operator--()
+  {
+    this->decrement();
+    return *this;
+  }
+  self operator--(int)
+  {
+    self tmp = *this;
+    this->decrement();
+    return tmp;
+  }
+};
+
+// 模板类: chunked_list
+// 模板参数 T 代表数据类型
+template <class T>
+class chunked_list
+{
+public:
+  // chunked_list 的嵌套型别定义
+  typedef mystl::allocator<T>                      allocator_type;
+  typedef mystl::allocator<T>                      data_allocator;
+  typedef mystl::allocator<chunked_list_chunk<T>>  chunk_allocator;
+
+  typedef typename allocator_type::value_type      value_type;
+  typedef typename allocator_type::pointer         pointer;
+  typedef typename allocator_type::const_pointer   const_pointer;
+  typedef typename allocator_type::reference       reference;
+  typedef typename allocator_type::const_reference const_reference;
+  typedef typename allocator_type::size_type       size_type;
+  typedef typename allocator_type::difference_type difference_type;
+
+  typedef chunked_list_iterator<T>                 iterator;
+  typedef chunked_list_const_iterator<T>           const_iterator;
+  typedef mystl::reverse_iterator<iterator>        reverse_iterator;
+  typedef mystl::reverse_iterator<const_iterator>  const_reverse_iterator;
+
+  typedef chunked_list_chunk_base*                 base_ptr;
+  typedef chunked_list_chunk<T>*                   chunk_ptr;
+
+  allocator_type get_allocator() { return allocator_type(); }
+
+private:
+  static constexpr uint64_t full_mask = ~static_cast<uint64_t>(0);
+
+  // 用以下六个数据表现 chunked_list
+  chunked_list_chunk_base head_;         // 块链表的哨兵，直接嵌入容器中
+  chunk_ptr               free_;         // 有空位的块，新元素总是放进第一块
+  chunk_ptr               spare_;        // 未使用的空块，通过 next 串成单向链表
+  size_type               size_;         // 元素个数
+  size_type               chunk_count_;  // 块链表中的块数
+  size_type               spare_count_;  // 空块的个数
+
+public:
+  // 构造、复制、移动、析构函数
+  chunked_list() noexcept
+  { init(); }
+
+  explicit chunked_list(size_type n)
+  {
+    init();
+    fill_init(n, value_type());
+  }
+
+  chunked_list(size_type n, const value_type& value)
+  {
+    init();
+    fill_init(n, value);
+  }
+
+  template <class Iter, typename std::enable_if<
+    mystl::is_input_iterator<Iter>::value, int>::type = 0>
+  chunked_list(Iter first, Iter last)
+  {
+    init();
+    copy_init(first, last);
+  }
+
+  chunked_list(std::initializer_list<value_type> ilist)
+  {
+    init();
+    copy_init(ilist.begin(), ilist.end());
+  }
+
+  chunked_list(const chunked_list& rhs)
+  {
+    init();
+    copy_init(rhs.begin(), rhs.end());
+  }
+
+  chunked_list(chunked_list&& rhs) noexcept
+  {
+    init();
+    take(rhs);
+  }
+
+  chunked_list& operator=(const chunked_list& rhs)
+  {
+    if (this != &rhs)
+    {
+      chunked_list tmp(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  chunked_list& operator=(chunked_list&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      clear();
+      shrink_to_fit();
+      take(rhs);
+    }
+    return *this;
+  }
+
+  chunked_list& operator=(std::initializer_list<value_type> ilist)
+  {
+    chunked_list tmp(ilist);
+    swap(tmp);
+    return *this;
+  }
+
+  ~chunked_list()
+  {
+    clear();
+    shrink_to_fit();
+  }
+
+public:
+  // 迭代器相关操作
+  iterator               begin()         noexcept
+  { return iterator(head_.next, first_position(head_.next)); }
+  const_iterator         begin()   const noexcept
+  { return const_iterator(head_.next, first_position(head_.next)); }
+  iterator               end()           noexcept
+  { return iterator(sentinel(), 0); }
+  const_iterator         end()     const noexcept
+  { return const_iterator(sentinel(), 0); }
+
+  reverse_iterator       rbegin()        noexcept
+  { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin()  const noexcept
+  { return const_reverse_iterator(end()); }
+  reverse_iterator       rend()          noexcept
+  { return reverse_iterator(begin()); }
+  const_reverse_iterator rend()    const noexcept
+  { return const_reverse_iterator(begin()); }
+
+  const_iterator         cbegin()  const noexcept
+  { return begin(); }
+  const_iterator         cend()    const noexcept
+  { return end(); }
+  const_reverse_iterator crbegin() const noexcept
+  { return rbegin(); }
+  const_reverse_iterator crend()   const noexcept
+  { return rend(); }
+
+  // 容量相关操作
+  bool      empty()    const noexcept
+  { return size_ == 0; }
+  size_type size()     const noexcept
+  { return size_; }
+  size_type max_size() const noexcept
+  { return static_cast<size_type>(-1) / sizeof(chunked_list_chunk<T>) * chunked_list_chunk_size; }
+
+  // 不再申请块时最多能容纳的元素个数
+  size_type capacity() const noexcept
+  { return (chunk_count_ + spare_count_) * chunked_list_chunk_size; }
+
+  // 预先申请空块，使 capacity() 至少为 n
+  void      reserve(size_type n);
+
+  // 释放所有空块
+  void      shrink_to_fit() noexcept;
+
+  // 修改容器相关操作
+
+  // 在任意一个空位上构造元素，返回指向它的迭代器
+  template <class ...Args>
+  iterator emplace(Args&& ...args);
+
+  iterator insert(const value_type& value)
+  { return emplace(value); }
+  iterator insert(value_type&& value)
+  { return emplace(mystl::move(value)); }
+
+  void     insert(size_type n, const value_type& value)
+  {
+    for (; n > 0; --n)
+      emplace(value);
+  }
+
+  template <class Iter, typename std::enable_if<
+    mystl::is_input_iterator<Iter>::value, int>::type = 0>
+  void     insert(Iter first, Iter last)
+  {
+    for (; first != last; ++first)
+      emplace(*first);
+  }
+
+  void     insert(std::initializer_list<value_type> ilist)
+  { insert(ilist.begin(), ilist.end()); }
+
+  // 删除元素，返回下一个元素的位置，其它元素的迭代器不失效
+  iterator erase(const_iterator pos) noexcept;
+  iterator erase(const_iterator first, const_iterator last) noexcept;
+
+  // 删除所有元素，所有块成为空块，capacity() 不变
+  void     clear() noexcept;
+
+  void     swap(chunked_list& rhs) noexcept;
+
+  // chunked_list 相关操作
+
+  // 对每个元素调用 f，按块遍历
+  template <class UnaryFunction>
+  void      for_each(UnaryFunction f);
+  template <class UnaryFunction>
+  void      for_each(UnaryFunction f) const;
+
+  // 删除所有令 pred 为 true 的元素，返回删除的个数
+  template <class UnaryPredicate>
+  size_type erase_if(UnaryPredicate pred);
+
+private:
+  // helper functions
+
+  base_ptr sentinel() const noexcept
+  { return const_cast<base_ptr>(&head_); }
+
+  static unsigned first_position(base_ptr c) noexcept
+  { return c->mask != 0 ? chunk_lowest_bit(c->mask) : 0; }
+
+  // initialize
+  void      init() noexcept;
+  void      fill_init(size_type n, const value_type& value);
+  template <class Iter>
+  void      copy_init(Iter first, Iter last);
+  void      take(chunked_list& rhs) noexcept;
+
+  // chunk
+  chunk_ptr get_chunk();
+  void      link_chunk(chunk_ptr c) noexcept;
+  void      unlink_free(chunk_ptr c) noexcept;
+  void      push_free(chunk_ptr c) noexcept;
+  void      release_chunk(chunk_ptr c) noexcept;
+  void      destroy_slot(chunk_ptr c, unsigned i) noexcept;
+};
+
+/*****************************************************************************************/
+
+// 预先申请空块
+template <class T>
+void chunked_list<T>::reserve(size_type n)
+{
+  while (capacity() < n)
+  {
+    chunk_ptr c = chunk_allocator::allocate(1);
+    c->next = spare_;
+    spare_ = c;
+    ++spare_count_;
+  }
+}
+
+// 释放所有空块
+template <class T>
+void chunked_list<T>::shrink_to_fit() noexcept
+{
+  while (spare_ != nullptr)
+  {
+    chunk_ptr c = spare_;
+    spare_ = static_cast<chunk_ptr>(c->next);
+    chunk_allocator::deallocate(c);
+  }
+  spare_count_ = 0;
+}
+
+// 在第一个有空位的块的最低空位上构造元素，没有这样的块时使用一个新块
+template <class T>
+template <class ...Args>
+typename chunked_list<T>::iterator
+chunked_list<T>::emplace(Args&& ...args)
+{
+  THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "chunked_list<T>'s size too big");
+  chunk_ptr c = free_;
+  const bool fresh = c == nullptr;
+  if (fresh)
+    c = get_chunk();
+  const unsigned i = chunk_lowest_bit(~c->mask);
+  try
+  {
+    data_allocator::construct(c->value(i), mystl::forward<Args>(args)...);
+  }
+  catch (...)
+  {
+    if (fresh)
+    {
+      c->next = spare_;
+      spare_ = c;
+      ++spare_count_;
+    }
+    throw;
+  }
+  if (fresh)
+  {
+    link_chunk(c);
+    push_free(c);
+  }
+  c->mask |= static_cast<uint64_t>(1) << i;
+  if (c->mask == full_mask)
+    unlink_free(c);
+  ++size_;
+  return iterator(c, i);
+}
+
+// 删除 pos 处的元素，块变空时释放它
+template <class T>
+typename chunked_list<T>::iterator
+chunked_list<T>::erase(const_iterator pos) noexcept
+{
+  MYSTL_DEBUG(pos != cend());
+  iterator next(pos.chunk, pos.position);
+  ++next;
+  destroy_slot(static_cast<chunk_ptr>(pos.chunk), pos.position);
+  return next;
+}
+
+template <class T>
+typename chunked_list<T>::iterator
+chunked_list<T>::erase(const_iterator first, const_iterator last) noexcept
+{
+  while (first != last)
+    first = erase(first);
+  return iterator(last.chunk, last.position);
+}
+
+// 析构所有元素，块都放入空块链表
+template <class T>
+void chunked_list<T>::clear() noexcept
+{
+  base_ptr c = head_.next;
+  while (c != sentinel())
+  {
+    base_ptr next = c->next;
+    auto chunk = static_cast<chunk_ptr>(c);
+    for (uint64_t m = c->mask; m != 0; m &= m - 1)
+      data_allocator::destroy(chunk->value(chunk_lowest_bit(m)));
+    chunk->next = spare_;
+    spare_ = chunk;
+    ++spare_count_;
+    c = next;
+  }
+  head_.prev = head_.next = sentinel();
+  free_ = nullptr;
+  size_ = 0;
+  chunk_count_ = 0;
+}
+
+// 哨兵嵌在容器中，需要借助临时容器交换
+template <class T>
+void chunked_list<T>::swap(chunked_list& rhs) noexcept
+{
+  if (this == &rhs)
+    return;
+  chunked_list tmp;
+  tmp.take(rhs);
+  rhs.take(*this);
+  take(tmp);
+}
+
+// 对每个元素调用 f
+template <class T>
+template <class UnaryFunction>
+void chunked_list<T>::for_each(UnaryFunction f)
+{
+  for (base_ptr c = head_.next; c != sentinel(); c = c->next)
+  {
+    auto chunk = static_cast<chunk_ptr>(c);
+    uint64_t m = c->mask;
+    if (m == full_mask)
+    {
+      for (size_t i = 0; i < chunked_list_chunk_size; ++i)
+        f(*chunk->value(i));
+    }
+    else
+    {
+      for (; m != 0; m &= m - 1)
+        f(*chunk->value(chunk_lowest_bit(m)));
+    }
+  }
+}
+
+template <class T>
+template <class UnaryFunction>
+void chunked_list<T>::for_each(UnaryFunction f) const
+{
+  for (base_ptr c = head_.next; c != sentinel(); c = c->next)
+  {
+    auto chunk = static_cast<const chunked_list_chunk<T>*>(c);
+    uint64_t m = c->mask;
+    if (m == full_mask)
+    {
+      for (size_t i = 0; i < chunked_list_chunk_size; ++i)
+        f(*chunk->value(i));
+    }
+    else
+    {
+      for (; m != 0; m &= m - 1)
+        f(*chunk->value(chunk_lowest_bit(m)));
+    }
+  }
+}
+
+// 删除所有令 pred 为 true 的元素
+template <class T>
+template <class UnaryPredicate>
+typename chunked_list<T>::size_type
+chunked_list<T>::erase_if(UnaryPredicate pred)
+{
+  size_type n = 0;
+  for (base_ptr c = head_.next; c != sentinel(); )
+  {
+    base_ptr next = c->next;  // 当前块可能被释放
+    auto chunk = static_cast<chunk_ptr>(c);
+    for (uint64_t m = c->mask; m != 0; m &= m - 1)
+    {
+      const unsigned i = chunk_lowest_bit(m);
+      if (pred(*chunk->value(i)))
+      {
+        destroy_slot(chunk, i);
+        ++n;
+      }
+    }
+    c = next;
+  }
+  return n;
+}
+
+/*****************************************************************************************/
+// helper function
+
+template <class T>
+void chunked_list<T>::init() noexcept
+{
+  head_.prev = head_.next = sentinel();
+  head_.mask = 0;
+  free_ = nullptr;
+  spare_ = nullptr;
+  size_ = 0;
+  chunk_count_ = 0;
+  spare_count_ = 0;
+}
+
+// 用 n 个元素初始化容器
+template <class T>
+void chunked_list<T>::fill_init(size_type n, const value_type& value)
+{
+  try
+  {
+    reserve(n);
+    insert(n, value);
+  }
+  catch (...)
+  {
+    clear();
+    shrink_to_fit();
+    throw;
+  }
+}
+
+// 以 [first, last) 初始化容器
+template <class T>
+template <class Iter>
+void chunked_list<T>::copy_init(Iter first, Iter last)
+{
+  try
+  {
+    insert(first, last);
+  }
+  catch (...)
+  {
+    clear();
+    shrink_to_fit();
+    throw;
+  }
+}
+
+// 接管 rhs 的所有块，*this 必须为空且没有空块
+template <class T>
+void chunked_list<T>::take(chunked_list& rhs) noexcept
+{
+  if (rhs.head_.next != rhs.sentinel())
+  {
+    head_.next = rhs.head_.next;
+    head_.prev = rhs.head_.prev;
+    head_.next->prev = sentinel();
+    head_.prev->next = sentinel();
+  }
+  free_ = rhs.free_;
+  spare_ = rhs.spare_;
+  size_ = rhs.size_;
+  chunk_count_ = rhs.chunk_count_;
+  spare_count_ = rhs.spare_count_;
+  rhs.init();
+}
+
+// 取得一个空块，优先使用空块链表中的块
+template <class T>
+typename chunked_list<T>::chunk_ptr
+chunked_list<T>::get_chunk()
+{
+  chunk_ptr c;
+  if (spare_ != nullptr)
+  {
+    c = spare_;
+    spare_ = static_cast<chunk_ptr>(c->next);
+    --spare_count_;
+  }
+  else
+  {
+    c = chunk_allocator::allocate(1);
+  }
+  c->mask = 0;
+  return c;
+}
+
+// 把块接到块链表的末尾
+template <class T>
+void chunked_list<T>::link_chunk(chunk_ptr c) noexcept
+{
+  c->next = sentinel();
+  c->prev = head_.prev;
+  head_.prev->next = c;
+  head_.prev = c;
+  ++chunk_count_;
+}
+
+template <class T>
+void chunked_list<T>::unlink_free(chunk_ptr c) noexcept
+{
+  if (c->free_prev != nullptr)
+    c->free_prev->free_next = c->free_next;
+  else
+    free_ = c->free_next;
+  if (c->free_next != nullptr)
+    c->free_next->free_prev = c->free_prev;
+}
+
+template <class T>
+void chunked_list<T>::push_free(chunk_ptr c) noexcept
+{
+  c->free_prev = nullptr;
+  c->free_next = free_;
+  if (free_ != nullptr)
+    free_->free_prev = c;
+  free_ = c;
+}
+
+// 从块链表中摘下一个空块，没有其它空块时保留它，否则释放
+template <class T>
+void chunked_list<T>::release_chunk(chunk_ptr c) noexcept
+{
+  unlink_free(c);
+  c->prev->next = c->next;
+  c->next->prev = c->prev;
+  --chunk_count_;
+  if (spare_count_ == 0)
+  {
+    c->next = nullptr;
+    spare_ = c;
+    spare_count_ = 1;
+  }
+  else
+  {
+    chunk_allocator::deallocate(c);
+  }
+}
+
+// 析构块 c 中第 i 个位置的元素，并维护有空位的块链表
+template <class T>
+void chunked_list<T>::destroy_slot(chunk_ptr c, unsigned i) noexcept
+{
+  data_allocator::destroy(c->value(i));
+  const bool was_full = c->mask == full_mask;
+  c->mask &= ~(static_cast<uint64_t>(1) << i);
+  --size_;
+  if (c->mask == 0)
+    release_chunk(c);
+  else if (was_full)
+  {
+    push_free(c);
+  }
+}
+
+// 重载 mystl 的 swap
+template <class T>
+void swap(chunked_list<T>& lhs, chunked_list<T>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_CHUNKED_LIST_H_
+
@@ -21,6 +21,9 @@ namespace mystl
 #define THROW_RUNTIME_ERROR_IF(expr, what) \
   if ((expr)) throw std::runtime_error(what)
 
+#define THROW_INVALID_ARGUMENT_IF(expr, what) \
+  if ((expr)) throw std::invalid_argument(what)
+
 } // namepsace mystl
 
 #endif // !MYTINYSTL_EXCEPTDEF_H_
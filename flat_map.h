@@ -0,0 +1,610 @@
+﻿#ifndef MYTINYSTL_FLAT_MAP_H_
+#define MYTINYSTL_FLAT_MAP_H_
+
+// 这个头文件包含两个模板类 flat_map 和 flat_multimap
+// flat_map      : 有序数组实现的映射，元素具有键值和实值，连续存放并按键值排序，键值不允许重复
+// flat_multimap : 有序数组实现的映射，元素具有键值和实值，连续存放并按键值排序，键值允许重复
+
+// notes:
+//
+// 与 map / multimap 接口相同，但有以下不同：
+//   * 元素类型为 pair<Key, T>，键值不是 const 的，使用者不应通过迭代器修改键值
+//   * 插入与删除会使所有迭代器失效
+//   * 逐个插入的时间复杂度为 O(n)，大量插入时应当使用区间版本的 insert，它只做一次排序与归并
+//   * 参数 Split 为 true 时，键值与实值分别存放在两个 vector 中，查找只访问键值数组，
+//     此时迭代器解引用得到 pair<const Key&, T&>，不是真正的引用
+//
+// 异常保证：
+// mystl::flat_map<Key, T> / mystl::flat_multimap<Key, T> 满足基本异常保证，对以下等函数做强异常安全保证：
+//   * emplace
+//   * emplace_hint
+//   * insert(value)
+
+#include "flat_tree.h"
+
+namespace mystl
+{
+
+// 根据 Split 选择存储方式
+template <class Key, class T, bool Split>
+struct flat_map_storage
+{
+  typedef mystl::flat_storage<mystl::pair<Key, T>> type;
+};
+
+template <class Key, class T>
+struct flat_map_storage<Key, T, true>
+{
+  typedef mystl::flat_split_storage<Key, T> type;
+};
+
+// 模板类 flat_map，键值不允许重复
+// 参数一代表键值类型，参数二代表实值类型，参数三代表键值的比较方式，缺省使用 mystl::less，
+// 参数四表示是否把键值与实值分开存放
+template <class Key, class T, class Compare = mystl::less<Key>, bool Split = false>
+class flat_map
+{
+public:
+  // flat_map 的嵌套型别定义
+  typedef Key                        key_type;
+  typedef T                          mapped_type;
+  typedef mystl::pair<Key, T>        value_type;
+  typedef Compare                    key_compare;
+
+  // 定义一个 functor，用来进行元素比较
+  class value_compare : public binary_function <value_type, value_type, bool>
+  {
+    friend class flat_map<Key, T, Compare, Split>;
+  private:
+    Compare comp;
+    value_compare(Compare c) : comp(c) {}
+  public:
+    template <class P1, class P2>
+    bool operator()(const P1& lhs, const P2& rhs) const
+    {
+      return comp(lhs.first, rhs.first);  // 比较键值的大小
+    }
+  };
+
+private:
+  // 以 mystl::flat_tree 作为底层机制
+  typedef typename flat_map_storage<Key, T, Split>::type   storage_type;
+  typedef mystl::flat_tree<storage_type, key_compare>      base_type;
+  base_type tree_;
+
+public:
+  // 使用 flat_tree 的型别
+  typedef typename base_type::pointer                pointer;
+  typedef typename base_type::const_pointer          const_pointer;
+  typedef typename base_type::reference              reference;
+  typedef typename base_type::const_reference        const_reference;
+  typedef typename base_type::iterator               iterator;
+  typedef typename base_type::const_iterator         const_iterator;
+  typedef typename base_type::reverse_iterator       reverse_iterator;
+  typedef typename base_type::const_reverse_iterator const_reverse_iterator;
+  typedef typename base_type::size_type              size_type;
+  typedef typename base_type::difference_type        difference_type;
+  typedef typename base_type::allocator_type         allocator_type;
+
+public:
+  // 构造、复制、移动、赋值函数
+
+  flat_map() = default;
+
+  template <class InputIterator>
+  flat_map(InputIterator first, InputIterator last)
+    :tree_()
+  { tree_.insert_unique(first, last); }
+  // 区间已经有序时，以线性时间构造
+  template <class InputIterator>
+  flat_map(mystl::sorted_unique_tag tag, InputIterator first, InputIterator last)
+    :tree_()
+  { tree_.insert_unique(tag, first, last); }
+
+  flat_map(std::initializer_list<value_type> ilist)
+    :tree_()
+  { tree_.insert_unique(ilist.begin(), ilist.end()); }
+
+  flat_map(const flat_map& rhs)
+    :tree_(rhs.tree_)
+  {
+  }
+  flat_map(flat_map&& rhs) noexcept
+    :tree_(mystl::move(rhs.tree_))
+  {
+  }
+
+  flat_map& operator=(const flat_map& rhs)
+  {
+    tree_ = rhs.tree_;
+    return *this;
+  }
+  flat_map& operator=(flat_map&& rhs)
+  {
+    tree_ = mystl::move(rhs.tree_);
+    return *this;
+  }
+
+  flat_map& operator=(std::initializer_list<value_type> ilist)
+  {
+    tree_.clear();
+    tree_.insert_unique(ilist.begin(), ilist.end());
+    return *this;
+  }
+
+  // 相关接口
+
+  key_compare            key_comp()      const { return tree_.key_comp(); }
+  value_compare          value_comp()    const { return value_compare(tree_.key_comp()); }
+  allocator_type         get_allocator() const { return tree_.get_allocator(); }
+
+  // 迭代器相关
+
+  iterator               begin()         noexcept
+  { return tree_.begin(); }
+  const_iterator         begin()   const noexcept
+  { return tree_.begin(); }
+  iterator               end()           noexcept
+  { return tree_.end(); }
+  const_iterator         end()     const noexcept
+  { return tree_.end(); }
+
+  reverse_iterator       rbegin()        noexcept
+  { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin()  const noexcept
+  { return const_reverse_iterator(end()); }
+  reverse_iterator       rend()          noexcept
+  { return reverse_iterator(begin()); }
+  const_reverse_iterator rend()    const noexcept
+  { return const_reverse_iterator(begin()); }
+
+  const_iterator         cbegin()  const noexcept
+  { return begin(); }
+  const_iterator         cend()    const noexcept
+  { return end(); }
+  const_reverse_iterator crbegin() const noexcept
+  { return rbegin(); }
+  const_reverse_iterator crend()   const noexcept
+  { return rend(); }
+
+  // 容量相关
+  bool                   empty()    const noexcept { return tree_.empty(); }
+  size_type              size()     const noexcept { return tree_.size(); }
+  size_type              max_size() const noexcept { return tree_.max_size(); }
+  size_type              capacity() const noexcept { return tree_.capacity(); }
+  void                   reserve(size_type n)      { tree_.reserve(n); }
+  void                   shrink_to_fit()           { tree_.shrink_to_fit(); }
+
+  // 访问元素相关
+
+  // 若键值不存在，at 会抛出一个异常
+  mapped_type& at(const key_type& key)
+  {
+    iterator it = find(key);
+    THROW_OUT_OF_RANGE_IF(it == end(), "flat_map<Key, T> no such element exists");
+    return it->second;
+  }
+  const mapped_type& at(const key_type& key) const
+  {
+    const_iterator it = find(key);
+    THROW_OUT_OF_RANGE_IF(it == end(), "flat_map<Key, T> no such element exists");
+    return it->second;
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    return tree_.try_emplace_unique(key).first->second;
+  }
+  mapped_type& operator[](key_type&& key)
+  {
+    return tree_.try_emplace_unique(mystl::move(key)).first->second;
+  }
+
+  // 插入删除相关
+
+  template <class ...Args>
+  pair<iterator, bool> emplace(Args&& ...args)
+  {
+    return tree_.emplace_unique(mystl::forward<Args>(args)...);
+  }
+
+  template <class ...Args>
+  iterator emplace_hint(const_iterator hint, Args&& ...args)
+  {
+    return tree_.emplace_unique_use_hint(hint, mystl::forward<Args>(args)...);
+  }
+
+  // try_emplace / insert_or_assign，键值已经存在时不会构造元素
+
+  template <class ...Args>
+  pair<iterator, bool> try_emplace(const key_type& key, Args&& ...args)
+  {
+    return tree_.try_emplace_unique(key, mystl::forward<Args>(args)...);
+  }
+  template <class ...Args>
+  pair<iterator, bool> try_emplace(key_type&& key, Args&& ...args)
+  {
+    return tree_.try_emplace_unique(mystl::move(key), mystl::forward<Args>(args)...);
+  }
+
+  template <class ...Args>
+  iterator try_emplace(const_iterator /*hint*/, const key_type& key, Args&& ...args)
+  {
+    return try_emplace(key, mystl::forward<Args>(args)...).first;
+  }
+  template <class ...Args>
+  iterator try_emplace(const_iterator /*hint*/, key_type&& key, Args&& ...args)
+  {
+    return try_emplace(mystl::move(key), mystl::forward<Args>(args)...).first;
+  }
+
+  template <class M>
+  pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+  {
+    return tree_.insert_or_assign_unique(key, mystl::forward<M>(obj));
+  }
+  template <class M>
+  pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
+  {
+    return tree_.insert_or_assign_unique(mystl::move(key), mystl::forward<M>(obj));
+  }
+
+  template <class M>
+  iterator insert_or_assign(const_iterator /*hint*/, const key_type& key, M&& obj)
+  {
+    return insert_or_assign(key, mystl::forward<M>(obj)).first;
+  }
+  template <class M>
+  iterator insert_or_assign(const_iterator /*hint*/, key_type&& key, M&& obj)
+  {
+    return insert_or_assign(mystl::move(key), mystl::forward<M>(obj)).first;
+  }
+
+  pair<iterator, bool> insert(const value_type& value)
+  {
+    return tree_.insert_unique(value);
+  }
+  pair<iterator, bool> insert(value_type&& value)
+  {
+    return tree_.insert_unique(mystl::move(value));
+  }
+
+  iterator insert(const_iterator hint, const value_type& value)
+  {
+    return tree_.insert_unique(hint, value);
+  }
+  iterator insert(const_iterator hint, value_type&& value)
+  {
+    return tree_.insert_unique(hint, mystl::move(value));
+  }
+
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    tree_.insert_unique(first, last);
+  }
+  template <class InputIterator>
+  void insert(mystl::sorted_unique_tag tag, InputIterator first, InputIterator last)
+  {
+    tree_.insert_unique(tag, first, last);
+  }
+
+  iterator  erase(const_iterator position)                   { return tree_.erase(position); }
+  size_type erase(const key_type& key)                       { return tree_.erase_unique(key); }
+  iterator  erase(const_iterator first, const_iterator last) { return tree_.erase(first, last); }
+
+  void      clear()                                          { tree_.clear(); }
+
+  // flat_map 相关操作
+
+  iterator       find(const key_type& key)              { return tree_.find(key); }
+  const_iterator find(const key_type& key)        const { return tree_.find(key); }
+
+  size_type      count(const key_type& key)       const { return tree_.count_unique(key); }
+
+  iterator       lower_bound(const key_type& key)       { return tree_.lower_bound(key); }
+  const_iterator lower_bound(const key_type& key) const { return tree_.lower_bound(key); }
+
+  iterator       upper_bound(const key_type& key)       { return tree_.upper_bound(key); }
+  const_iterator upper_bound(const key_type& key) const { return tree_.upper_bound(key); }
+
+  pair<iterator, iterator>
+    equal_range(const key_type& key)
+  { return tree_.equal_range_unique(key); }
+
+  pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const
+  { return tree_.equal_range_unique(key); }
+
+  void           swap(flat_map& rhs) noexcept
+  { tree_.swap(rhs.tree_); }
+
+public:
+  friend bool operator==(const flat_map& lhs, const flat_map& rhs) { return lhs.tree_ == rhs.tree_; }
+  friend bool operator< (const flat_map& lhs, const flat_map& rhs) { return lhs.tree_ <  rhs.tree_; }
+};
+
+// 重载比较操作符
+template <class Key, class T, class Compare, bool Split>
+bool operator!=(const flat_map<Key, T, Compare, Split>& lhs, const flat_map<Key, T, Compare, Split>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class Key, class T, class Compare, bool Split>
+bool operator>(const flat_map<Key, T, Compare, Split>& lhs, const flat_map<Key, T, Compare, Split>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class Key, class T, class Compare, bool Split>
+bool operator<=(const flat_map<Key, T, Compare, Split>& lhs, const flat_map<Key, T, Compare, Split>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class Key, class T, class Compare, bool Split>
+bool operator>=(const flat_map<Key, T, Compare, Split>& lhs, const flat_map<Key, T, Compare, Split>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class Key, class T, class Compare, bool Split>
+void swap(flat_map<Key, T, Compare, Split>& lhs, flat_map<Key, T, Compare, Split>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+/*****************************************************************************************/
+
+// 模板类 flat_multimap，键值允许重复
+// 参数一代表键值类型，参数二代表实值类型，参数三代表键值的比较方式，缺省使用 mystl::less，
+// 参数四表示是否把键值与实值分开存放
+template <class Key, class T, class Compare = mystl::less<Key>, bool Split = false>
+class flat_multimap
+{
+public:
+  // flat_multimap 的嵌套型别定义
+  typedef Key                        key_type;
+  typedef T                          mapped_type;
+  typedef mystl::pair<Key, T>        value_type;
+  typedef Compare                    key_compare;
+
+  // 定义一个 functor，用来进行元素比较
+  class value_compare : public binary_function <value_type, value_type, bool>
+  {
+    friend class flat_multimap<Key, T, Compare, Split>;
+  private:
+    Compare comp;
+    value_compare(Compare c) : comp(c) {}
+  public:
+    template <class P1, class P2>
+    bool operator()(const P1& lhs, const P2& rhs) const
+    {
+      return comp(lhs.first, rhs.first);  // 比较键值的大小
+    }
+  };
+
+private:
+  // 以 mystl::flat_tree 作为底层机制
+  typedef typename flat_map_storage<Key, T, Split>::type   storage_type;
+  typedef mystl::flat_tree<storage_type, key_compare>      base_type;
+  base_type tree_;
+
+public:
+  // 使用 flat_tree 的型别
+  typedef typename base_type::pointer                pointer;
+  typedef typename base_type::const_pointer          const_pointer;
+  typedef typename base_type::reference              reference;
+  typedef typename base_type::const_reference        const_reference;
+  typedef typename base_type::iterator               iterator;
+  typedef typename base_type::const_iterator         const_iterator;
+  typedef typename base_type::reverse_iterator       reverse_iterator;
+  typedef typename base_type::const_reverse_iterator const_reverse_iterator;
+  typedef typename base_type::size_type              size_type;
+  typedef typename base_type::difference_type        difference_type;
+  typedef typename base_type::allocator_type         allocator_type;
+
+public:
+  // 构造、复制、移动、赋值函数
+
+  flat_multimap() = default;
+
+  template <class InputIterator>
+  flat_multimap(InputIterator first, InputIterator last)
+    :tree_()
+  { tree_.insert_multi(first, last); }
+  // 区间已经有序时，以线性时间构造
+  template <class InputIterator>
+  flat_multimap(mystl::sorted_equivalent_tag tag, InputIterator first, InputIterator last)
+    :tree_()
+  { tree_.insert_multi(tag, first, last); }
+
+  flat_multimap(std::initializer_list<value_type> ilist)
+    :tree_()
+  { tree_.insert_multi(ilist.begin(), ilist.end()); }
+
+  flat_multimap(const flat_multimap& rhs)
+    :tree_(rhs.tree_)
+  {
+  }
+  flat_multimap(flat_multimap&& rhs) noexcept
+    :tree_(mystl::move(rhs.tree_))
+  {
+  }
+
+  flat_multimap& operator=(const flat_multimap& rhs)
+  {
+    tree_ = rhs.tree_;
+    return *this;
+  }
+  flat_multimap& operator=(flat_multimap&& rhs)
+  {
+    tree_ = mystl::move(rhs.tree_);
+    return *this;
+  }
+
+  flat_multimap& operator=(std::initializer_list<value_type> ilist)
+  {
+    tree_.clear();
+    tree_.insert_multi(ilist.begin(), ilist.end());
+    return *this;
+  }
+
+  // 相关接口
+
+  key_compare            key_comp()      const { return tree_.key_comp(); }
+  value_compare          value_comp()    const { return value_compare(tree_.key_comp()); }
+  allocator_type         get_allocator() const { return tree_.get_allocator(); }
+
+  // 迭代器相关
+
+  iterator               begin()         noexcept
+  { return tree_.begin(); }
+  const_iterator         begin()   const noexcept
+  { return tree_.begin(); }
+  iterator               end()           noexcept
+  { return tree_.end(); }
+  const_iterator         end()     const noexcept
+  { return tree_.end(); }
+
+  reverse_iterator       rbegin()        noexcept
+  { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin()  const noexcept
+  { return const_reverse_iterator(end()); }
+  reverse_iterator       rend()          noexcept
+  { return reverse_iterator(begin()); }
+  const_reverse_iterator rend()    const noexcept
+  { return const_reverse_iterator(begin()); }
+
+  const_iterator         cbegin()  const noexcept
+  { return begin(); }
+  const_iterator         cend()    const noexcept
+  { return end(); }
+  const_reverse_iterator crbegin() const noexcept
+  { return rbegin(); }
+  const_reverse_iterator crend()   const noexcept
+  { return rend(); }
+
+  // 容量相关
+  bool                   empty()    const noexcept { return tree_.empty(); }
+  size_type              size()     const noexcept { return tree_.size(); }
+  size_type              max_size() const noexcept { return tree_.max_size(); }
+  size_type              capacity() const noexcept { return tree_.capacity(); }
+  void                   reserve(size_type n)      { tree_.reserve(n); }
+  void                   shrink_to_fit()           { tree_.shrink_to_fit(); }
+
+  // 插入删除相关
+
+  template <class ...Args>
+  iterator emplace(Args&& ...args)
+  {
+    return tree_.emplace_multi(mystl::forward<Args>(args)...);
+  }
+
+  template <class ...Args>
+  iterator emplace_hint(const_iterator hint, Args&& ...args)
+  {
+    return tree_.emplace_multi_use_hint(hint, mystl::forward<Args>(args)...);
+  }
+
+  iterator insert(const value_type& value)
+  {
+    return tree_.insert_multi(value);
+  }
+  iterator insert(value_type&& value)
+  {
+    return tree_.insert_multi(mystl::move(value));
+  }
+
+  iterator insert(const_iterator hint, const value_type& value)
+  {
+    return tree_.insert_multi(hint, value);
+  }
+  iterator insert(const_iterator hint, value_type&& value)
+  {
+    return tree_.insert_multi(hint, mystl::move(value));
+  }
+
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    tree_.insert_multi(first, last);
+  }
+  template <class InputIterator>
+  void insert(mystl::sorted_equivalent_tag tag, InputIterator first, InputIterator last)
+  {
+    tree_.insert_multi(tag, first, last);
+  }
+
+  iterator  erase(const_iterator position)                   { return tree_.erase(position); }
+  size_type erase(const key_type& key)                       { return tree_.erase_multi(key); }
+  iterator  erase(const_iterator first, const_iterator last) { return tree_.erase(first, last); }
+
+  void      clear()                                          { tree_.clear(); }
+
+  // flat_multimap 相关操作
+
+  iterator       find(const key_type& key)              { return tree_.find(key); }
+  const_iterator find(const key_type& key)        const { return tree_.find(key); }
+
+  size_type      count(const key_type& key)       const { return tree_.count_multi(key); }
+
+  iterator       lower_bound(const key_type& key)       { return tree_.lower_bound(key); }
+  const_iterator lower_bound(const key_type& key) const { return tree_.lower_bound(key); }
+
+  iterator       upper_bound(const key_type& key)       { return tree_.upper_bound(key); }
+  const_iterator upper_bound(const key_type& key) const { return tree_.upper_bound(key); }
+
+  pair<iterator, iterator>
+    equal_range(const key_type& key)
+  { return tree_.equal_range_multi(key); }
+
+  pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const
+  { return tree_.equal_range_multi(key); }
+
+  void           swap(flat_multimap& rhs) noexcept
+  { tree_.swap(rhs.tree_); }
+
+public:
+  friend bool operator==(const flat_multimap& lhs, const flat_multimap& rhs) { return lhs.tree_ == rhs.tree_; }
+  friend bool operator< (const flat_multimap& lhs, const flat_multimap& rhs) { return lhs.tree_ <  rhs.tree_; }
+};
+
+// 重载比较操作符
+template <class Key, class T, class Compare, bool Split>
+bool operator!=(const flat_multimap<Key, T, Compare, Split>& lhs, const flat_multimap<Key, T, Compare, Split>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class Key, class T, class Compare, bool Split>
+bool operator>(const flat_multimap<Key, T, Compare, Split>& lhs, const flat_multimap<Key, T, Compare, Split>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class Key, class T, class Compare, bool Split>
+bool operator<=(const flat_multimap<Key, T, Compare, Split>& lhs, const flat_multimap<Key, T, Compare, Split>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class Key, class T, class Compare, bool Split>
+bool operator>=(const flat_multimap<Key, T, Compare, Split>& lhs, const flat_multimap<Key, T, Compare, Split>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class Key, class T, class Compare, bool Split>
+void swap(flat_multimap<Key, T, Compare, Split>& lhs, flat_multimap<Key, T, Compare, Split>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_FLAT_MAP_H_
+
@@ -0,0 +1,874 @@
+﻿#ifndef MYTINYSTL_FLAT_TREE_H_
+#define MYTINYSTL_FLAT_TREE_H_
+
+// 这个头文件包含一个模板类 flat_tree
+// flat_tree : 有序数组，以 vector 按键值顺序连续存放元素，用二分查找代替树的查找，
+//             作为 flat_set / flat_multiset / flat_map / flat_multimap 的底层机制
+//
+// 与 rb_tree 相比，每个元素没有额外的节点开销，查找时访问的内存连续，适合读多写少的场景，
+// 但单个元素的插入与删除需要移动其后的所有元素，时间复杂度为 O(n)，
+// 批量插入时先把新元素追加到尾部，再排序、去重并与已有元素归并
+
+#include <initializer_list>
+
+#include "vector.h"
+#include "algo.h"
+#include "functional.h"
+#include "iterator.h"
+#include "util.h"
+#include "type_traits.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// flat value traits
+
+template <class T, bool>
+struct flat_value_traits_imp
+{
+  typedef T key_type;
+  typedef T mapped_type;
+  typedef T value_type;
+
+  template <class Ty>
+  static const key_type& get_key(const Ty& value)
+  {
+    return value;
+  }
+};
+
+template <class T>
+struct flat_value_traits_imp<T, true>
+{
+  typedef typename std::remove_cv<typename T::first_type>::type key_type;
+  typedef typename T::second_type                               mapped_type;
+  typedef T                                                     value_type;
+
+  template <class Ty>
+  static const key_type& get_key(const Ty& value)
+  {
+    return value.first;
+  }
+};
+
+template <class T>
+struct flat_value_traits : public flat_value_traits_imp<T, mystl::is_pair<T>::value>
+{
+};
+
+// 模板类 flat_storage
+// 元素连续存放在一个 vector 中，set 类容器的元素就是键值，map 类容器的元素为 pair<Key, T>
+template <class T>
+struct flat_storage
+{
+  typedef flat_value_traits<T>                       value_traits;
+  typedef typename value_traits::key_type            key_type;
+  typedef typename value_traits::mapped_type         mapped_type;
+  typedef typename value_traits::value_type          value_type;
+
+  typedef mystl::vector<value_type>                  container_type;
+  typedef typename container_type::size_type         size_type;
+  typedef typename container_type::pointer           pointer;
+  typedef typename container_type::const_pointer     const_pointer;
+  typedef typename container_type::reference         reference;
+  typedef typename container_type::const_reference   const_reference;
+  typedef typename container_type::iterator          iterator;
+  typedef typename container_type::const_iterator    const_iterator;
+
+  container_type data;
+
+  const key_type& key(size_type i)    const { return value_traits::get_key(data[i]); }
+  mapped_type&    mapped(size_type i)       { return data[i].second; }
+
+  iterator        begin()        noexcept { return data.begin(); }
+  const_iterator  begin()  const noexcept { return data.begin(); }
+  iterator        end()          noexcept { return data.end(); }
+  const_iterator  end()    const noexcept { return data.end(); }
+
+  size_type       size()     const noexcept { return data.size(); }
+  size_type       max_size() const noexcept { return data.max_size(); }
+  size_type       capacity() const noexcept { return data.capacity(); }
+  void            reserve(size_type n)      { data.reserve(n); }
+  void            shrink_to_fit()           { data.shrink_to_fit(); }
+  void            clear()                   { data.clear(); }
+  void            swap(flat_storage& rhs) noexcept { data.swap(rhs.data); }
+
+  template <class ...Args>
+  void emplace_back(Args&& ...args)
+  { data.emplace_back(mystl::forward<Args>(args)...); }
+
+  void insert_at(size_type i, const value_type& value)
+  { data.insert(data.begin() + i, value); }
+  void insert_at(size_type i, value_type&& value)
+  { data.insert(data.begin() + i, mystl::move(value)); }
+
+  void erase(size_type first, size_type last)
+  { data.erase(data.begin() + first, data.begin() + last); }
+
+  // 把第 i 个元素移动到 dst 的尾部
+  void move_to(size_type i, flat_storage& dst)
+  { dst.data.push_back(mystl::move(data[i])); }
+};
+
+// flat_split_storage 的迭代器，解引用得到 pair<const Key&, T&>
+template <class Key, class T, bool IsConst>
+struct flat_split_iterator
+{
+  typedef typename std::conditional<IsConst, const T, T>::type mapped_cv_type;
+
+  typedef mystl::random_access_iterator_tag           iterator_category;
+  typedef mystl::pair<Key, T>                         value_type;
+  typedef ptrdiff_t                                   difference_type;
+  typedef mystl::pair<const Key&, mapped_cv_type&>    reference;
+  typedef flat_split_iterator<Key, T, IsConst>        self;
+
+  // operator-> 返回的代理对象
+  struct pointer
+  {
+    reference ref;
+    const reference* operator->() const { return &ref; }
+  };
+
+  const Key*      key;    // 指向键值
+  mapped_cv_type* value;  // 指向实值
+
+  flat_split_iterator() :key(nullptr), value(nullptr) {}
+  flat_split_iterator(const Key* k, mapped_cv_type* v) :key(k), value(v) {}
+  // 非 const 迭代器可以转换为 const 迭代器
+  template <bool B, typename std::enable_if<IsConst && !B, int>::type = 0>
+  flat_split_iterator(const flat_split_iterator<Key, T, B>& rhs)
+    :key(rhs.key), value(rhs.value)
+  {
+  }
+
+  reference operator*()  const { return reference(*key, *value); }
+  pointer   operator->() const { return pointer{ operator*() }; }
+  reference operator[](difference_type n) const { return *(*this + n); }
+
+  self& operator++()    { ++key; ++value; return *this; }
+  self  operator++(int) { self tmp = *this; ++*this; return tmp; }
+  self& operator--()    { --key; --value; return *this; }
+  self  operator--(int) { self tmp = *this; --*this; return tmp; }
+
+  self& operator+=(difference_type n) { key += n; value += n; return *this; }
+  self& operator-=(difference_type n) { key -= n; value -= n; return *this; }
+  self  operator+(difference_type n) const { self tmp = *this; return tmp += n; }
+  self  operator-(difference_type n) const { self tmp = *this; return tmp -= n; }
+  friend self operator+(difference_type n, const self& it) { return it + n; }
+
+  difference_type operator-(const self& rhs) const { return key - rhs.key; }
+
+  bool operator==(const self& rhs) const { return key == rhs.key; }
+  bool operator!=(const self& rhs) const { return key != rhs.key; }
+  bool operator< (const self& rhs) const { return key <  rhs.key; }
+  bool operator> (const self& rhs) const { return key >  rhs.key; }
+  bool operator<=(const self& rhs) const { return key <= rhs.key; }
+  bool operator>=(const self& rhs) const { return key >= rhs.key; }
+};
+
+// 模板类 flat_split_storage
+// 键值与实值分别存放在两个 vector 中，查找时只访问键值数组，缓存更友好，适合实值较大的 map
+template <class Key, class T>
+struct flat_split_storage
+{
+  typedef flat_value_traits<mystl::pair<Key, T>>      value_traits;
+  typedef Key                                         key_type;
+  typedef T                                           mapped_type;
+  typedef mystl::pair<Key, T>                         value_type;
+
+  typedef mystl::vector<Key>                          key_container_type;
+  typedef mystl::vector<T>                            mapped_container_type;
+  typedef typename key_container_type::size_type      size_type;
+  typedef flat_split_iterator<Key, T, false>          iterator;
+  typedef flat_split_iterator<Key, T, true>           const_iterator;
+  typedef typename iterator::pointer                  pointer;
+  typedef typename const_iterator::pointer            const_pointer;
+  typedef typename iterator::reference                reference;
+  typedef typename const_iterator::reference          const_reference;
+
+  key_container_type    keys;
+  mapped_container_type values;
+
+  const key_type& key(size_type i)    const { return keys[i]; }
+  mapped_type&    mapped(size_type i)       { return values[i]; }
+
+  iterator        begin()        noexcept { return iterator(keys.begin(), values.begin()); }
+  const_iterator  begin()  const noexcept { return const_iterator(keys.begin(), values.begin()); }
+  iterator        end()          noexcept { return iterator(keys.end(), values.end()); }
+  const_iterator  end()    const noexcept { return const_iterator(keys.end(), values.end()); }
+
+  size_type       size()     const noexcept { return keys.size(); }
+  size_type       max_size() const noexcept { return mystl::min(keys.max_size(), values.max_size()); }
+  size_type       capacity() const noexcept { return keys.capacity(); }
+  void            reserve(size_type n)      { keys.reserve(n); values.reserve(n); }
+  void            shrink_to_fit()           { keys.shrink_to_fit(); values.shrink_to_fit(); }
+  void            clear()                   { keys.clear(); values.clear(); }
+  void            swap(flat_split_storage& rhs) noexcept
+  {
+    keys.swap(rhs.keys);
+    values.swap(rhs.values);
+  }
+
+  template <class ...Args>
+  void emplace_back(Args&& ...args)
+  {
+    value_type value(mystl::forward<Args>(args)...);
+    keys.push_back(mystl::move(value.first));
+    try
+    {
+      values.push_back(mystl::move(value.second));
+    }
+    catch (...)
+    {
+      keys.pop_back();
+      throw;
+    }
+  }
+
+  void insert_at(size_type i, const value_type& value)
+  {
+    keys.insert(keys.begin() + i, value.first);
+    try
+    {
+      values.insert(values.begin() + i, value.second);
+    }
+    catch (...)
+    {
+      keys.erase(keys.begin() + i);
+      throw;
+    }
+  }
+  void insert_at(size_type i, value_type&& value)
+  {
+    keys.insert(keys.begin() + i, mystl::move(value.first));
+    try
+    {
+      values.insert(values.begin() + i, mystl::move(value.second));
+    }
+    catch (...)
+    {
+      keys.erase(keys.begin() + i);
+      throw;
+    }
+  }
+
+  void erase(size_type first, size_type last)
+  {
+    keys.erase(keys.begin() + first, keys.begin() + last);
+    values.erase(values.begin() + first, values.begin() + last);
+  }
+
+  // 把第 i 个元素移动到 dst 的尾部
+  void move_to(size_type i, flat_split_storage& dst)
+  {
+    dst.keys.push_back(mystl::move(keys[i]));
+    dst.values.push_back(mystl::move(values[i]));
+  }
+};
+
+// 模板类 flat_tree
+// 参数一代表存储方式，参数二代表键值比较方式
+template <class Storage, class Compare>
+class flat_tree
+{
+public:
+  // flat_tree 的嵌套型别定义
+
+  typedef Storage                                    storage_type;
+  typedef typename storage_type::key_type            key_type;
+  typedef typename storage_type::mapped_type         mapped_type;
+  typedef typename storage_type::value_type          value_type;
+  typedef Compare                                    key_compare;
+
+  typedef mystl::allocator<value_type>               allocator_type;
+
+  typedef typename storage_type::pointer             pointer;
+  typedef typename storage_type::const_pointer       const_pointer;
+  typedef typename storage_type::reference           reference;
+  typedef typename storage_type::const_reference     const_reference;
+  typedef typename storage_type::iterator            iterator;
+  typedef typename storage_type::const_iterator      const_iterator;
+  typedef mystl::reverse_iterator<iterator>          reverse_iterator;
+  typedef mystl::reverse_iterator<const_iterator>    const_reverse_iterator;
+  typedef size_t                                     size_type;
+  typedef ptrdiff_t                                  difference_type;
+
+  allocator_type get_allocator() const { return allocator_type(); }
+  key_compare    key_comp()      const { return key_comp_; }
+
+private:
+  storage_type data_;      // 按键值有序存放的元素
+  key_compare  key_comp_;  // 键值的比较准则
+
+public:
+  // 构造、复制、析构函数由编译器生成
+
+  // 迭代器相关操作
+
+  iterator               begin()         noexcept
+  { return data_.begin(); }
+  const_iterator         begin()   const noexcept
+  { return data_.begin(); }
+  iterator               end()           noexcept
+  { return data_.end(); }
+  const_iterator         end()     const noexcept
+  { return data_.end(); }
+
+  reverse_iterator       rbegin()        noexcept
+  { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin()  const noexcept
+  { return const_reverse_iterator(end()); }
+  reverse_iterator       rend()          noexcept
+  { return reverse_iterator(begin()); }
+  const_reverse_iterator rend()    const noexcept
+  { return const_reverse_iterator(begin()); }
+
+  const_iterator         cbegin()  const noexcept
+  { return begin(); }
+  const_iterator         cend()    const noexcept
+  { return end(); }
+  const_reverse_iterator crbegin() const noexcept
+  { return rbegin(); }
+  const_reverse_iterator crend()   const noexcept
+  { return rend(); }
+
+  // 容量相关操作
+
+  bool      empty()    const noexcept { return data_.size() == 0; }
+  size_type size()     const noexcept { return data_.size(); }
+  size_type max_size() const noexcept { return data_.max_size(); }
+  size_type capacity() const noexcept { return data_.capacity(); }
+
+  void      reserve(size_type n)      { data_.reserve(n); }
+  void      shrink_to_fit()           { data_.shrink_to_fit(); }
+
+  // 插入删除相关操作
+
+  // emplace
+
+  template <class ...Args>
+  iterator  emplace_multi(Args&& ...args);
+
+  template <class ...Args>
+  mystl::pair<iterator, bool> emplace_unique(Args&& ...args);
+
+  template <class ...Args>
+  iterator  emplace_multi_use_hint(const_iterator hint, Args&& ...args);
+
+  template <class ...Args>
+  iterator  emplace_unique_use_hint(const_iterator hint, Args&& ...args);
+
+  // 键值不存在时才构造元素，仅用于 map 类容器
+  template <class K, class ...Args>
+  mystl::pair<iterator, bool> try_emplace_unique(K&& key, Args&& ...args);
+
+  // 键值存在时对实值赋值，否则插入新元素，仅用于 map 类容器
+  template <class K, class M>
+  mystl::pair<iterator, bool> insert_or_assign_unique(K&& key, M&& obj);
+
+  // insert
+
+  iterator  insert_multi(const value_type& value)
+  { return emplace_multi(value); }
+  iterator  insert_multi(value_type&& value)
+  { return emplace_multi(mystl::move(value)); }
+
+  iterator  insert_multi(const_iterator hint, const value_type& value)
+  { return emplace_multi_use_hint(hint, value); }
+  iterator  insert_multi(const_iterator hint, value_type&& value)
+  { return emplace_multi_use_hint(hint, mystl::move(value)); }
+
+  mystl::pair<iterator, bool> insert_unique(const value_type& value)
+  { return emplace_unique(value); }
+  mystl::pair<iterator, bool> insert_unique(value_type&& value)
+  { return emplace_unique(mystl::move(value)); }
+
+  iterator  insert_unique(const_iterator hint, const value_type& value)
+  { return emplace_unique_use_hint(hint, value); }
+  iterator  insert_unique(const_iterator hint, value_type&& value)
+  { return emplace_unique_use_hint(hint, mystl::move(value)); }
+
+  // 批量插入，先把新元素追加到尾部，再排序并与已有元素归并
+  template <class InputIterator>
+  void      insert_multi(InputIterator first, InputIterator last)
+  { insert_range(first, last, false, false); }
+  template <class InputIterator>
+  void      insert_multi(mystl::sorted_equivalent_tag, InputIterator first, InputIterator last)
+  { insert_range(first, last, false, true); }
+
+  template <class InputIterator>
+  void      insert_unique(InputIterator first, InputIterator last)
+  { insert_range(first, last, true, false); }
+  template <class InputIterator>
+  void      insert_unique(mystl::sorted_unique_tag, InputIterator first, InputIterator last)
+  { insert_range(first, last, true, true); }
+
+  // erase
+
+  iterator  erase(const_iterator position);
+  iterator  erase(const_iterator first, const_iterator last);
+
+  size_type erase_multi(const key_type& key);
+  size_type erase_unique(const key_type& key);
+
+  void      clear() { data_.clear(); }
+
+  // flat_tree 相关操作
+
+  iterator       find(const key_type& key);
+  const_iterator find(const key_type& key) const;
+
+  size_type      count_multi(const key_type& key) const
+  { return upper_bound_index(key) - lower_bound_index(key); }
+  size_type      count_unique(const key_type& key) const
+  { return find(key) != end() ? 1 : 0; }
+
+  iterator       lower_bound(const key_type& key)
+  { return begin() + lower_bound_index(key); }
+  const_iterator lower_bound(const key_type& key) const
+  { return begin() + lower_bound_index(key); }
+
+  iterator       upper_bound(const key_type& key)
+  { return begin() + upper_bound_index(key); }
+  const_iterator upper_bound(const key_type& key) const
+  { return begin() + upper_bound_index(key); }
+
+  mystl::pair<iterator, iterator>
+  equal_range_multi(const key_type& key)
+  { return mystl::pair<iterator, iterator>(lower_bound(key), upper_bound(key)); }
+  mystl::pair<const_iterator, const_iterator>
+  equal_range_multi(const key_type& key) const
+  { return mystl::pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key)); }
+
+  mystl::pair<iterator, iterator>
+  equal_range_unique(const key_type& key)
+  {
+    iterator it = find(key);
+    auto next = it;
+    return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+  }
+  mystl::pair<const_iterator, const_iterator>
+  equal_range_unique(const key_type& key) const
+  {
+    const_iterator it = find(key);
+    auto next = it;
+    return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
+  }
+
+  void swap(flat_tree& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      data_.swap(rhs.data_);
+      mystl::swap(key_comp_, rhs.key_comp_);
+    }
+  }
+
+private:
+  // 查找相关
+  size_type lower_bound_index(const key_type& key) const;
+  size_type upper_bound_index(const key_type& key) const;
+  size_type index_of(const_iterator it) const
+  { return static_cast<size_type>(it - begin()); }
+
+  // emplace unique
+  template <class ...Args>
+  mystl::pair<iterator, bool> emplace_unique_key(mystl::m_true_type, Args&& ...args);
+  template <class ...Args>
+  mystl::pair<iterator, bool> emplace_unique_key(mystl::m_false_type, Args&& ...args);
+
+  // 从 emplace 的参数中取得键值
+  template <class Arg>
+  static const key_type& extract_key(const Arg& arg)
+  { return storage_type::value_traits::get_key(arg); }
+  template <class Arg1, class Arg2>
+  static const key_type& extract_key(const Arg1& key, const Arg2&)
+  { return key; }
+
+  // bulk insert
+  template <class InputIterator>
+  void      insert_range(InputIterator first, InputIterator last, bool unique, bool sorted);
+  void      merge_tail(size_type old_size, bool unique, bool sorted);
+};
+
+/*****************************************************************************************/
+
+// 就地构造元素，键值允许重复，插入到键值相等的元素之后
+// 强异常安全保证
+template <class Storage, class Compare>
+template <class ...Args>
+typename flat_tree<Storage, Compare>::iterator
+flat_tree<Storage, Compare>::
+emplace_multi(Args&& ...args)
+{
+  value_type value(mystl::forward<Args>(args)...);
+  const size_type pos = upper_bound_index(extract_key(value));
+  data_.insert_at(pos, mystl::move(value));
+  return begin() + pos;
+}
+
+// 就地构造元素，键值不允许重复
+// 能够直接从参数中取得键值时，先查找该键值，键值已经存在时不会构造元素
+// 强异常安全保证
+template <class Storage, class Compare>
+template <class ...Args>
+mystl::pair<typename flat_tree<Storage, Compare>::iterator, bool>
+flat_tree<Storage, Compare>::
+emplace_unique(Args&& ...args)
+{
+  return emplace_unique_key(mystl::can_extract_key<key_type, value_type, Args...>{},
+                            mystl::forward<Args>(args)...);
+}
+
+// emplace_unique_key 函数
+template <class Storage, class Compare>
+template <class ...Args>
+mystl::pair<typename flat_tree<Storage, Compare>::iterator, bool>
+flat_tree<Storage, Compare>::
+emplace_unique_key(mystl::m_true_type, Args&& ...args)
+{
+  const key_type& key = extract_key(args...);
+  const size_type pos = lower_bound_index(key);
+  if (pos != size() && !key_comp_(key, data_.key(pos)))
+    return mystl::make_pair(begin() + pos, false);
+  data_.insert_at(pos, value_type(mystl::forward<Args>(args)...));
+  return mystl::make_pair(begin() + pos, true);
+}
+
+template <class Storage, class Compare>
+template <class ...Args>
+mystl::pair<typename flat_tree<Storage, Compare>::iterator, bool>
+flat_tree<Storage, Compare>::
+emplace_unique_key(mystl::m_false_type, Args&& ...args)
+{
+  value_type value(mystl::forward<Args>(args)...);
+  const size_type pos = lower_bound_index(extract_key(value));
+  if (pos != size() && !key_comp_(extract_key(value), data_.key(pos)))
+    return mystl::make_pair(begin() + pos, false);
+  data_.insert_at(pos, mystl::move(value));
+  return mystl::make_pair(begin() + pos, true);
+}
+
+// 就地构造元素，键值允许重复，hint 位置正确时可以省去查找
+template <class Storage, class Compare>
+template <class ...Args>
+typename flat_tree<Storage, Compare>::iterator
+flat_tree<Storage, Compare>::
+emplace_multi_use_hint(const_iterator hint, Args&& ...args)
+{
+  value_type value(mystl::forward<Args>(args)...);
+  const auto& key = extract_key(value);
+  size_type pos = index_of(hint);
+  if ((pos != 0 && key_comp_(key, data_.key(pos - 1))) ||
+      (pos != size() && key_comp_(data_.key(pos), key)))
+  { // hint 位置不正确
+    pos = upper_bound_index(key);
+  }
+  data_.insert_at(pos, mystl::move(value));
+  return begin() + pos;
+}
+
+// 就地构造元素，键值不允许重复，hint 位置正确时可以省去查找
+template <class Storage, class Compare>
+template <class ...Args>
+typename flat_tree<Storage, Compare>::iterator
+flat_tree<Storage, Compare>::
+emplace_unique_use_hint(const_iterator hint, Args&& ...args)
+{
+  value_type value(mystl::forward<Args>(args)...);
+  const auto& key = extract_key(value);
+  size_type pos = index_of(hint);
+  if ((pos != 0 && !key_comp_(data_.key(pos - 1), key)) ||
+      (pos != size() && !key_comp_(key, data_.key(pos))))
+  { // hint 位置不正确或者键值重复
+    pos = lower_bound_index(key);
+    if (pos != size() && !key_comp_(key, data_.key(pos)))
+      return begin() + pos;
+  }
+  data_.insert_at(pos, mystl::move(value));
+  return begin() + pos;
+}
+
+// 键值不存在时，以 key 和由 args 构造的实值插入新元素，否则什么也不做
+template <class Storage, class Compare>
+template <class K, class ...Args>
+mystl::pair<typename flat_tree<Storage, Compare>::iterator, bool>
+flat_tree<Storage, Compare>::
+try_emplace_unique(K&& key, Args&& ...args)
+{
+  const size_type pos = lower_bound_index(key);
+  if (pos != size() && !key_comp_(key, data_.key(pos)))
+    return mystl::make_pair(begin() + pos, false);
+  data_.insert_at(pos, value_type(mystl::piecewise_second, mystl::forward<K>(key),
+                                  mystl::forward<Args>(args)...));
+  return mystl::make_pair(begin() + pos, true);
+}
+
+// 键值存在时，把 obj 赋值给它的实值，否则以 key 和 obj 插入新元素
+template <class Storage, class Compare>
+template <class K, class M>
+mystl::pair<typename flat_tree<Storage, Compare>::iterator, bool>
+flat_tree<Storage, Compare>::
+insert_or_assign_unique(K&& key, M&& obj)
+{
+  const size_type pos = lower_bound_index(key);
+  if (pos != size() && !key_comp_(key, data_.key(pos)))
+  {
+    data_.mapped(pos) = mystl::forward<M>(obj);
+    return mystl::make_pair(begin() + pos, false);
+  }
+  data_.insert_at(pos, value_type(mystl::forward<K>(key), mystl::forward<M>(obj)));
+  return mystl::make_pair(begin() + pos, true);
+}
+
+// 删除 position 位置的元素，返回指向下一个元素的迭代器
+template <class Storage, class Compare>
+typename flat_tree<Storage, Compare>::iterator
+flat_tree<Storage, Compare>::
+erase(const_iterator position)
+{
+  const size_type pos = index_of(position);
+  MYSTL_DEBUG(pos < size());
+  data_.erase(pos, pos + 1);
+  return begin() + pos;
+}
+
+// 删除[first, last)区间内的元素
+template <class Storage, class Compare>
+typename flat_tree<Storage, Compare>::iterator
+flat_tree<Storage, Compare>::
+erase(const_iterator first, const_iterator last)
+{
+  const size_type pos = index_of(first);
+  data_.erase(pos, index_of(last));
+  return begin() + pos;
+}
+
+// 删除键值等于 key 的元素，返回删除的个数
+template <class Storage, class Compare>
+typename flat_tree<Storage, Compare>::size_type
+flat_tree<Storage, Compare>::
+erase_multi(const key_type& key)
+{
+  const size_type first = lower_bound_index(key);
+  const size_type last = upper_bound_index(key);
+  data_.erase(first, last);
+  return last - first;
+}
+
+// 删除键值等于 key 的元素，返回删除的个数
+template <class Storage, class Compare>
+typename flat_tree<Storage, Compare>::size_type
+flat_tree<Storage, Compare>::
+erase_unique(const key_type& key)
+{
+  const size_type pos = lower_bound_index(key);
+  if (pos != size() && !key_comp_(key, data_.key(pos)))
+  {
+    data_.erase(pos, pos + 1);
+    return 1;
+  }
+  return 0;
+}
+
+// 查找键值为 key 的元素，返回指向它的迭代器
+template <class Storage, class Compare>
+typename flat_tree<Storage, Compare>::iterator
+flat_tree<Storage, Compare>::
+find(const key_type& key)
+{
+  const size_type pos = lower_bound_index(key);
+  return (pos == size() || key_comp_(key, data_.key(pos))) ? end() : begin() + pos;
+}
+
+template <class Storage, class Compare>
+typename flat_tree<Storage, Compare>::const_iterator
+flat_tree<Storage, Compare>::
+find(const key_type& key) const
+{
+  const size_type pos = lower_bound_index(key);
+  return (pos == size() || key_comp_(key, data_.key(pos))) ? end() : begin() + pos;
+}
+
+// 二分查找第一个不小于 key 的元素的位置
+template <class Storage, class Compare>
+typename flat_tree<Storage, Compare>::size_type
+flat_tree<Storage, Compare>::
+lower_bound_index(const key_type& key) const
+{
+  size_type first = 0;
+  size_type len = size();
+  while (len > 0)
+  {
+    const size_type half = len >> 1;
+    if (key_comp_(data_.key(first + half), key))
+    {
+      first += half + 1;
+      len -= half + 1;
+    }
+    else
+    {
+      len = half;
+    }
+  }
+  return first;
+}
+
+// 二分查找第一个大于 key 的元素的位置
+template <class Storage, class Compare>
+typename flat_tree<Storage, Compare>::size_type
+flat_tree<Storage, Compare>::
+upper_bound_index(const key_type& key) const
+{
+  size_type first = 0;
+  size_type len = size();
+  while (len > 0)
+  {
+    const size_type half = len >> 1;
+    if (!key_comp_(key, data_.key(first + half)))
+    {
+      first += half + 1;
+      len -= half + 1;
+    }
+    else
+    {
+      len = half;
+    }
+  }
+  return first;
+}
+
+// insert_range 函数
+// 把 [first, last) 的元素追加到尾部，再与已有元素归并，追加失败时恢复原状
+template <class Storage, class Compare>
+template <class InputIterator>
+void flat_tree<Storage, Compare>::
+insert_range(InputIterator first, InputIterator last, bool unique, bool sorted)
+{
+  const size_type old_size = size();
+  try
+  {
+    for (; first != last; ++first)
+      data_.emplace_back(*first);
+  }
+  catch (...)
+  {
+    data_.erase(old_size, size());
+    throw;
+  }
+  merge_tail(old_size, unique, sorted);
+}
+
+// merge_tail 函数
+// 把 [old_size, size()) 的新元素排序后与 [0, old_size) 的已有元素归并
+// 键值相等时已有元素在前，新元素保持原来的相对顺序；unique 为 true 时只保留每个键值的第一个元素
+// 新元素本身有序且都排在已有元素之后时，不需要移动任何元素
+// 满足基本异常安全保证
+template <class Storage, class Compare>
+void flat_tree<Storage, Compare>::
+merge_tail(size_type old_size, bool unique, bool sorted)
+{
+  const size_type n = size();
+  if (n == old_size)
+    return;
+  // 检查 [old_size - 1, n) 是否有序
+  size_type i = old_size == 0 ? 1 : old_size;
+  for (; i < n; ++i)
+  {
+    if (unique ? !key_comp_(data_.key(i - 1), data_.key(i))
+               : key_comp_(data_.key(i), data_.key(i - 1)))
+      break;
+  }
+  if (i == n)
+    return;
+
+  // 对新元素的下标排序，键值相等时按下标排序，使排序是稳定的
+  mystl::vector<size_type> index;
+  index.reserve(n - old_size);
+  for (size_type j = old_size; j < n; ++j)
+    index.push_back(j);
+  if (!sorted)
+  {
+    mystl::sort(index.begin(), index.end(), [this](size_type a, size_type b)
+    {
+      return key_comp_(data_.key(a), data_.key(b)) ||
+        (!key_comp_(data_.key(b), data_.key(a)) && a < b);
+    });
+  }
+
+  // 归并到新的存储中
+  storage_type result;
+  result.reserve(n);
+  size_type old_pos = 0;
+  size_type new_pos = 0;
+  const size_type new_count = index.size();
+  while (old_pos != old_size || new_pos != new_count)
+  {
+    size_type pick;
+    if (new_pos == new_count ||
+        (old_pos != old_size && !key_comp_(data_.key(index[new_pos]), data_.key(old_pos))))
+    {
+      pick = old_pos++;
+    }
+    else
+    {
+      pick = index[new_pos++];
+    }
+    if (unique && result.size() != 0 &&
+        !key_comp_(result.key(result.size() - 1), data_.key(pick)))
+    { // 键值重复
+      continue;
+    }
+    data_.move_to(pick, result);
+  }
+  data_.swap(result);
+}
+
+// 重载比较操作符
+template <class Storage, class Compare>
+bool operator==(const flat_tree<Storage, Compare>& lhs, const flat_tree<Storage, Compare>& rhs)
+{
+  return lhs.size() == rhs.size() && mystl::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class Storage, class Compare>
+bool operator<(const flat_tree<Storage, Compare>& lhs, const flat_tree<Storage, Compare>& rhs)
+{
+  return mystl::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <class Storage, class Compare>
+bool operator!=(const flat_tree<Storage, Compare>& lhs, const flat_tree<Storage, Compare>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class Storage, class Compare>
+bool operator>(const flat_tree<Storage, Compare>& lhs, const flat_tree<Storage, Compare>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class Storage, class Compare>
+bool operator<=(const flat_tree<Storage, Compare>& lhs, const flat_tree<Storage, Compare>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class Storage, class Compare>
+bool operator>=(const flat_tree<Storage, Compare>& lhs, const flat_tree<Storage, Compare>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 重载 mystl 的 swap
+template <class Storage, class Compare>
+void swap(flat_tree<Storage, Compare>& lhs, flat_tree<Storage, Compare>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_FLAT_TREE_H_
+
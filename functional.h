@@ -4,6 +4,10 @@
 // 这个头文件包含了 mystl 的函数对象与哈希函数
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "type_traits.h"
 
 namespace mystl
 {
@@ -179,6 +183,133 @@ struct projectsecond :public binary_function<Arg1, Arg2, Arg1>
   Arg2 operator()(const Arg1&, const Arg2& y) const { return y; }
 };
 
+/*****************************************************************************************/
+// 哈希函数的基础设施
+
+// 计算 a * b 的 128 位乘积，a 为低 64 位，b 为高 64 位
+inline void hash_mul128(uint64_t& a, uint64_t& b) noexcept
+{
+#ifdef __SIZEOF_INT128__
+  const __uint128_t r = static_cast<__uint128_t>(a) * b;
+  a = static_cast<uint64_t>(r);
+  b = static_cast<uint64_t>(r >> 64);
+#else
+  // 拆成四个 32 位乘法
+  const uint64_t ha = a >> 32, hb = b >> 32;
+  const uint64_t la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+  const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const uint64_t t = rl + (rm0 << 32);
+  uint64_t carry = t < rl;
+  const uint64_t lo = t + (rm1 << 32);
+  carry += lo < t;
+  a = lo;
+  b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+// 128 位乘积的高低两半异或，是以下哈希函数的基本混合步骤
+inline uint64_t hash_mum(uint64_t a, uint64_t b) noexcept
+{
+  hash_mul128(a, b);
+  return a ^ b;
+}
+
+// 整数混合函数，输入的每一位都会影响输出的所有位，连续的整数也会被打散
+inline size_t hash_mix(uint64_t x) noexcept
+{
+  return static_cast<size_t>(hash_mum(x, 0x9e3779b97f4a7c15ull));
+}
+
+inline uint64_t hash_read8(const unsigned char* p) noexcept
+{
+  uint64_t v;
+  std::memcpy(&v, p, 8);
+  return v;
+}
+
+inline uint64_t hash_read4(const unsigned char* p) noexcept
+{
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+// 字节序列的哈希函数，参考 wyhash 的做法，每次处理 8 个字节
+inline size_t hash_bytes(const void* key, size_t len, uint64_t seed = 0) noexcept
+{
+  static constexpr uint64_t s0 = 0xa0761d6478bd642full;
+  static constexpr uint64_t s1 = 0xe7037ed1a0b428dbull;
+  static constexpr uint64_t s2 = 0x8ebc6af09c88c6e3ull;
+  static constexpr uint64_t s3 = 0x589965cc75374cc3ull;
+  const unsigned char* p = static_cast<const unsigned char*>(key);
+  seed ^= hash_mum(seed ^ s0, s1);
+  uint64_t a, b;
+  if (len <= 16)
+  {
+    if (len >= 4)
+    { // 读取首尾各两段 4 字节，覆盖全部输入
+      const size_t off = (len >> 3) << 2;
+      a = (hash_read4(p) << 32) | hash_read4(p + off);
+      b = (hash_read4(p + len - 4) << 32) | hash_read4(p + len - 4 - off);
+    }
+    else if (len > 0)
+    {
+      a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+      b = 0;
+    }
+    else
+    {
+      a = b = 0;
+    }
+  }
+  else
+  {
+    size_t i = len;
+    if (i > 48)
+    { // 三路并行，减少乘法之间的依赖
+      uint64_t see1 = seed, see2 = seed;
+      do
+      {
+        seed = hash_mum(hash_read8(p) ^ s1, hash_read8(p + 8) ^ seed);
+        see1 = hash_mum(hash_read8(p + 16) ^ s2, hash_read8(p + 24) ^ see1);
+        see2 = hash_mum(hash_read8(p + 32) ^ s3, hash_read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16)
+    {
+      seed = hash_mum(hash_read8(p) ^ s1, hash_read8(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = hash_read8(p + i - 16);
+    b = hash_read8(p + i - 8);
+  }
+  a ^= s1;
+  b ^= seed;
+  hash_mul128(a, b);
+  return static_cast<size_t>(hash_mum(a ^ s0 ^ len, b ^ s1));
+}
+
+// 把 value 的哈希值合并到 seed 中，结果与合并的顺序有关
+template <class Hash, class T>
+void hash_combine(size_t& seed, const T& value, const Hash& hasher)
+{
+  seed = hash_mix(static_cast<uint64_t>(seed) + 0x9e3779b97f4a7c15ull + hasher(value));
+}
+
+// 判断哈希函数的结果是否已经充分混合
+// 哈希函数对象中定义了 is_avalanching 型别时视为已经充分混合，容器可以直接使用其结果的任意几位，
+// 否则在需要时应当先用 hash_mix 打散
+template <class Hash, class = void>
+struct is_avalanching_hash : mystl::m_false_type {};
+
+template <class Hash>
+struct is_avalanching_hash<Hash, typename std::conditional<true, void,
+  typename Hash::is_avalanching>::type> : mystl::m_true_type {};
+
 /*****************************************************************************************/
 // 哈希函数对象
 
@@ -186,77 +317,67 @@ struct projectsecond :public binary_function<Arg1, Arg2, Arg1>
 template <class Key>
 struct hash {};
 
-// 针对指针的偏特化版本
+// 针对指针的偏特化版本，指针的低位通常为 0，需要打散
 template <class T>
 struct hash<T*>
 {
+  typedef void is_avalanching;
   size_t operator()(T* p) const noexcept
-  { return reinterpret_cast<size_t>(p); }
+  { return hash_mix(reinterpret_cast<uintptr_t>(p)); }
 };
 
-// 对于整型类型，只是返回原值
-#define MYSTL_TRIVIAL_HASH_FCN(Type)         \
+// 对于整型类型，用 hash_mix 打散，避免连续的键值在按 2 的幂取模时集中在少数 bucket 中
+#define MYSTL_INTEGRAL_HASH_FCN(Type)        \
 template <> struct hash<Type>                \
 {                                            \
+  typedef void is_avalanching;               \
   size_t operator()(Type val) const noexcept \
-  { return static_cast<size_t>(val); }       \
+  { return hash_mix(static_cast<uint64_t>(val)); } \
 };
 
-MYSTL_TRIVIAL_HASH_FCN(bool)
+MYSTL_INTEGRAL_HASH_FCN(bool)
 
-MYSTL_TRIVIAL_HASH_FCN(char)
+MYSTL_INTEGRAL_HASH_FCN(char)
 
-MYSTL_TRIVIAL_HASH_FCN(signed char)
+MYSTL_INTEGRAL_HASH_FCN(signed char)
 
-MYSTL_TRIVIAL_HASH_FCN(unsigned char)
+MYSTL_INTEGRAL_HASH_FCN(unsigned char)
 
-MYSTL_TRIVIAL_HASH_FCN(wchar_t)
+MYSTL_INTEGRAL_HASH_FCN(wchar_t)
 
-MYSTL_TRIVIAL_HASH_FCN(char16_t)
+MYSTL_INTEGRAL_HASH_FCN(char16_t)
 
-MYSTL_TRIVIAL_HASH_FCN(char32_t)
+MYSTL_INTEGRAL_HASH_FCN(char32_t)
 
-MYSTL_TRIVIAL_HASH_FCN(short)
+MYSTL_INTEGRAL_HASH_FCN(short)
 
-MYSTL_TRIVIAL_HASH_FCN(unsigned short)
+MYSTL_INTEGRAL_HASH_FCN(unsigned short)
 
-MYSTL_TRIVIAL_HASH_FCN(int)
+MYSTL_INTEGRAL_HASH_FCN(int)
 
-MYSTL_TRIVIAL_HASH_FCN(unsigned int)
+MYSTL_INTEGRAL_HASH_FCN(unsigned int)
 
-MYSTL_TRIVIAL_HASH_FCN(long)
+MYSTL_INTEGRAL_HASH_FCN(long)
 
-MYSTL_TRIVIAL_HASH_FCN(unsigned long)
+MYSTL_INTEGRAL_HASH_FCN(unsigned long)
 
-MYSTL_TRIVIAL_HASH_FCN(long long)
+MYSTL_INTEGRAL_HASH_FCN(long long)
 
-MYSTL_TRIVIAL_HASH_FCN(unsigned long long)
+MYSTL_INTEGRAL_HASH_FCN(unsigned long long)
 
-#undef MYSTL_TRIVIAL_HASH_FCN
+#undef MYSTL_INTEGRAL_HASH_FCN
 
-// 对于浮点数，逐位哈希
+// 逐字节哈希，用于浮点数和字符串
 inline size_t bitwise_hash(const unsigned char* first, size_t count)
 {
-#if (_MSC_VER && _WIN64) || ((__GNUC__ || __clang__) &&__SIZEOF_POINTER__ == 8)
-  const size_t fnv_offset = 14695981039346656037ull;
-  const size_t fnv_prime = 1099511628211ull;
-#else
-  const size_t fnv_offset = 2166136261u;
-  const size_t fnv_prime = 16777619u;
-#endif
-  size_t result = fnv_offset;
-  for (size_t i = 0; i < count; ++i)
-  {
-    result ^= (size_t)first[i];
-    result *= fnv_prime;
-  }
-  return result;
+  return hash_bytes(first, count);
 }
 
 template <>
 struct hash<float>
 {
-  size_t operator()(const float& val)
+  typedef void is_avalanching;
+  size_t operator()(const float& val) const noexcept
   { 
     return val == 0.0f ? 0 : bitwise_hash((const unsigned char*)&val, sizeof(float));
   }
@@ -265,7 +386,8 @@ struct hash<float>
 template <>
 struct hash<double>
 {
-  size_t operator()(const double& val)
+  typedef void is_avalanching;
+  size_t operator()(const double& val) const noexcept
   {
     return val == 0.0f ? 0 : bitwise_hash((const unsigned char*)&val, sizeof(double));
   }
@@ -274,12 +396,114 @@ struct hash<double>
 template <>
 struct hash<long double>
 {
-  size_t operator()(const long double& val)
+  typedef void is_avalanching;
+  size_t operator()(const long double& val) const noexcept
   {
     return val == 0.0f ? 0 : bitwise_hash((const unsigned char*)&val, sizeof(long double));
   }
 };
 
+// 使用 mystl::hash 合并哈希值
+template <class T>
+void hash_combine(size_t& seed, const T& value)
+{
+  hash_combine(seed, value, mystl::hash<T>());
+}
+
+/*****************************************************************************************/
+// 组合键的哈希
+
+// 整数、枚举和指针可以直接转换为 64 位整数，多个这样的值可以放在一起做一次 hash_bytes
+template <class T>
+struct hash_is_packable
+  :mystl::m_bool_constant<std::is_integral<T>::value ||
+                          std::is_enum<T>::value ||
+                          std::is_pointer<T>::value>
+{
+};
+
+template <class ...Args>
+struct hash_all_packable;
+
+template <>
+struct hash_all_packable<> :mystl::m_true_type {};
+
+template <class Arg, class ...Args>
+struct hash_all_packable<Arg, Args...>
+  :mystl::m_bool_constant<hash_is_packable<Arg>::value && hash_all_packable<Args...>::value>
+{
+};
+
+template <class T>
+uint64_t hash_pack(const T& value, mystl::m_false_type /* not pointer */) noexcept
+{ return static_cast<uint64_t>(value); }
+
+template <class T>
+uint64_t hash_pack(const T& value, mystl::m_true_type /* pointer */) noexcept
+{ return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)); }
+
+template <class T>
+uint64_t hash_pack(const T& value) noexcept
+{ return hash_pack(value, mystl::m_bool_constant<std::is_pointer<T>::value>()); }
+
+template <class ...Args>
+size_t hash_values_imp(mystl::m_true_type, const Args&... args) noexcept
+{ // 全部可以打包时，放入连续的缓冲区，每次处理 8 个字节
+  const uint64_t buf[] = { hash_pack(args)... };
+  return hash_bytes(buf, sizeof(buf));
+}
+
+template <class ...Args>
+size_t hash_values_imp(mystl::m_false_type, const Args&... args)
+{ // 否则逐个合并各自的哈希值
+  size_t seed = 0;
+  const int expand[] = { (hash_combine(seed, args), 0)... };
+  (void)expand;
+  return seed;
+}
+
+// 计算多个值组成的组合键的哈希值，结果与参数的顺序有关
+template <class Arg, class ...Args>
+size_t hash_values(const Arg& arg, const Args&... args)
+{
+  return hash_values_imp(mystl::m_bool_constant<hash_all_packable<Arg, Args...>::value>(),
+                         arg, args...);
+}
+
+// 计算 [first, last) 中所有元素组成的序列的哈希值
+template <class InputIter>
+size_t hash_range(InputIter first, InputIter last)
+{
+  size_t seed = 0;
+  for (; first != last; ++first)
+    hash_combine(seed, *first);
+  return seed;
+}
+
+// 整数数组直接按字节哈希
+template <class T>
+typename std::enable_if<std::is_integral<T>::value, size_t>::type
+hash_range(const T* first, const T* last) noexcept
+{
+  return hash_bytes(first, static_cast<size_t>(last - first) * sizeof(T));
+}
+
+template <class T>
+typename std::enable_if<std::is_integral<T>::value, size_t>::type
+hash_range(T* first, T* last) noexcept
+{
+  return hash_bytes(first, static_cast<size_t>(last - first) * sizeof(T));
+}
+
+// 针对定长数组的偏特化版本
+template <class T, size_t N>
+struct hash<T[N]>
+{
+  typedef void is_avalanching;
+  size_t operator()(const T (&arr)[N]) const
+  { return hash_range(arr, arr + N); }
+};
+
 } // namespace mystl
 #endif // !MYTINYSTL_FUNCTIONAL_H_
 
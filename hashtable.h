@@ -7,18 +7,47 @@
 #include <initializer_list>
 
 #include "algo.h"
+#include "bloom_filter.h"
 #include "functional.h"
 #include "memory.h"
-#include "vector.h"
 #include "util.h"
 #include "exceptdef.h"
+#include "node_handle.h"
 
 namespace mystl
 {
 
+template <class T>
+struct ht_value_traits;
+
+// 是否在 hashtable 的节点中缓存键值的哈希值
+// 缓存之后，rehash 时不需要重新计算哈希值，查找时可以先比较哈希值再比较键值
+// 对于整数、指针等计算哈希值代价很低的键值默认不缓存，其余类型（例如 basic_string）默认缓存，
+// 可以通过特化 ht_cache_hash 来改变某种键值类型的行为
+template <class Key>
+struct ht_cache_hash
+  :mystl::m_bool_constant<!(std::is_arithmetic<Key>::value ||
+                            std::is_enum<Key>::value ||
+                            std::is_pointer<Key>::value)>
+{
+};
+
+// 节点中保存的哈希值，不缓存时不占用空间
+template <bool Cache>
+struct ht_node_hash_code
+{
+  size_t hash_code;  // 键值的哈希值
+};
+
+template <>
+struct ht_node_hash_code<false>
+{
+};
+
 // hashtable 的节点定义
 template <class T>
 struct hashtable_node
+  :public ht_node_hash_code<ht_cache_hash<typename ht_value_traits<T>::key_type>::value>
 {
   hashtable_node* next;   // 指向下一个节点
   T               value;  // 储存实值
@@ -110,10 +139,10 @@ struct ht_iterator;
 template <class T, class HashFun, class KeyEqual>
 struct ht_const_iterator;
 
-template <class T>
+template <class T, class HashFun, class KeyEqual>
 struct ht_local_iterator;
 
-template <class T>
+template <class T, class HashFun, class KeyEqual>
 struct ht_const_local_iterator;
 
 // ht_iterator
@@ -202,14 +231,7 @@ struct ht_iterator :public ht_iterator_base<T, Hash, KeyEqual>
   iterator& operator++()
   {
     MYSTL_DEBUG(node != nullptr);
-    const node_ptr old = node;
     node = node->next;
-    if (node == nullptr)
-    { // 如果下一个位置为空，跳到下一个 bucket 的起始处
-      auto index = ht->hash(value_traits::get_key(old->value));
-      while (!node && ++index < ht->bucket_size_)
-        node = ht->buckets_[index];
-    }
     return *this;
   }
   iterator operator++(int)
@@ -256,11 +278,8 @@ struct ht_const_iterator :public ht_iterator_base<T, Hash, KeyEqual>
   }
   const_iterator& operator=(const iterator& rhs)
   {
-    if (this != &rhs)
-    {
-      node = rhs.node;
-      ht = rhs.ht;
-    }
+    node = rhs.node;
+    ht = rhs.ht;
     return *this;
   }
   const_iterator& operator=(const const_iterator& rhs)
@@ -280,16 +299,7 @@ struct ht_const_iterator :public ht_iterator_base<T, Hash, KeyEqual>
   const_iterator& operator++()
   {
     MYSTL_DEBUG(node != nullptr);
-    const node_ptr old = node;
     node = node->next;
-    if (node == nullptr)
-    { // 如果下一个位置为空，跳到下一个 bucket 的起始处
-      auto index = ht->hash(value_traits::get_key(old->value));
-      while (!node && ++index < ht->bucket_size_)
-      {
-        node = ht->buckets_[index];
-      }
-    }
     return *this;
   }
   const_iterator operator++(int)
@@ -301,31 +311,36 @@ struct ht_const_iterator :public ht_iterator_base<T, Hash, KeyEqual>
 };
 
 // local iterator
-template <class T>
+// 所有节点串成一条链表，local iterator 需要借助容器判断下一个节点是否还在当前 bucket 中
+template <class T, class Hash, class KeyEqual>
 struct ht_local_iterator :public mystl::iterator<mystl::forward_iterator_tag, T>
 {
-  typedef T                          value_type;
-  typedef value_type*                pointer;
-  typedef value_type&                reference;
-  typedef size_t                     size_type;
-  typedef ptrdiff_t                  difference_type;
-  typedef hashtable_node<T>*         node_ptr;
+  typedef T                                          value_type;
+  typedef value_type*                                pointer;
+  typedef value_type&                                reference;
+  typedef size_t                                     size_type;
+  typedef ptrdiff_t                                  difference_type;
+  typedef hashtable_node<T>*                         node_ptr;
+  typedef const mystl::hashtable<T, Hash, KeyEqual>* contain_ptr;
+
+  typedef ht_local_iterator<T, Hash, KeyEqual>       self;
+  typedef ht_local_iterator<T, Hash, KeyEqual>       local_iterator;
+  typedef ht_const_local_iterator<T, Hash, KeyEqual> const_local_iterator;
 
-  typedef ht_local_iterator<T>       self;
-  typedef ht_local_iterator<T>       local_iterator;
-  typedef ht_const_local_iterator<T> const_local_iterator;
-  node_ptr node;
+  node_ptr    node;    // 迭代器当前所指节点
+  contain_ptr ht;      // 保持与容器的连结
+  size_type   bucket;  // 所在 bucket 的编号
 
-  ht_local_iterator(node_ptr n)
-    :node(n)
+  ht_local_iterator(node_ptr n, contain_ptr t, size_type b)
+    :node(n), ht(t), bucket(b)
   {
   }
   ht_local_iterator(const local_iterator& rhs)
-    :node(rhs.node)
+    :node(rhs.node), ht(rhs.ht), bucket(rhs.bucket)
   {
   }
   ht_local_iterator(const const_local_iterator& rhs)
-    :node(rhs.node)
+    :node(rhs.node), ht(rhs.ht), bucket(rhs.bucket)
   {
   }
 
@@ -335,7 +350,7 @@ struct ht_local_iterator :public mystl::iterator<mystl::forward_iterator_tag, T>
   self& operator++()
   {
     MYSTL_DEBUG(node != nullptr);
-    node = node->next;
+    node = ht->local_next(node, bucket);
     return *this;
   }
   
@@ -350,32 +365,35 @@ struct ht_local_iterator :public mystl::iterator<mystl::forward_iterator_tag, T>
   bool operator!=(const self& other) const { return node != other.node; }
 };
 
-template <class T>
+template <class T, class Hash, class KeyEqual>
 struct ht_const_local_iterator :public mystl::iterator<mystl::forward_iterator_tag, T>
 {
-  typedef T                          value_type;
-  typedef const value_type*          pointer;
-  typedef const value_type&          reference;
-  typedef size_t                     size_type;
-  typedef ptrdiff_t                  difference_type;
-  typedef const hashtable_node<T>*   node_ptr;
+  typedef T                                          value_type;
+  typedef const value_type*                          pointer;
+  typedef const value_type&                          reference;
+  typedef size_t                                     size_type;
+  typedef ptrdiff_t                                  difference_type;
+  typedef const hashtable_node<T>*                   node_ptr;
+  typedef const mystl::hashtable<T, Hash, KeyEqual>* contain_ptr;
 
-  typedef ht_const_local_iterator<T> self;
-  typedef ht_local_iterator<T>       local_iterator;
-  typedef ht_const_local_iterator<T> const_local_iterator;
+  typedef ht_const_local_iterator<T, Hash, KeyEqual> self;
+  typedef ht_local_iterator<T, Hash, KeyEqual>       local_iterator;
+  typedef ht_const_local_iterator<T, Hash, KeyEqual> const_local_iterator;
 
-  node_ptr node;
+  node_ptr    node;
+  contain_ptr ht;
+  size_type   bucket;
 
-  ht_const_local_iterator(node_ptr n)
-    :node(n)
+  ht_const_local_iterator(node_ptr n, contain_ptr t, size_type b)
+    :node(n), ht(t), bucket(b)
   {
   }
   ht_const_local_iterator(const local_iterator& rhs)
-    :node(rhs.node)
+    :node(rhs.node), ht(rhs.ht), bucket(rhs.bucket)
   {
   }
   ht_const_local_iterator(const const_local_iterator& rhs)
-    :node(rhs.node)
+    :node(rhs.node), ht(rhs.ht), bucket(rhs.bucket)
   {
   }
 
@@ -385,7 +403,7 @@ struct ht_const_local_iterator :public mystl::iterator<mystl::forward_iterator_t
   self& operator++()
   {
     MYSTL_DEBUG(node != nullptr);
-    node = node->next;
+    node = ht->local_next(node, bucket);
     return *this;
   }
 
@@ -467,6 +485,103 @@ inline size_t ht_next_prime(size_t n)
   return pos == last ? *(last - 1) : *pos;
 }
 
+// 以下函数维护 hashtable 与 intrusive_unordered_set 共用的链表布局：
+// 所有节点串成一条以 head 开头的单向链表，同一个 bucket 中的节点相邻，bucket 中保存指向其第一个节点的链接
+// 节点需要有 next 成员，code_of(node) 返回节点的哈希值，bucket_of(code) 返回哈希值为 code 的 bucket（NodePtr*&）
+
+// 把 np 链接为 bucket 的第一个节点，link 为该 bucket，bucket 为空时 np 成为整个链表的第一个节点
+template <class NodePtr, class CodeOf, class BucketOf>
+void ht_link_bucket_begin(NodePtr& head, NodePtr*& link, NodePtr np,
+                          CodeOf code_of, BucketOf bucket_of)
+{
+  if (link != nullptr)
+  {
+    np->next = *link;
+    *link = np;
+  }
+  else
+  {
+    np->next = head;
+    if (head != nullptr)  // 原来的第一个节点之前多了 np
+      bucket_of(code_of(head)) = &np->next;
+    head = np;
+    link = &head;
+  }
+}
+
+// 把 np 链接在同一个 bucket 的节点 pos 之后
+template <class NodePtr, class CodeOf, class BucketOf>
+void ht_link_after(NodePtr pos, NodePtr np, CodeOf code_of, BucketOf bucket_of)
+{
+  np->next = pos->next;
+  pos->next = np;
+  if (np->next != nullptr)
+  { // pos 原来是所在 bucket 的最后一个节点时，下一个 bucket 的链接改为 np 的 next
+    auto& link = bucket_of(code_of(np->next));
+    if (link == &pos->next)
+      link = &np->next;
+  }
+}
+
+// 从链表中摘下 prev 所指的节点并返回，同时维护它所在的 bucket 和下一个 bucket 的链接
+template <class NodePtr, class CodeOf, class BucketOf>
+NodePtr ht_unlink_node(NodePtr* prev, CodeOf code_of, BucketOf bucket_of)
+{
+  NodePtr p = *prev;
+  NodePtr next = p->next;
+  auto& link = bucket_of(code_of(p));
+  if (next != nullptr)
+  {
+    auto& next_link = bucket_of(code_of(next));
+    if (next_link == &p->next)
+    { // next 是另一个 bucket 的第一个节点
+      next_link = prev;
+      if (link == prev)  // p 是所在 bucket 唯一的节点
+        link = nullptr;
+    }
+  }
+  else if (link == prev)
+  {
+    link = nullptr;
+  }
+  *prev = next;
+  return p;
+}
+
+// 把以 first 开头、以空结尾的节点链逐个链接到 bucket 中，每个节点的哈希值只取一次，并交给 visit
+// 与上一个节点落在同一个 bucket 时接在它之后，所以相同键值的节点重新链接之后仍然相邻，且保持原来的顺序
+template <class NodePtr, class CodeOf, class BucketOf, class Visit>
+void ht_relink_nodes(NodePtr& head, NodePtr first, CodeOf code_of, BucketOf bucket_of, Visit visit)
+{
+  NodePtr prev = nullptr;
+  NodePtr* const* prev_bucket = nullptr;
+  while (first != nullptr)
+  {
+    auto next = first->next;
+    const size_t code = code_of(first);
+    visit(code);
+    auto& link = bucket_of(code);
+    if (&link == prev_bucket)
+      ht_link_after(prev, first, code_of, bucket_of);
+    else
+      ht_link_bucket_begin(head, link, first, code_of, bucket_of);
+    prev = first;
+    prev_bucket = &link;
+    first = next;
+  }
+}
+
+// 渐进式 rehash 时，每次插入操作最多迁移的非空 bucket 个数
+// 同时最多访问 ht_rehash_step * 10 个空 bucket，避免单次操作耗时过长
+static constexpr size_t ht_rehash_step = 4;
+
+// 批量查找时每一批处理的键值个数，一批键值先全部计算哈希值并预取 bucket 和首节点，再逐个查找，
+// 使各次查找的缓存缺失互相重叠
+static constexpr size_t ht_batch_size = 16;
+
+// 开启 Bloom filter 时，每个 bucket 对应的过滤器位数
+static constexpr size_t ht_bloom_bits = 10;
+
 // 模板类 hashtable
 // 参数一代表数据类型，参数二代表哈希函数，参数三代表键值相等的比较函数
 template <class T, class Hash, class KeyEqual>
@@ -475,6 +590,11 @@ class hashtable
 
   friend struct mystl::ht_iterator<T, Hash, KeyEqual>;
   friend struct mystl::ht_const_iterator<T, Hash, KeyEqual>;
+  friend struct mystl::ht_local_iterator<T, Hash, KeyEqual>;
+  friend struct mystl::ht_const_local_iterator<T, Hash, KeyEqual>;
+
+  // 不同哈希函数或比较函数的 hashtable 之间可以相互转移节点
+  template <class, class, class> friend class hashtable;
 
 public:
   // hashtable 的型别定义
@@ -487,11 +607,12 @@ public:
 
   typedef hashtable_node<T>                           node_type;
   typedef node_type*                                  node_ptr;
-  typedef mystl::vector<node_ptr>                     bucket_type;
+  typedef node_ptr*                                   link_ptr;
 
   typedef mystl::allocator<T>                         allocator_type;
   typedef mystl::allocator<T>                         data_allocator;
   typedef mystl::allocator<node_type>                 node_allocator;
+  typedef mystl::allocator<link_ptr>                  bucket_allocator;
 
   typedef typename allocator_type::pointer            pointer;
   typedef typename allocator_type::const_pointer      const_pointer;
@@ -502,19 +623,43 @@ public:
 
   typedef mystl::ht_iterator<T, Hash, KeyEqual>       iterator;
   typedef mystl::ht_const_iterator<T, Hash, KeyEqual> const_iterator;
-  typedef mystl::ht_local_iterator<T>                 local_iterator;
-  typedef mystl::ht_const_local_iterator<T>           const_local_iterator;
+  typedef mystl::ht_local_iterator<T, Hash, KeyEqual>       local_iterator;
+  typedef mystl::ht_const_local_iterator<T, Hash, KeyEqual> const_local_iterator;
 
   allocator_type get_allocator() const { return allocator_type(); }
 
 private:
-  // 用以下六个参数来表现 hashtable
-  bucket_type buckets_;
+  // 节点中是否缓存了哈希值
+  static constexpr bool cache_hash = ht_cache_hash<key_type>::value;
+
+  // 用以下七个参数来表现 hashtable
+  // 所有节点串成一条单向链表，head_ 指向第一个节点，同一个 bucket 中的节点在链表中连续
+  // bucket 中保存的不是它的第一个节点，而是指向该节点的链接，即前一个节点的 next 成员的地址，
+  // 第一个节点就是整个链表的第一个节点时为 &head_，空 bucket 为 nullptr
+  // 这样 begin() 只需要读取 head_，遍历时也不会访问空的 bucket
+  link_ptr*   buckets_;
   size_type   bucket_size_;
   size_type   size_;
   float       mlf_;
   hasher      hash_;
   key_equal   equal_;
+  node_ptr    head_;
+
+  // 渐进式 rehash 使用的旧表，old_bucket_size_ 为 0 表示当前没有进行中的迁移
+  // 旧表中 [0, rehash_index_) 的 bucket 已经迁移到新表，其余的 bucket 仍留在旧表中
+  // 两张表中的 bucket 指向同一条链表
+  link_ptr*   old_buckets_;
+  size_type   old_bucket_size_;
+  size_type   rehash_index_;
+  bool        incremental_;
+
+  // 可选的 Bloom filter，记录所有键值的哈希值，查找时先查询它，确定不存在时不访问 bucket
+  // 删除元素不会清除对应的位，过滤器在 rehash 时按新的 bucket 数重建
+  // 渐进式 rehash 期间，查询仍然使用 filter_，新的过滤器 rehash_filter_ 随迁移逐步建立，迁移完成后替换 filter_
+  typedef mystl::bloom_filter<key_type, Hash> filter_type;
+  bool        bloom_;
+  filter_type filter_;
+  filter_type rehash_filter_;
 
 private:
   bool is_equal(const key_type& key1, const key_type& key2)
@@ -527,6 +672,55 @@ private:
     return equal_(key1, key2);
   }
 
+  // 判断节点的键值是否与 key 相等，code 为 key 的哈希值，缓存了哈希值时先比较哈希值
+  bool is_node_equal(node_ptr node, const key_type& key, size_t code) const
+  {
+    return code_equal(node, code, m_bool_constant<cache_hash>()) &&
+      equal_(value_traits::get_key(node->value), key);
+  }
+
+  bool code_equal(node_ptr node, size_t code, m_true_type) const noexcept
+  { return node->hash_code == code; }
+  bool code_equal(node_ptr, size_t, m_false_type) const noexcept
+  { return true; }
+
+  // 取得节点键值的哈希值，缓存了哈希值时直接读取
+  size_t node_code(node_ptr node) const
+  { return node_code(node, m_bool_constant<cache_hash>()); }
+  size_t node_code(node_ptr node, m_true_type) const noexcept
+  { return node->hash_code; }
+  size_t node_code(node_ptr node, m_false_type) const
+  { return hash_(value_traits::get_key(node->value)); }
+
+  // 交给 ht_link_bucket_begin 等共用函数的访问器
+  struct node_code_of
+  {
+    const hashtable* ht;
+    size_t operator()(node_ptr node) const { return ht->node_code(node); }
+  };
+  struct node_bucket_of
+  {
+    hashtable* ht;
+    link_ptr& operator()(size_t code) const { return ht->bucket_link(code); }
+  };
+  node_code_of   code_of() const noexcept { return node_code_of{ this }; }
+  node_bucket_of bucket_of() noexcept     { return node_bucket_of{ this }; }
+
+  void set_code(node_ptr node, size_t code) noexcept
+  { set_code(node, code, m_bool_constant<cache_hash>()); }
+  void set_code(node_ptr node, size_t code, m_true_type) noexcept
+  { node->hash_code = code; }
+  void set_code(node_ptr, size_t, m_false_type) noexcept
+  {}
+
+  // 把 src 缓存的哈希值复制给 dst，未缓存哈希值时什么也不做
+  void copy_code(node_ptr dst, node_ptr src) noexcept
+  { copy_code(dst, src, m_bool_constant<cache_hash>()); }
+  void copy_code(node_ptr dst, node_ptr src, m_true_type) noexcept
+  { dst->hash_code = src->hash_code; }
+  void copy_code(node_ptr, node_ptr, m_false_type) noexcept
+  {}
+
   const_iterator M_cit(node_ptr node) const noexcept
   {
     return const_iterator(node, const_cast<hashtable*>(this));
@@ -534,22 +728,12 @@ private:
 
   iterator M_begin() noexcept
   {
-    for (size_type n = 0; n < bucket_size_; ++n)
-    {
-      if (buckets_[n])  // 找到第一个有节点的位置就返回
-        return iterator(buckets_[n], this);
-    }
-    return iterator(nullptr, this);
+    return iterator(head_, this);
   }
 
   const_iterator M_begin() const noexcept
   {
-    for (size_type n = 0; n < bucket_size_; ++n)
-    {
-      if (buckets_[n])  // 找到第一个有节点的位置就返回
-        return M_cit(buckets_[n]);
-    }
-    return M_cit(nullptr);
+    return M_cit(head_);
   }
 
 public:
@@ -557,7 +741,8 @@ public:
   explicit hashtable(size_type bucket_count,
                      const Hash& hash = Hash(),
                      const KeyEqual& equal = KeyEqual())
-    :size_(0), mlf_(1.0f), hash_(hash), equal_(equal)
+    :buckets_(nullptr), size_(0), mlf_(1.0f), hash_(hash), equal_(equal), head_(nullptr),
+    old_buckets_(nullptr), old_bucket_size_(0), rehash_index_(0), incremental_(false), bloom_(false)
   {
     init(bucket_count);
   }
@@ -568,33 +753,55 @@ public:
               size_type bucket_count,
               const Hash& hash = Hash(),
               const KeyEqual& equal = KeyEqual())
-    :size_(mystl::distance(first, last)), mlf_(1.0f), hash_(hash), equal_(equal)
+    :buckets_(nullptr), size_(mystl::distance(first, last)), mlf_(1.0f), hash_(hash), equal_(equal),
+    head_(nullptr), old_buckets_(nullptr), old_bucket_size_(0), rehash_index_(0),
+    incremental_(false), bloom_(false)
   {
     init(mystl::max(bucket_count, static_cast<size_type>(mystl::distance(first, last))));
   }
 
   hashtable(const hashtable& rhs)
-    :hash_(rhs.hash_), equal_(rhs.equal_)
+    :buckets_(nullptr), hash_(rhs.hash_), equal_(rhs.equal_), head_(nullptr), old_buckets_(nullptr)
   {
     copy_init(rhs);
   }
   hashtable(hashtable&& rhs) noexcept
-    : bucket_size_(rhs.bucket_size_), 
+    : buckets_(rhs.buckets_),
+    bucket_size_(rhs.bucket_size_), 
     size_(rhs.size_),
     mlf_(rhs.mlf_),
     hash_(rhs.hash_),
-    equal_(rhs.equal_)
-  {
-    buckets_ = mystl::move(rhs.buckets_);
+    equal_(rhs.equal_),
+    head_(rhs.head_),
+    old_buckets_(rhs.old_buckets_),
+    old_bucket_size_(rhs.old_bucket_size_),
+    rehash_index_(rhs.rehash_index_),
+    incremental_(rhs.incremental_),
+    bloom_(rhs.bloom_),
+    filter_(mystl::move(rhs.filter_)),
+    rehash_filter_(mystl::move(rhs.rehash_filter_))
+  {
+    rhs.buckets_ = nullptr;
+    rhs.head_ = nullptr;
+    rhs.old_buckets_ = nullptr;
+    rhs.bloom_ = false;
     rhs.bucket_size_ = 0;
     rhs.size_ = 0;
     rhs.mlf_ = 0.0f;
+    rhs.old_bucket_size_ = 0;
+    rhs.rehash_index_ = 0;
+    // 第一个节点所在 bucket 的链接原来指向 rhs.head_
+    update_head_bucket();
   }
 
   hashtable& operator=(const hashtable& rhs);
   hashtable& operator=(hashtable&& rhs) noexcept;
 
-  ~hashtable() { clear(); }
+  ~hashtable()
+  {
+    clear();
+    bucket_allocator::deallocate(buckets_);
+  }
 
   // 迭代器相关操作
   iterator       begin()        noexcept
@@ -626,15 +833,25 @@ public:
   template <class ...Args>
   pair<iterator, bool> emplace_unique(Args&& ...args);
 
-  // [note]: hint 对于 hash_table 其实没有意义，因为即使提供了 hint，也要做一次 hash，
-  // 来确保 hash_table 的性质，所以选择忽略它
+  // 键值不存在时才构造元素，仅用于 map 类容器
+  template <class K, class ...Args>
+  pair<iterator, bool> try_emplace_unique(K&& key, Args&& ...args);
+
+  // 键值存在时对实值赋值，否则插入新元素，仅用于 map 类容器
+  template <class K, class M>
+  pair<iterator, bool> insert_or_assign_unique(K&& key, M&& obj);
+
+  // [note]: hint 所指元素的键值与新元素相等时，不需要计算哈希值和查找链表，
+  // 键值允许重复时新元素直接接在 hint 之后，不允许重复时直接返回 hint；否则 hint 被忽略
   template <class ...Args>
-  iterator emplace_multi_use_hint(const_iterator /*hint*/, Args&& ...args)
-  { return emplace_multi(mystl::forward<Args>(args)...); }
+  iterator emplace_multi_use_hint(const_iterator hint, Args&& ...args);
 
   template <class ...Args>
-  iterator emplace_unique_use_hint(const_iterator /*hint*/, Args&& ...args)
-  { return emplace_unique(mystl::forward<Args>(args)...).first; }
+  iterator emplace_unique_use_hint(const_iterator hint, Args&& ...args)
+  {
+    return emplace_unique_use_hint_key(mystl::can_extract_key<key_type, value_type, Args...>{},
+                                       hint, mystl::forward<Args>(args)...);
+  }
 
   // insert
 
@@ -659,15 +876,15 @@ public:
   { return emplace_unique(mystl::move(value)); }
 
   // [note]: 同 emplace_hint
-  iterator insert_multi_use_hint(const_iterator /*hint*/, const value_type& value)
-  { return insert_multi(value); }
-  iterator insert_multi_use_hint(const_iterator /*hint*/, value_type&& value)
-  { return emplace_multi(mystl::move(value)); }
+  iterator insert_multi_use_hint(const_iterator hint, const value_type& value)
+  { return emplace_multi_use_hint(hint, value); }
+  iterator insert_multi_use_hint(const_iterator hint, value_type&& value)
+  { return emplace_multi_use_hint(hint, mystl::move(value)); }
 
-  iterator insert_unique_use_hint(const_iterator /*hint*/, const value_type& value)
-  { return insert_unique(value).first; }
-  iterator insert_unique_use_hint(const_iterator /*hint*/, value_type&& value)
-  { return emplace_unique(mystl::move(value)); }
+  iterator insert_unique_use_hint(const_iterator hint, const value_type& value)
+  { return emplace_unique_use_hint(hint, value); }
+  iterator insert_unique_use_hint(const_iterator hint, value_type&& value)
+  { return emplace_unique_use_hint(hint, mystl::move(value)); }
 
   template <class InputIter>
   void insert_multi(InputIter first, InputIter last)
@@ -677,6 +894,12 @@ public:
   void insert_unique(InputIter first, InputIter last)
   { copy_insert_unique(first, last, iterator_category(first)); }
 
+  // 插入已经按键值分组的区间，键值允许重复
+  // 每个元素以上一个插入的元素为 hint，与之键值相等时不需要计算哈希值和查找链表
+  template <class InputIter>
+  void insert_multi_grouped(InputIter first, InputIter last)
+  { grouped_insert_multi(first, last, iterator_category(first)); }
+
   // erase / clear
 
   void      erase(const_iterator position);
@@ -689,6 +912,18 @@ public:
 
   void      swap(hashtable& rhs) noexcept;
 
+  // 节点的摘取与接合，只改变节点的链接关系，不分配或销毁节点
+
+  node_ptr  extract_node(const_iterator position);
+
+  pair<iterator, bool> reinsert_node_unique(node_ptr np);
+  iterator             reinsert_node_multi(node_ptr np);
+
+  template <class Hash2, class KeyEqual2>
+  void      merge_unique(hashtable<T, Hash2, KeyEqual2>& source);
+  template <class Hash2, class KeyEqual2>
+  void      merge_multi(hashtable<T, Hash2, KeyEqual2>& source);
+
   // 查找相关操作
 
   size_type                            count(const key_type& key) const;
@@ -702,38 +937,46 @@ public:
   pair<iterator, iterator>             equal_range_unique(const key_type& key);
   pair<const_iterator, const_iterator> equal_range_unique(const key_type& key) const;
 
+  // 批量查找 [first, last) 中的键值，依次把 find / count 的结果写入 result 开始的位置
+  template <class ForwardIter, class OutputIter>
+  OutputIter find_batch(ForwardIter first, ForwardIter last, OutputIter result);
+  template <class ForwardIter, class OutputIter>
+  OutputIter find_batch(ForwardIter first, ForwardIter last, OutputIter result) const;
+  template <class ForwardIter, class OutputIter>
+  OutputIter count_batch(ForwardIter first, ForwardIter last, OutputIter result) const;
+
   // bucket interface
 
   local_iterator       begin(size_type n)        noexcept
   { 
-    MYSTL_DEBUG(n < size_);
-    return buckets_[n];
+    MYSTL_DEBUG(n < bucket_size_);
+    return local_iterator(buckets_[n] ? *buckets_[n] : nullptr, this, n);
   }
   const_local_iterator begin(size_type n)  const noexcept
   { 
-    MYSTL_DEBUG(n < size_);
-    return buckets_[n];
+    MYSTL_DEBUG(n < bucket_size_);
+    return const_local_iterator(buckets_[n] ? *buckets_[n] : nullptr, this, n);
   }
   const_local_iterator cbegin(size_type n) const noexcept
   { 
-    MYSTL_DEBUG(n < size_);
-    return buckets_[n];
+    MYSTL_DEBUG(n < bucket_size_);
+    return begin(n);
   }
 
   local_iterator       end(size_type n)          noexcept
   { 
-    MYSTL_DEBUG(n < size_);
-    return nullptr; 
+    MYSTL_DEBUG(n < bucket_size_);
+    return local_iterator(nullptr, this, n); 
   }
   const_local_iterator end(size_type n)    const noexcept
   { 
-    MYSTL_DEBUG(n < size_);
-    return nullptr; 
+    MYSTL_DEBUG(n < bucket_size_);
+    return const_local_iterator(nullptr, this, n); 
   }
   const_local_iterator cend(size_type n)   const noexcept
   {
-    MYSTL_DEBUG(n < size_);
-    return nullptr; 
+    MYSTL_DEBUG(n < bucket_size_);
+    return end(n); 
   }
 
   size_type bucket_count()                 const noexcept
@@ -763,6 +1006,38 @@ public:
   void reserve(size_type count)
   { rehash(static_cast<size_type>((float)count / max_load_factor() + 0.5f)); }
 
+  // 渐进式 rehash
+  // 开启后，插入导致的扩容不会一次性迁移所有节点，而是保留新旧两张表，
+  // 之后的每次插入操作迁移少量 bucket，直到旧表迁移完毕
+  // 迁移期间 bucket interface 只反映新表的情况，插入操作可能改变元素的遍历顺序
+
+  bool incremental_rehash() const noexcept
+  { return incremental_; }
+  void incremental_rehash(bool on)
+  {
+    if (!on)
+      rehash_finish();
+    incremental_ = on;
+  }
+
+  bool is_rehashing() const noexcept
+  { return old_bucket_size_ != 0; }
+
+  // Bloom filter
+  // 开启后，查找不存在的键值时大多不需要访问 bucket 和节点，适合查找多数落空的场景
+  // 每个 bucket 占用 ht_bloom_bits 位，误判率约为 1%，删除较多元素后误判率会升高，直到下一次 rehash
+
+  bool use_bloom_filter() const noexcept
+  { return bloom_; }
+  void use_bloom_filter(bool on);
+
+  void rehash_step(size_type n);
+  void rehash_finish()
+  {
+    while (old_bucket_size_ != 0)
+      rehash_step(old_bucket_size_);
+  }
+
   hasher    hash_fcn() const { return hash_; }
   key_equal key_eq()   const { return equal_; }
 
@@ -784,6 +1059,14 @@ private:
   size_type hash(const key_type& key) const;
   void      rehash_if_need(size_type n);
 
+  // bucket
+  link_ptr&       bucket_link(size_t code);
+  const link_ptr& bucket_link(size_t code) const;
+  node_ptr  bucket_next(node_ptr node, size_t code, const link_ptr* bucket) const;
+  node_ptr  local_next(const node_type* node, size_type n) const;
+  link_ptr  prev_link(node_ptr node);
+  void      update_head_bucket();
+
   // insert
   template <class InputIter>
   void copy_insert_multi(InputIter first, InputIter last, mystl::input_iterator_tag);
@@ -793,15 +1076,91 @@ private:
   void copy_insert_unique(InputIter first, InputIter last, mystl::input_iterator_tag);
   template <class ForwardIter>
   void copy_insert_unique(ForwardIter first, ForwardIter last, mystl::forward_iterator_tag);
+  template <class InputIter>
+  void grouped_insert_multi(InputIter first, InputIter last, mystl::input_iterator_tag);
+  template <class ForwardIter>
+  void grouped_insert_multi(ForwardIter first, ForwardIter last, mystl::forward_iterator_tag);
+
+  // emplace unique
+  template <class ...Args>
+  pair<iterator, bool> emplace_unique_key(mystl::m_true_type, Args&& ...args);
+  template <class ...Args>
+  pair<iterator, bool> emplace_unique_key(mystl::m_false_type, Args&& ...args);
+  template <class ...Args>
+  iterator emplace_node_at(size_t code, Args&& ...args);
+  template <class ...Args>
+  iterator emplace_unique_use_hint_key(mystl::m_true_type, const_iterator hint, Args&& ...args);
+  template <class ...Args>
+  iterator emplace_unique_use_hint_key(mystl::m_false_type, const_iterator hint, Args&& ...args);
+
+  // hint 非空且键值与 key 相等
+  bool is_hint_equal(const_iterator hint, const key_type& key) const
+  {
+    return hint.node != nullptr && equal_(value_traits::get_key(hint.node->value), key);
+  }
+
+  // 从 emplace 的参数中取得键值
+  template <class Arg>
+  static const key_type& extract_key(const Arg& arg)
+  { return value_traits::get_key(arg); }
+  template <class Arg1, class Arg2>
+  static const key_type& extract_key(const Arg1& key, const Arg2&)
+  { return key; }
+
+  // 计算 [first, last) 中至多 ht_batch_size 个键值的哈希值和所在的 bucket，并预取 bucket 和 bucket 的首节点，
+  // 返回处理的键值个数
+  template <class ForwardIter>
+  size_type prefetch_batch(ForwardIter first, ForwardIter last, size_t* codes,
+                           const link_ptr** buckets, node_ptr* heads) const;
+
+  // bloom filter
+  void     filter_insert(size_t code) noexcept
+  {
+    if (bloom_)
+    {
+      filter_.insert_hash(code);
+      if (old_bucket_size_ != 0)
+        rehash_filter_.insert_hash(code);
+    }
+  }
+  void     reset_filter();
+
+  // 取得查找哈希值为 code 的键值时要遍历的 bucket，Bloom filter 确定键值不存在时返回空
+  // 每次查找只求一次 bucket，之后沿链表前进时都与它比较
+  const link_ptr* lookup_bucket(size_t code) const
+  {
+    return bloom_ && !filter_.may_contain_hash(code) ? nullptr : &bucket_link(code);
+  }
+
+  // 取得 bucket 的首节点，bucket 为空时返回空
+  static node_ptr bucket_head(const link_ptr* bucket) noexcept
+  {
+    return bucket != nullptr && *bucket != nullptr ? **bucket : nullptr;
+  }
+
+  // 在哈希值为 code 的 bucket 中查找键值为 key 的节点
+  node_ptr find_node(const key_type& key, size_t code) const
+  {
+    const auto bucket = lookup_bucket(code);
+    node_ptr cur = bucket_head(bucket);
+    for (; cur && !is_node_equal(cur, key, code); cur = bucket_next(cur, code, bucket)) {}
+    return cur;
+  }
 
   // insert node
   pair<iterator, bool> insert_node_unique(node_ptr np);
   iterator             insert_node_multi(node_ptr np);
+  iterator             insert_node_after(node_ptr pos, node_ptr np);
 
   // bucket operator
-  void replace_bucket(size_type bucket_count);
-  void erase_bucket(size_type n, node_ptr first, node_ptr last);
-  void erase_bucket(size_type n, node_ptr last);
+  static link_ptr* allocate_buckets(size_type n);
+  void     link_bucket_begin(link_ptr& link, node_ptr np);
+  void     link_after(node_ptr pos, node_ptr np);
+  node_ptr unlink_node(link_ptr prev);
+  node_ptr unlink_old_bucket(size_type n);
+  void     relink_nodes(node_ptr first, filter_type* filter);
+  void     replace_bucket(size_type bucket_count);
+  void     start_rehash(size_type bucket_count);
 
   // comparision
   bool equal_to_multi(const hashtable& other);
@@ -846,8 +1205,7 @@ emplace_multi(Args&& ...args)
   auto np = create_node(mystl::forward<Args>(args)...);
   try
   {
-    if ((float)(size_ + 1) > (float)bucket_size_ * max_load_factor())
-      rehash(size_ + 1);
+    rehash_if_need(1);
   }
   catch (...)
   {
@@ -857,26 +1215,166 @@ emplace_multi(Args&& ...args)
   return insert_node_multi(np);
 }
 
-// 就地构造元素，键值允许重复
+// 就地构造元素，键值不允许重复
+// 能够直接从参数中取得键值时，先查找该键值，键值已经存在时不会构造节点
 // 强异常安全保证
 template <class T, class Hash, class KeyEqual>
 template <class ...Args>
 pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool> 
 hashtable<T, Hash, KeyEqual>::
 emplace_unique(Args&& ...args)
+{
+  return emplace_unique_key(mystl::can_extract_key<key_type, value_type, Args...>{},
+                            mystl::forward<Args>(args)...);
+}
+
+// 键值不存在时，以 key 和由 args 构造的实值插入新元素，否则什么也不做
+template <class T, class Hash, class KeyEqual>
+template <class K, class ...Args>
+pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool> 
+hashtable<T, Hash, KeyEqual>::
+try_emplace_unique(K&& key, Args&& ...args)
+{
+  const size_t code = hash_(key);
+  auto p = find_node(key, code);
+  if (p != nullptr)
+    return mystl::make_pair(iterator(p, this), false);
+  return mystl::make_pair(emplace_node_at(code, mystl::piecewise_second, mystl::forward<K>(key),
+                                          mystl::forward<Args>(args)...), true);
+}
+
+// 键值存在时，把 obj 赋值给它的实值，否则以 key 和 obj 插入新元素
+template <class T, class Hash, class KeyEqual>
+template <class K, class M>
+pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool> 
+hashtable<T, Hash, KeyEqual>::
+insert_or_assign_unique(K&& key, M&& obj)
+{
+  const size_t code = hash_(key);
+  auto p = find_node(key, code);
+  if (p != nullptr)
+  {
+    p->value.second = mystl::forward<M>(obj);
+    return mystl::make_pair(iterator(p, this), false);
+  }
+  return mystl::make_pair(emplace_node_at(code, mystl::forward<K>(key),
+                                          mystl::forward<M>(obj)), true);
+}
+
+// emplace_unique_key 函数
+template <class T, class Hash, class KeyEqual>
+template <class ...Args>
+pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool> 
+hashtable<T, Hash, KeyEqual>::
+emplace_unique_key(mystl::m_true_type, Args&& ...args)
+{
+  const auto& key = extract_key(args...);
+  const size_t code = hash_(key);
+  auto p = find_node(key, code);
+  if (p != nullptr)
+    return mystl::make_pair(iterator(p, this), false);
+  return mystl::make_pair(emplace_node_at(code, mystl::forward<Args>(args)...), true);
+}
+
+template <class T, class Hash, class KeyEqual>
+template <class ...Args>
+pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool> 
+hashtable<T, Hash, KeyEqual>::
+emplace_unique_key(mystl::m_false_type, Args&& ...args)
 {
   auto np = create_node(mystl::forward<Args>(args)...);
   try
   {
-    if ((float)(size_ + 1) > (float)bucket_size_ * max_load_factor())
-      rehash(size_ + 1);
+    rehash_if_need(1);
   }
   catch (...)
   {
     destroy_node(np);
     throw;
   }
-  return insert_node_unique(np);
+  auto res = insert_node_unique(np);
+  if (!res.second)
+    destroy_node(np);
+  return res;
+}
+
+// 使用 hint 就地构造元素，键值允许重复
+// 新元素与 hint 键值相等时直接接在 hint 之后，否则与 emplace_multi 相同
+template <class T, class Hash, class KeyEqual>
+template <class ...Args>
+typename hashtable<T, Hash, KeyEqual>::iterator
+hashtable<T, Hash, KeyEqual>::
+emplace_multi_use_hint(const_iterator hint, Args&& ...args)
+{
+  auto np = create_node(mystl::forward<Args>(args)...);
+  try
+  {
+    rehash_if_need(1);
+  }
+  catch (...)
+  {
+    destroy_node(np);
+    throw;
+  }
+  if (is_hint_equal(hint, value_traits::get_key(np->value)))
+    return insert_node_after(hint.node, np);
+  return insert_node_multi(np);
+}
+
+// emplace_unique_use_hint_key 函数
+// 能够直接从参数中取得键值时，键值与 hint 相等则直接返回 hint，不会构造节点
+template <class T, class Hash, class KeyEqual>
+template <class ...Args>
+typename hashtable<T, Hash, KeyEqual>::iterator
+hashtable<T, Hash, KeyEqual>::
+emplace_unique_use_hint_key(mystl::m_true_type, const_iterator hint, Args&& ...args)
+{
+  if (is_hint_equal(hint, extract_key(args...)))
+    return iterator(hint.node, this);
+  return emplace_unique_key(mystl::m_true_type(), mystl::forward<Args>(args)...).first;
+}
+
+template <class T, class Hash, class KeyEqual>
+template <class ...Args>
+typename hashtable<T, Hash, KeyEqual>::iterator
+hashtable<T, Hash, KeyEqual>::
+emplace_unique_use_hint_key(mystl::m_false_type, const_iterator hint, Args&& ...args)
+{
+  auto np = create_node(mystl::forward<Args>(args)...);
+  if (is_hint_equal(hint, value_traits::get_key(np->value)))
+  {
+    destroy_node(np);
+    return iterator(hint.node, this);
+  }
+  try
+  {
+    rehash_if_need(1);
+  }
+  catch (...)
+  {
+    destroy_node(np);
+    throw;
+  }
+  auto res = insert_node_unique(np);
+  if (!res.second)
+    destroy_node(np);
+  return res.first;
+}
+
+// 构造新节点并插入到哈希值为 code 的 bucket 头部，调用者需保证键值不存在
+template <class T, class Hash, class KeyEqual>
+template <class ...Args>
+typename hashtable<T, Hash, KeyEqual>::iterator
+hashtable<T, Hash, KeyEqual>::
+emplace_node_at(size_t code, Args&& ...args)
+{
+  rehash_if_need(1);
+  auto np = create_node(mystl::forward<Args>(args)...);
+  set_code(np, code);
+  filter_insert(code);
+  link_bucket_begin(bucket_link(code), np);
+  ++size_;
+  return iterator(np, this);
 }
 
 // 在不需要重建表格的情况下插入新节点，键值不允许重复
@@ -885,17 +1383,16 @@ pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool>
 hashtable<T, Hash, KeyEqual>::
 insert_unique_noresize(const value_type& value)
 {
-  const auto n = hash(value_traits::get_key(value));
-  auto first = buckets_[n];
-  for (auto cur = first; cur; cur = cur->next)
-  {
-    if (is_equal(value_traits::get_key(cur->value), value_traits::get_key(value)))
-      return mystl::make_pair(iterator(cur, this), false);
-  }
-  // 让新节点成为链表的第一个节点
+  const auto& key = value_traits::get_key(value);
+  const size_t code = hash_(key);
+  auto cur = find_node(key, code);
+  if (cur != nullptr)
+    return mystl::make_pair(iterator(cur, this), false);
+  // 让新节点成为 bucket 的第一个节点
   auto tmp = create_node(value);  
-  tmp->next = first;
-  buckets_[n] = tmp;
+  set_code(tmp, code);
+  filter_insert(code);
+  link_bucket_begin(bucket_link(code), tmp);
   ++size_;
   return mystl::make_pair(iterator(tmp, this), true);
 }
@@ -906,22 +1403,20 @@ typename hashtable<T, Hash, KeyEqual>::iterator
 hashtable<T, Hash, KeyEqual>::
 insert_multi_noresize(const value_type& value)
 {
-  const auto n = hash(value_traits::get_key(value));
-  auto first = buckets_[n];
+  const auto& key = value_traits::get_key(value);
+  const size_t code = hash_(key);
+  auto cur = find_node(key, code);
   auto tmp = create_node(value);
-  for (auto cur = first; cur; cur = cur->next)
-  {
-    if (is_equal(value_traits::get_key(cur->value), value_traits::get_key(value)))
-    { // 如果链表中存在相同键值的节点就马上插入，然后返回
-      tmp->next = cur->next;
-      cur->next = tmp;
-      ++size_;
-      return iterator(tmp, this);
-    }
+  set_code(tmp, code);
+  filter_insert(code);
+  if (cur != nullptr)
+  { // 如果 bucket 中存在相同键值的节点就插入在它之后
+    link_after(cur, tmp);
+  }
+  else
+  { // 否则插入在 bucket 头部
+    link_bucket_begin(bucket_link(code), tmp);
   }
-  // 否则插入在链表头部
-  tmp->next = first;
-  buckets_[n] = tmp;
   ++size_;
   return iterator(tmp, this);
 }
@@ -934,36 +1429,85 @@ erase(const_iterator position)
   auto p = position.node;
   if (p)
   {
-    const auto n = hash(value_traits::get_key(p->value));
-    auto cur = buckets_[n];
-    if (cur == p)
-    { // p 位于链表头部
-      buckets_[n] = cur->next;
-      destroy_node(cur);
-      --size_;
-    }
-    else
+    destroy_node(unlink_node(prev_link(p)));
+    --size_;
+  }
+}
+
+// 摘取 position 所指的节点，节点脱离 hashtable 但不会被销毁
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::node_ptr
+hashtable<T, Hash, KeyEqual>::
+extract_node(const_iterator position)
+{
+  auto p = position.node;
+  MYSTL_DEBUG(p != nullptr);
+  unlink_node(prev_link(p));
+  p->next = nullptr;
+  --size_;
+  return p;
+}
+
+// 接合一个已经存在的节点，键值不允许重复，插入失败时不改变该节点，
+// 返回的迭代器指向插入的节点或者与之键值相等的节点
+template <class T, class Hash, class KeyEqual>
+pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool>
+hashtable<T, Hash, KeyEqual>::
+reinsert_node_unique(node_ptr np)
+{
+  rehash_if_need(1);
+  return insert_node_unique(np);
+}
+
+// 接合一个已经存在的节点，键值允许重复
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::iterator
+hashtable<T, Hash, KeyEqual>::
+reinsert_node_multi(node_ptr np)
+{
+  rehash_if_need(1);
+  return insert_node_multi(np);
+}
+
+// 把 source 中的节点转移过来，键值不允许重复，与已有元素键值重复的节点留在 source 中
+template <class T, class Hash, class KeyEqual>
+template <class Hash2, class KeyEqual2>
+void hashtable<T, Hash, KeyEqual>::
+merge_unique(hashtable<T, Hash2, KeyEqual2>& source)
+{
+  if (static_cast<void*>(this) == static_cast<void*>(&source))
+    return;
+  auto first = source.begin();
+  auto last = source.end();
+  while (first != last)
+  {
+    auto cur = first++;
+    if (find(value_traits::get_key(*cur)) == end())
     {
-      auto next = cur->next;
-      while (next)
-      {
-        if (next == p)
-        {
-          cur->next = next->next;
-          destroy_node(next);
-          --size_;
-          break;
-        }
-        else
-        {
-          cur = next;
-          next = cur->next;
-        }
-      }
+      rehash_if_need(1);
+      insert_node_unique(source.extract_node(cur));
     }
   }
 }
 
+// 把 source 中的节点全部转移过来，键值允许重复
+template <class T, class Hash, class KeyEqual>
+template <class Hash2, class KeyEqual2>
+void hashtable<T, Hash, KeyEqual>::
+merge_multi(hashtable<T, Hash2, KeyEqual2>& source)
+{
+  if (static_cast<void*>(this) == static_cast<void*>(&source))
+    return;
+  rehash_if_need(source.size_);
+  auto first = source.begin();
+  auto last = source.end();
+  while (first != last)
+  {
+    auto cur = first++;
+    insert_node_multi(source.extract_node(cur));
+  }
+}
+
 // 删除[first, last)内的节点
 template <class T, class Hash, class KeyEqual>
 void hashtable<T, Hash, KeyEqual>::
@@ -971,28 +1515,12 @@ erase(const_iterator first, const_iterator last)
 {
   if (first.node == last.node)
     return;
-  auto first_bucket = first.node 
-    ? hash(value_traits::get_key(first.node->value)) 
-    : bucket_size_;
-  auto last_bucket = last.node 
-    ? hash(value_traits::get_key(last.node->value))
-    : bucket_size_;
-  if (first_bucket == last_bucket)
-  { // 如果在 bucket 在同一个位置
-    erase_bucket(first_bucket, first.node, last.node);
-  }
-  else
+  // [first, last) 在链表中连续，逐个摘下 prev 之后的节点
+  const link_ptr prev = prev_link(first.node);
+  while (*prev != last.node)
   {
-    erase_bucket(first_bucket, first.node, nullptr);
-    for (auto n = first_bucket + 1; n < last_bucket; ++n)
-    {
-      if(buckets_[n] != nullptr)
-        erase_bucket(n, nullptr);
-    }
-    if (last_bucket != bucket_size_)
-    {
-      erase_bucket(last_bucket, last.node);
-    }
+    destroy_node(unlink_node(prev));
+    --size_;
   }
 }
 
@@ -1005,8 +1533,9 @@ erase_multi(const key_type& key)
   auto p = equal_range_multi(key);
   if (p.first.node != nullptr)
   {
+    const size_type n = mystl::distance(p.first, p.second);
     erase(p.first, p.second);
-    return mystl::distance(p.first, p.second);
+    return n;
   }
   return 0;
 }
@@ -1016,33 +1545,19 @@ typename hashtable<T, Hash, KeyEqual>::size_type
 hashtable<T, Hash, KeyEqual>::
 erase_unique(const key_type& key)
 {
-  const auto n = hash(key);
-  auto first = buckets_[n];
-  if (first)
-  {
-    if (is_equal(value_traits::get_key(first->value), key))
+  const size_t code = hash_(key);
+  const link_ptr* bucket = &bucket_link(code);
+  link_ptr prev = *bucket;
+  if (prev == nullptr)
+    return 0;
+  for (node_ptr cur = *prev; cur; prev = &cur->next, cur = bucket_next(cur, code, bucket))
+  {
+    if (is_node_equal(cur, key, code))
     {
-      buckets_[n] = first->next;
-      destroy_node(first);
+      destroy_node(unlink_node(prev));
       --size_;
       return 1;
     }
-    else
-    {
-      auto next = first->next;
-      while (next)
-      {
-        if (is_equal(value_traits::get_key(next->value), key))
-        {
-          first->next = next->next;
-          destroy_node(next);
-          --size_;
-          return 1;
-        }
-        first = next;
-        next = first->next;
-      }
-    }
   }
   return 0;
 }
@@ -1054,19 +1569,48 @@ clear()
 {
   if (size_ != 0)
   {
-    for (size_type i = 0; i < bucket_size_; ++i)
+    node_ptr cur = head_;
+    while (cur != nullptr)
     {
-      node_ptr cur = buckets_[i];
-      while (cur != nullptr)
-      {
-        node_ptr next = cur->next;
-        destroy_node(cur);
-        cur = next;
-      }
-      buckets_[i] = nullptr;
+      node_ptr next = cur->next;
+      destroy_node(cur);
+      cur = next;
     }
+    head_ = nullptr;
+    for (size_type i = 0; i < bucket_size_; ++i)
+      buckets_[i] = nullptr;
     size_ = 0;
   }
+  if (old_bucket_size_ != 0)
+  { // 没有节点需要迁移了，直接丢弃旧表
+    bucket_allocator::deallocate(old_buckets_);
+    old_buckets_ = nullptr;
+    old_bucket_size_ = 0;
+    rehash_index_ = 0;
+  }
+  if (bloom_)
+    reset_filter();
+}
+
+// 开启或关闭 Bloom filter，开启时根据现有的元素建立过滤器
+template <class T, class Hash, class KeyEqual>
+void hashtable<T, Hash, KeyEqual>::
+use_bloom_filter(bool on)
+{
+  if (on == bloom_)
+    return;
+  if (!on)
+  {
+    bloom_ = false;
+    filter_type().swap(filter_);
+    filter_type().swap(rehash_filter_);
+    return;
+  }
+  rehash_finish();
+  reset_filter();
+  for (node_ptr cur = head_; cur; cur = cur->next)
+    filter_.insert_hash(node_code(cur));
+  bloom_ = true;
 }
 
 // 在某个 bucket 节点的个数
@@ -1076,7 +1620,7 @@ hashtable<T, Hash, KeyEqual>::
 bucket_size(size_type n) const noexcept
 {
   size_type result = 0;
-  for (auto cur = buckets_[n]; cur; cur = cur->next)
+  for (auto first = cbegin(n), last = cend(n); first != last; ++first)
   {
     ++result;
   }
@@ -1088,6 +1632,7 @@ template <class T, class Hash, class KeyEqual>
 void hashtable<T, Hash, KeyEqual>::
 rehash(size_type count)
 {
+  rehash_finish();
   auto n = ht_next_prime(count);
   if (n > bucket_size_)
   {
@@ -1109,10 +1654,7 @@ typename hashtable<T, Hash, KeyEqual>::iterator
 hashtable<T, Hash, KeyEqual>::
 find(const key_type& key)
 {
-  const auto n = hash(key);
-  node_ptr first = buckets_[n];
-  for (; first && !is_equal(value_traits::get_key(first->value), key); first = first->next) {}
-  return iterator(first, this);
+  return iterator(find_node(key, hash_(key)), this);
 }
 
 template <class T, class Hash, class KeyEqual>
@@ -1120,10 +1662,7 @@ typename hashtable<T, Hash, KeyEqual>::const_iterator
 hashtable<T, Hash, KeyEqual>::
 find(const key_type& key) const
 {
-  const auto n = hash(key);
-  node_ptr first = buckets_[n];
-  for (; first && !is_equal(value_traits::get_key(first->value), key); first = first->next) {}
-  return M_cit(first);
+  return M_cit(find_node(key, hash_(key)));
 }
 
 // 查找键值为 key 出现的次数
@@ -1132,16 +1671,88 @@ typename hashtable<T, Hash, KeyEqual>::size_type
 hashtable<T, Hash, KeyEqual>::
 count(const key_type& key) const
 {
-  const auto n = hash(key);
   size_type result = 0;
-  for (node_ptr cur = buckets_[n]; cur; cur = cur->next)
+  const size_t code = hash_(key);
+  const auto bucket = lookup_bucket(code);
+  for (node_ptr cur = bucket_head(bucket); cur; cur = bucket_next(cur, code, bucket))
   {
-    if (is_equal(value_traits::get_key(cur->value), key))
+    if (is_node_equal(cur, key, code))
       ++result;
   }
   return result;
 }
 
+// 批量查找，每个键值的结果与 find 相同
+template <class T, class Hash, class KeyEqual>
+template <class ForwardIter, class OutputIter>
+OutputIter hashtable<T, Hash, KeyEqual>::
+find_batch(ForwardIter first, ForwardIter last, OutputIter result)
+{
+  size_t codes[ht_batch_size];
+  const link_ptr* buckets[ht_batch_size];
+  node_ptr heads[ht_batch_size];
+  while (first != last)
+  {
+    const auto n = prefetch_batch(first, last, codes, buckets, heads);
+    for (size_type i = 0; i < n; ++i, ++first, ++result)
+    {
+      auto cur = heads[i];
+      for (; cur && !is_node_equal(cur, *first, codes[i]);
+           cur = bucket_next(cur, codes[i], buckets[i])) {}
+      *result = iterator(cur, this);
+    }
+  }
+  return result;
+}
+
+template <class T, class Hash, class KeyEqual>
+template <class ForwardIter, class OutputIter>
+OutputIter hashtable<T, Hash, KeyEqual>::
+find_batch(ForwardIter first, ForwardIter last, OutputIter result) const
+{
+  size_t codes[ht_batch_size];
+  const link_ptr* buckets[ht_batch_size];
+  node_ptr heads[ht_batch_size];
+  while (first != last)
+  {
+    const auto n = prefetch_batch(first, last, codes, buckets, heads);
+    for (size_type i = 0; i < n; ++i, ++first, ++result)
+    {
+      auto cur = heads[i];
+      for (; cur && !is_node_equal(cur, *first, codes[i]);
+           cur = bucket_next(cur, codes[i], buckets[i])) {}
+      *result = M_cit(cur);
+    }
+  }
+  return result;
+}
+
+// 批量查找，每个键值的结果与 count 相同
+template <class T, class Hash, class KeyEqual>
+template <class ForwardIter, class OutputIter>
+OutputIter hashtable<T, Hash, KeyEqual>::
+count_batch(ForwardIter first, ForwardIter last, OutputIter result) const
+{
+  size_t codes[ht_batch_size];
+  const link_ptr* buckets[ht_batch_size];
+  node_ptr heads[ht_batch_size];
+  while (first != last)
+  {
+    const auto n = prefetch_batch(first, last, codes, buckets, heads);
+    for (size_type i = 0; i < n; ++i, ++first, ++result)
+    {
+      size_type count = 0;
+      for (auto cur = heads[i]; cur; cur = bucket_next(cur, codes[i], buckets[i]))
+      {
+        if (is_node_equal(cur, *first, codes[i]))
+          ++count;
+      }
+      *result = count;
+    }
+  }
+  return result;
+}
+
 // 查找与键值 key 相等的区间，返回一个 pair，指向相等区间的首尾
 template <class T, class Hash, class KeyEqual>
 pair<typename hashtable<T, Hash, KeyEqual>::iterator,
@@ -1149,22 +1760,16 @@ pair<typename hashtable<T, Hash, KeyEqual>::iterator,
 hashtable<T, Hash, KeyEqual>::
 equal_range_multi(const key_type& key)
 {
-  const auto n = hash(key);
-  for (node_ptr first = buckets_[n]; first; first = first->next)
-  {
-    if (is_equal(value_traits::get_key(first->value), key))
-    { // 如果出现相等的键值
-      for (node_ptr second = first->next; second; second = second->next)
-      {
-        if (!is_equal(value_traits::get_key(second->value), key))
-          return mystl::make_pair(iterator(first, this), iterator(second, this));
-      }
-      for (auto m = n + 1; m < bucket_size_; ++m)
-      { // 整个链表都相等，查找下一个链表出现的位置
-        if (buckets_[m])
-          return mystl::make_pair(iterator(first, this), iterator(buckets_[m], this));
-      }
-      return mystl::make_pair(iterator(first, this), end());
+  const size_t code = hash_(key);
+  const auto bucket = lookup_bucket(code);
+  for (node_ptr first = bucket_head(bucket); first; first = bucket_next(first, code, bucket))
+  {
+    if (is_node_equal(first, key, code))
+    { // 如果出现相等的键值，相等的节点在链表中连续
+      node_ptr last = first;
+      while (last->next && is_node_equal(last->next, key, code))
+        last = last->next;
+      return mystl::make_pair(iterator(first, this), iterator(last->next, this));
     }
   }
   return mystl::make_pair(end(), end());
@@ -1176,22 +1781,16 @@ pair<typename hashtable<T, Hash, KeyEqual>::const_iterator,
 hashtable<T, Hash, KeyEqual>::
 equal_range_multi(const key_type& key) const
 {
-  const auto n = hash(key);
-  for (node_ptr first = buckets_[n]; first; first = first->next)
+  const size_t code = hash_(key);
+  const auto bucket = lookup_bucket(code);
+  for (node_ptr first = bucket_head(bucket); first; first = bucket_next(first, code, bucket))
   {
-    if (is_equal(value_traits::get_key(first->value), key))
+    if (is_node_equal(first, key, code))
     {
-      for (node_ptr second = first->next; second; second = second->next)
-      {
-        if (!is_equal(value_traits::get_key(second->value), key))
-          return mystl::make_pair(M_cit(first), M_cit(second));
-      }
-      for (auto m = n + 1; m < bucket_size_; ++m)
-      { // 整个链表都相等，查找下一个链表出现的位置
-        if (buckets_[m])
-          return mystl::make_pair(M_cit(first), M_cit(buckets_[m]));
-      }
-      return mystl::make_pair(M_cit(first), cend());
+      node_ptr last = first;
+      while (last->next && is_node_equal(last->next, key, code))
+        last = last->next;
+      return mystl::make_pair(M_cit(first), M_cit(last->next));
     }
   }
   return mystl::make_pair(cend(), cend());
@@ -1203,20 +1802,12 @@ pair<typename hashtable<T, Hash, KeyEqual>::iterator,
 hashtable<T, Hash, KeyEqual>::
 equal_range_unique(const key_type& key)
 {
-  const auto n = hash(key);
-  for (node_ptr first = buckets_[n]; first; first = first->next)
+  const size_t code = hash_(key);
+  const auto bucket = lookup_bucket(code);
+  for (node_ptr first = bucket_head(bucket); first; first = bucket_next(first, code, bucket))
   {
-    if (is_equal(value_traits::get_key(first->value), key))
-    {
-      if (first->next)
-        return mystl::make_pair(iterator(first, this), iterator(first->next, this));
-      for (auto m = n + 1; m < bucket_size_; ++m)
-      { // 整个链表都相等，查找下一个链表出现的位置
-        if (buckets_[m])
-          return mystl::make_pair(iterator(first, this), iterator(buckets_[m], this));
-      }
-      return mystl::make_pair(iterator(first, this), end());
-    }
+    if (is_node_equal(first, key, code))
+      return mystl::make_pair(iterator(first, this), iterator(first->next, this));
   }
   return mystl::make_pair(end(), end());
 }
@@ -1227,20 +1818,12 @@ pair<typename hashtable<T, Hash, KeyEqual>::const_iterator,
 hashtable<T, Hash, KeyEqual>::
 equal_range_unique(const key_type& key) const
 {
-  const auto n = hash(key);
-  for (node_ptr first = buckets_[n]; first; first = first->next)
+  const size_t code = hash_(key);
+  const auto bucket = lookup_bucket(code);
+  for (node_ptr first = bucket_head(bucket); first; first = bucket_next(first, code, bucket))
   {
-    if (is_equal(value_traits::get_key(first->value), key))
-    {
-      if (first->next)
-        return mystl::make_pair(M_cit(first), M_cit(first->next));
-      for (auto m = n + 1; m < bucket_size_; ++m)
-      { // 整个链表都相等，查找下一个链表出现的位置
-        if (buckets_[m])
-          return mystl::make_pair(M_cit(first), M_cit(buckets_[m]));
-      }
-      return mystl::make_pair(M_cit(first), cend());
-    }
+    if (is_node_equal(first, key, code))
+      return mystl::make_pair(M_cit(first), M_cit(first->next));
   }
   return mystl::make_pair(cend(), cend());
 }
@@ -1252,12 +1835,22 @@ swap(hashtable& rhs) noexcept
 {
   if (this != &rhs)
   {
-    buckets_.swap(rhs.buckets_);
+    mystl::swap(buckets_, rhs.buckets_);
     mystl::swap(bucket_size_, rhs.bucket_size_);
     mystl::swap(size_, rhs.size_);
     mystl::swap(mlf_, rhs.mlf_);
     mystl::swap(hash_, rhs.hash_);
     mystl::swap(equal_, rhs.equal_);
+    mystl::swap(head_, rhs.head_);
+    mystl::swap(old_buckets_, rhs.old_buckets_);
+    mystl::swap(old_bucket_size_, rhs.old_bucket_size_);
+    mystl::swap(rehash_index_, rhs.rehash_index_);
+    mystl::swap(incremental_, rhs.incremental_);
+    mystl::swap(bloom_, rhs.bloom_);
+    filter_.swap(rhs.filter_);
+    rehash_filter_.swap(rhs.rehash_filter_);
+    update_head_bucket();
+    rhs.update_head_bucket();
   }
 }
 
@@ -1272,8 +1865,7 @@ init(size_type n)
   const auto bucket_nums = next_size(n);
   try
   {
-    buckets_.reserve(bucket_nums);
-    buckets_.assign(bucket_nums, nullptr);
+    buckets_ = allocate_buckets(bucket_nums);
   }
   catch (...)
   {
@@ -1281,7 +1873,7 @@ init(size_type n)
     size_ = 0;
     throw;
   }
-  bucket_size_ = buckets_.size();
+  bucket_size_ = bucket_nums;
 }
 
 // copy_init 函数
@@ -1290,32 +1882,45 @@ void hashtable<T, Hash, KeyEqual>::
 copy_init(const hashtable& ht)
 {
   bucket_size_ = 0;
-  buckets_.reserve(ht.bucket_size_);
-  buckets_.assign(ht.bucket_size_, nullptr);
+  size_ = 0;
+  old_bucket_size_ = 0;
+  rehash_index_ = 0;
+  incremental_ = ht.incremental_;
+  bloom_ = false;
+  buckets_ = allocate_buckets(ht.bucket_size_);
+  bucket_size_ = ht.bucket_size_;
   try
   {
-    for (size_type i = 0; i < ht.bucket_size_; ++i)
-    {
-      node_ptr cur = ht.buckets_[i];
-      if (cur)
-      { // 如果某 bucket 存在链表
-        auto copy = create_node(cur->value);
-        buckets_[i] = copy;
-        for (auto next = cur->next; next; cur = next, next = cur->next)
-        {  //复制链表
-          copy->next = create_node(next->value);
-          copy = copy->next;
-        }
-        copy->next = nullptr;
-      }
-    }
-    bucket_size_ = ht.bucket_size_;
     mlf_ = ht.mlf_;
+    if (ht.old_bucket_size_ != 0)
+    { // 对方正在进行渐进式 rehash，连同旧表一起复制，使每个节点落在与对方相同的 bucket 中
+      old_buckets_ = allocate_buckets(ht.old_bucket_size_);
+      old_bucket_size_ = ht.old_bucket_size_;
+      rehash_index_ = ht.rehash_index_;
+    }
+    // 先设置好大小，复制中途失败时 clear 可以回收已经复制的节点
     size_ = ht.size_;
+    // 按链表顺序复制节点，同一个 bucket 的节点仍然连续，bucket 的链接就是它第一个节点之前的链接
+    link_ptr tail = &head_;
+    for (node_ptr cur = ht.head_; cur; cur = cur->next)
+    {
+      auto copy = create_node(cur->value);
+      const auto code = ht.node_code(cur);
+      set_code(copy, code);
+      *tail = copy;
+      auto& link = bucket_link(code);
+      if (link == nullptr)
+        link = tail;
+      tail = &copy->next;
+    }
+    filter_ = ht.filter_;
+    rehash_filter_ = ht.rehash_filter_;
+    bloom_ = ht.bloom_;
   }
   catch (...)
   {
     clear();
+    throw;
   }
 }
 
@@ -1380,8 +1985,22 @@ template <class T, class Hash, class KeyEqual>
 void hashtable<T, Hash, KeyEqual>::
 rehash_if_need(size_type n)
 {
+  if (old_bucket_size_ != 0)
+    rehash_step(ht_rehash_step);
   if (static_cast<float>(size_ + n) > (float)bucket_size_ * max_load_factor())
-    rehash(size_ + n);
+  {
+    if (!incremental_)
+    {
+      rehash(size_ + n);
+    }
+    else
+    { // 上一轮迁移还没有结束时先完成它，再开始新一轮迁移
+      rehash_finish();
+      const auto count = ht_next_prime(size_ + n);
+      if (count > bucket_size_)
+        start_rehash(count);
+    }
+  }
 }
 
 // copy_insert
@@ -1427,141 +2046,363 @@ copy_insert_unique(ForwardIter first, ForwardIter last, mystl::forward_iterator_
     insert_unique_noresize(*first);
 }
 
+// grouped_insert_multi 函数
+// 以上一个插入的节点为 hint，逐个插入已经按键值分组的区间
+template <class T, class Hash, class KeyEqual>
+template <class InputIter>
+void hashtable<T, Hash, KeyEqual>::
+grouped_insert_multi(InputIter first, InputIter last, mystl::input_iterator_tag)
+{
+  node_ptr prev = nullptr;
+  for (; first != last; ++first)
+    prev = emplace_multi_use_hint(M_cit(prev), *first).node;
+}
+
+template <class T, class Hash, class KeyEqual>
+template <class ForwardIter>
+void hashtable<T, Hash, KeyEqual>::
+grouped_insert_multi(ForwardIter first, ForwardIter last, mystl::forward_iterator_tag)
+{
+  rehash_if_need(mystl::distance(first, last));
+  grouped_insert_multi(first, last, mystl::input_iterator_tag());
+}
+
 // insert_node 函数
 template <class T, class Hash, class KeyEqual>
 typename hashtable<T, Hash, KeyEqual>::iterator
 hashtable<T, Hash, KeyEqual>::
 insert_node_multi(node_ptr np)
 {
-  const auto n = hash(value_traits::get_key(np->value));
-  auto cur = buckets_[n];
-  if (cur == nullptr)
-  {
-    buckets_[n] = np;
-    ++size_;
-    return iterator(np, this);
-  }
-  for (; cur; cur = cur->next)
-  {
-    if (is_equal(value_traits::get_key(cur->value), value_traits::get_key(np->value)))
-    {
-      np->next = cur->next;
-      cur->next = np;
-      ++size_;
-      return iterator(np, this);
-    }
-  }
-  np->next = buckets_[n];
-  buckets_[n] = np;
+  const auto& key = value_traits::get_key(np->value);
+  const size_t code = hash_(key);
+  auto cur = find_node(key, code);
+  set_code(np, code);
+  filter_insert(code);
+  if (cur != nullptr)
+    link_after(cur, np);
+  else
+    link_bucket_begin(bucket_link(code), np);
   ++size_;
   return iterator(np, this);
 }
 
 // insert_node_unique 函数
+// 键值重复时不插入，也不销毁节点，由调用者处理
 template <class T, class Hash, class KeyEqual>
 pair<typename hashtable<T, Hash, KeyEqual>::iterator, bool>
 hashtable<T, Hash, KeyEqual>::
 insert_node_unique(node_ptr np)
 {
-  const auto n = hash(value_traits::get_key(np->value));
-  auto cur = buckets_[n];
-  if (cur == nullptr)
-  {
-    buckets_[n] = np;
-    ++size_;
-    return mystl::make_pair(iterator(np, this), true);
-  }
-  for (; cur; cur = cur->next)
-  {
-    if (is_equal(value_traits::get_key(cur->value), value_traits::get_key(np->value)))
-    {
-      return mystl::make_pair(iterator(cur, this), false);
-    }
-  }
-  np->next = buckets_[n];
-  buckets_[n] = np;
+  const auto& key = value_traits::get_key(np->value);
+  const size_t code = hash_(key);
+  auto cur = find_node(key, code);
+  if (cur != nullptr)
+    return mystl::make_pair(iterator(cur, this), false);
+  set_code(np, code);
+  filter_insert(code);
+  link_bucket_begin(bucket_link(code), np);
   ++size_;
   return mystl::make_pair(iterator(np, this), true);
 }
 
+// insert_node_after 函数
+// 把 np 接在键值与之相等的节点 pos 之后，不需要计算哈希值
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::iterator
+hashtable<T, Hash, KeyEqual>::
+insert_node_after(node_ptr pos, node_ptr np)
+{
+  copy_code(np, pos);
+  link_after(pos, np);
+  ++size_;
+  return iterator(np, this);
+}
+
+// reset_filter 函数
+// 按当前的 bucket 数建立一个空的过滤器，调用者需保证此时没有元素或随后会加入所有元素
+template <class T, class Hash, class KeyEqual>
+void hashtable<T, Hash, KeyEqual>::
+reset_filter()
+{
+  filter_type filter(bucket_size_, ht_bloom_bits, hash_);
+  filter_.swap(filter);
+  filter_type().swap(rehash_filter_);
+}
+
+// allocate_buckets 函数
+// 分配 n 个 bucket，全部置为空
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::link_ptr*
+hashtable<T, Hash, KeyEqual>::
+allocate_buckets(size_type n)
+{
+  THROW_LENGTH_ERROR_IF(n > static_cast<size_type>(-1) / sizeof(link_ptr),
+                        "hashtable<T>'s bucket count is too big");
+  auto buckets = bucket_allocator::allocate(n);
+  for (size_type i = 0; i < n; ++i)
+    buckets[i] = nullptr;
+  return buckets;
+}
+
+// link_bucket_begin 函数
+// 把 np 链接为 bucket 的第一个节点，link 为该 bucket，bucket 为空时 np 成为整个链表的第一个节点
+template <class T, class Hash, class KeyEqual>
+void hashtable<T, Hash, KeyEqual>::
+link_bucket_begin(link_ptr& link, node_ptr np)
+{
+  ht_link_bucket_begin(head_, link, np, code_of(), bucket_of());
+}
+
+// link_after 函数
+// 把 np 链接在同一个 bucket 的节点 pos 之后
+template <class T, class Hash, class KeyEqual>
+void hashtable<T, Hash, KeyEqual>::
+link_after(node_ptr pos, node_ptr np)
+{
+  ht_link_after(pos, np, code_of(), bucket_of());
+}
+
+// unlink_node 函数
+// 从链表中摘下 prev 所指的节点并返回，同时维护它所在的 bucket 和下一个 bucket 的链接
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::node_ptr
+hashtable<T, Hash, KeyEqual>::
+unlink_node(link_ptr prev)
+{
+  return ht_unlink_node(prev, code_of(), bucket_of());
+}
+
+// unlink_old_bucket 函数
+// 从链表中摘下旧表中第 n 个 bucket 的所有节点，返回以空结尾的节点链
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::node_ptr
+hashtable<T, Hash, KeyEqual>::
+unlink_old_bucket(size_type n)
+{
+  const link_ptr prev = old_buckets_[n];
+  node_ptr first = *prev;
+  const size_t code = node_code(first);
+  node_ptr last = first;
+  for (node_ptr next; (next = bucket_next(last, code, old_buckets_ + n)) != nullptr; last = next) {}
+  node_ptr after = last->next;
+  if (after != nullptr)
+    bucket_link(node_code(after)) = prev;
+  *prev = after;
+  old_buckets_[n] = nullptr;
+  last->next = nullptr;
+  return first;
+}
+
+// relink_nodes 函数
+// 把以 first 开头、以空结尾的节点链逐个链接到当前的 bucket 中，filter 非空时同时记录到其中
+template <class T, class Hash, class KeyEqual>
+void hashtable<T, Hash, KeyEqual>::
+relink_nodes(node_ptr first, filter_type* filter)
+{
+  ht_relink_nodes(head_, first, code_of(), bucket_of(), [filter](size_t code)
+  {
+    if (filter != nullptr)
+      filter->insert_hash(code);
+  });
+}
+
 // replace_bucket 函数
+// 把所有节点重新链接到新的 bucket 中，不复制节点
 template <class T, class Hash, class KeyEqual>
 void hashtable<T, Hash, KeyEqual>::
 replace_bucket(size_type bucket_count)
 {
-  bucket_type bucket(bucket_count);
-  if (size_ != 0)
+  filter_type filter;
+  if (bloom_)
+    filter = filter_type(bucket_count, ht_bloom_bits, hash_);
+  auto buckets = allocate_buckets(bucket_count);
+  node_ptr first = head_;
+  head_ = nullptr;
+  bucket_allocator::deallocate(buckets_);
+  buckets_ = buckets;
+  bucket_size_ = bucket_count;
+  filter_.swap(filter);
+  relink_nodes(first, bloom_ ? &filter_ : nullptr);
+}
+
+// start_rehash 函数
+// 开始一轮渐进式 rehash，原来的 bucket 成为旧表，节点留在旧表中等待迁移
+template <class T, class Hash, class KeyEqual>
+void hashtable<T, Hash, KeyEqual>::
+start_rehash(size_type bucket_count)
+{
+  filter_type filter;
+  if (bloom_)
+    filter = filter_type(bucket_count, ht_bloom_bits, hash_);
+  auto buckets = allocate_buckets(bucket_count);
+  if (size_ == 0)
+  {
+    bucket_allocator::deallocate(buckets_);
+    buckets_ = buckets;
+    bucket_size_ = bucket_count;
+    filter_.swap(filter);
+    return;
+  }
+  old_buckets_ = buckets_;
+  old_bucket_size_ = bucket_size_;
+  buckets_ = buckets;
+  bucket_size_ = bucket_count;
+  rehash_index_ = 0;
+  rehash_filter_.swap(filter);
+}
+
+// rehash_step 函数
+// 从旧表中最多迁移 n 个非空 bucket 到新表，最多访问 n * 10 个空 bucket
+template <class T, class Hash, class KeyEqual>
+void hashtable<T, Hash, KeyEqual>::
+rehash_step(size_type n)
+{
+  size_type empty_visits = n * 10;
+  while (n > 0 && old_bucket_size_ != 0)
   {
-    for (size_type i = 0; i < bucket_size_; ++i)
+    node_ptr first = nullptr;
+    if (old_buckets_[rehash_index_] != nullptr)
     {
-      for (auto first = buckets_[i]; first; first = first->next)
-      {
-        auto tmp = create_node(first->value);
-        const auto n = hash(value_traits::get_key(first->value), bucket_count);
-        auto f = bucket[n];
-        bool is_inserted = false;
-        for (auto cur = f; cur; cur = cur->next)
-        {
-          if (is_equal(value_traits::get_key(cur->value), value_traits::get_key(first->value)))
-          {
-            tmp->next = cur->next;
-            cur->next = tmp;
-            is_inserted = true;
-            break;
-          }
-        }
-        if (!is_inserted)
-        {
-          tmp->next = f;
-          bucket[n] = tmp;
-        }
-      }
+      first = unlink_old_bucket(rehash_index_);
+      --n;
+    }
+    else
+    {
+      --empty_visits;
+    }
+    // 先推进迁移进度，摘下的节点随后按新表链接
+    ++rehash_index_;
+    relink_nodes(first, bloom_ ? &rehash_filter_ : nullptr);
+    if (rehash_index_ == old_bucket_size_)
+    { // 迁移完毕，释放旧表，新的过滤器已经包含所有键值
+      bucket_allocator::deallocate(old_buckets_);
+      old_buckets_ = nullptr;
+      old_bucket_size_ = 0;
+      rehash_index_ = 0;
+      filter_.swap(rehash_filter_);
+      filter_type().swap(rehash_filter_);
+    }
+    else if (empty_visits == 0)
+    {
+      break;
     }
   }
-  buckets_.swap(bucket);
-  bucket_size_ = buckets_.size();
 }
 
-// erase_bucket 函数
-// 在第 n 个 bucket 内，删除 [first, last) 的节点
+// bucket_link 函数
+// 取得哈希值为 code 的键值所在的 bucket，迁移期间，旧表中尚未迁移的 bucket 里的键值仍然在旧表中
+// 插入和查找，所以只需要根据迁移进度选择新表或旧表中的一个 bucket
 template <class T, class Hash, class KeyEqual>
-void hashtable<T, Hash, KeyEqual>::
-erase_bucket(size_type n, node_ptr first, node_ptr last)
+typename hashtable<T, Hash, KeyEqual>::link_ptr&
+hashtable<T, Hash, KeyEqual>::
+bucket_link(size_t code)
 {
-  auto cur = buckets_[n];
-  if (cur == first)
+  if (old_bucket_size_ != 0)
   {
-    erase_bucket(n, last);
+    const auto n = code % old_bucket_size_;
+    if (n >= rehash_index_)
+      return old_buckets_[n];
   }
-  else
+  return buckets_[code % bucket_size_];
+}
+
+template <class T, class Hash, class KeyEqual>
+const typename hashtable<T, Hash, KeyEqual>::link_ptr&
+hashtable<T, Hash, KeyEqual>::
+bucket_link(size_t code) const
+{
+  if (old_bucket_size_ != 0)
   {
-    node_ptr next = cur->next;
-    for (; next != first; cur = next, next = cur->next) {}
-    while (next != last)
-    {
-      cur->next = next->next;
-      destroy_node(next);
-      next = cur->next;
-      --size_;
-    }
+    const auto n = code % old_bucket_size_;
+    if (n >= rehash_index_)
+      return old_buckets_[n];
   }
+  return buckets_[code % bucket_size_];
+}
+
+// bucket_next 函数
+// node 位于哈希值为 code 的键值所在的 bucket 中，返回该 bucket 中 node 的下一个节点，没有时返回空
+// bucket 由调用者在查找开始时求出一次，每一步只为下一个节点求 bucket，不迁移时只有一次取模，
+// 下一个节点的哈希值与 code 相同时不需要取模
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::node_ptr
+hashtable<T, Hash, KeyEqual>::
+bucket_next(node_ptr node, size_t code, const link_ptr* bucket) const
+{
+  node_ptr next = node->next;
+  if (next == nullptr)
+    return nullptr;
+  const size_t next_code = node_code(next);
+  return next_code == code || &bucket_link(next_code) == bucket ? next : nullptr;
+}
+
+// local_next 函数
+// 新表第 n 个 bucket 中 node 的下一个节点，没有时返回空
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::node_ptr
+hashtable<T, Hash, KeyEqual>::
+local_next(const node_type* node, size_type n) const
+{
+  node_ptr next = node->next;
+  return next != nullptr && &bucket_link(node_code(next)) == buckets_ + n ? next : nullptr;
+}
+
+// prev_link 函数
+// 取得链表中指向 node 的链接
+template <class T, class Hash, class KeyEqual>
+typename hashtable<T, Hash, KeyEqual>::link_ptr
+hashtable<T, Hash, KeyEqual>::
+prev_link(node_ptr node)
+{
+  link_ptr prev = bucket_link(node_code(node));
+  while (*prev != node)
+    prev = &(*prev)->next;
+  return prev;
 }
 
-// erase_bucket 函数
-// 在第 n 个 bucket 内，删除 [buckets_[n], last) 的节点
+// update_head_bucket 函数
+// head_ 的地址改变之后（移动、交换），让第一个节点所在的 bucket 重新指向它
 template <class T, class Hash, class KeyEqual>
 void hashtable<T, Hash, KeyEqual>::
-erase_bucket(size_type n, node_ptr last)
+update_head_bucket()
 {
-  auto cur = buckets_[n];
-  while (cur != last)
+  if (head_ != nullptr)
+    bucket_link(node_code(head_)) = &head_;
+}
+
+// prefetch_batch 函数
+// 分三轮进行：第一轮计算哈希值并预取 bucket 和 Bloom filter，第二轮读取 bucket 并预取它所指的链接，
+// 第三轮读取 bucket 的首节点并预取它
+template <class T, class Hash, class KeyEqual>
+template <class ForwardIter>
+typename hashtable<T, Hash, KeyEqual>::size_type
+hashtable<T, Hash, KeyEqual>::
+prefetch_batch(ForwardIter first, ForwardIter last, size_t* codes,
+               const link_ptr** buckets, node_ptr* heads) const
+{
+  link_ptr links[ht_batch_size];
+  size_type n = 0;
+  for (; n < ht_batch_size && first != last; ++n, ++first)
   {
-    auto next = cur->next;
-    destroy_node(cur);
-    cur = next;
-    --size_;
+    codes[n] = hash_(*first);
+    buckets[n] = &bucket_link(codes[n]);
+    MYSTL_PREFETCH(buckets[n]);
+    if (bloom_)
+      filter_.prefetch_hash(codes[n]);
+  }
+  for (size_type i = 0; i < n; ++i)
+  {
+    links[i] = !bloom_ || filter_.may_contain_hash(codes[i]) ? *buckets[i] : nullptr;
+    if (links[i] != nullptr)
+      MYSTL_PREFETCH(links[i]);
+  }
+  for (size_type i = 0; i < n; ++i)
+  {
+    heads[i] = links[i] != nullptr ? *links[i] : nullptr;
+    if (heads[i] != nullptr)
+      MYSTL_PREFETCH(heads[i]);
   }
-  buckets_[n] = last;
+  return n;
 }
 
 // equal_to 函数
@@ -0,0 +1,474 @@
+﻿#ifndef MYTINYSTL_INTRUSIVE_LIST_H_
+#define MYTINYSTL_INTRUSIVE_LIST_H_
+
+// 这个头文件包含一个模板类 intrusive_list
+// intrusive_list : 侵入式双向链表，链接用户对象中嵌入的挂钩（list_hook），不申请内存，也不复制元素
+
+// notes:
+//
+// 元素的生命周期由使用者管理，链表只负责链接：
+//   * 一个对象可以嵌入多个 list_hook，同时位于多个 intrusive_list 中
+//   * 只要给出对象本身，就能在 O(1) 时间内把它从所在的链表中摘下（list_hook::unlink）
+//   * 对象析构时自动从所在的链表中摘下，链表析构时摘下所有元素
+//   * 元素可以不经过链表直接摘下，所以 intrusive_list 不记录大小，size() 需要遍历链表
+//
+// 使用方法：
+//   struct conn { list_hook idle_hook; list_hook timer_hook; ... };
+//   mystl::intrusive_list<conn, &conn::idle_hook>  idle;
+//   mystl::intrusive_list<conn, &conn::timer_hook> timers;
+
+#include <cstddef>
+#include <type_traits>
+
+#include "list.h"
+#include "iterator.h"
+#include "util.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// 由成员指针在对象和嵌入其中的挂钩之间相互转换
+template <class T, class Hook, Hook T::*Member>
+struct intrusive_member_traits
+{
+  static Hook* to_hook(T* p) noexcept
+  { return &(p->*Member); }
+
+  static const Hook* to_hook(const T* p) noexcept
+  { return &(p->*Member); }
+
+  static T* to_value(Hook* h) noexcept
+  { return reinterpret_cast<T*>(reinterpret_cast<char*>(h) - offset()); }
+
+  static const T* to_value(const Hook* h) noexcept
+  { return reinterpret_cast<const T*>(reinterpret_cast<const char*>(h) - offset()); }
+
+  // 挂钩在对象中的偏移量，在一块对齐的存储上计算，不构造对象，优化后为常量
+  static ptrdiff_t offset() noexcept
+  {
+    static typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    const T* p = reinterpret_cast<const T*>(&storage);
+    return reinterpret_cast<const char*>(&(p->*Member)) - reinterpret_cast<const char*>(p);
+  }
+};
+
+// 侵入式链表的挂钩，复用 list 的节点结构，不在链表中时 prev 与 next 为空
+struct list_hook : public list_node_base<void>
+{
+  list_hook() noexcept
+  {
+    prev = nullptr;
+    next = nullptr;
+  }
+
+  // 复制对象时不复制链接关系，新对象不在任何链表中，赋值也不改变两者原来的链接
+  list_hook(const list_hook&) noexcept
+    :list_hook()
+  {
+  }
+
+  list_hook& operator=(const list_hook&) noexcept
+  {
+    return *this;
+  }
+
+  ~list_hook()
+  {
+    unlink();
+  }
+
+  bool is_linked() const noexcept
+  {
+    return next != nullptr;
+  }
+
+  // 从所在的链表中摘下，不在链表中时什么也不做
+  void unlink() noexcept
+  {
+    if (next != nullptr)
+    {
+      prev->next = next;
+      next->prev = prev;
+      prev = nullptr;
+      next = nullptr;
+    }
+  }
+};
+
+template <class T, list_hook T::*Hook> struct intrusive_list_iterator;
+template <class T, list_hook T::*Hook> struct intrusive_list_const_iterator;
+
+// intrusive_list 的迭代器设计
+template <class T, list_hook T::*Hook>
+struct intrusive_list_iterator : public mystl::iterator<mystl::bidirectional_iterator_tag, T>
+{
+  typedef T                                           value_type;
+  typedef T*                                          pointer;
+  typedef T&                                          reference;
+  typedef list_node_base<void>*                       base_ptr;
+  typedef intrusive_member_traits<T, list_hook, Hook> traits;
+  typedef intrusive_list_iterator<T, Hook>            self;
+
+  base_ptr node_;  // 指向当前节点
+
+  // 构造函数
+  intrusive_list_iterator() = default;
+  intrusive_list_iterator(base_ptr x)
+    :node_(x) {}
+
+  // 重载操作符
+  reference operator*()  const { return *traits::to_value(static_cast<list_hook*>(node_)); }
+  pointer   operator->() const { return &(operator*()); }
+
+  self& operator++()
+  {
+    MYSTL_DEBUG(node_ != nullptr);
+    node_ = node_->next;
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp = *this;
+    ++*this;
+    return tmp;
+  }
+  self& operator--()
+  {
+    MYSTL_DEBUG(node_ != nullptr);
+    node_ = node_->prev;
+    return *this;
+  }
+  self operator--(int)
+  {
+    self tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  // 重载比较操作符
+  bool operator==(const self& rhs) const { return node_ == rhs.node_; }
+  bool operator!=(const self& rhs) const { return node_ != rhs.node_; }
+};
+
+template <class T, list_hook T::*Hook>
+struct intrusive_list_const_iterator : public mystl::iterator<mystl::bidirectional_iterator_tag, T>
+{
+  typedef T                                           value_type;
+  typedef const T*                                    pointer;
+  typedef const T&                                    reference;
+  typedef list_node_base<void>*                       base_ptr;
+  typedef intrusive_member_traits<T, list_hook, Hook> traits;
+  typedef intrusive_list_const_iterator<T, Hook>      self;
+
+  base_ptr node_;
+
+  intrusive_list_const_iterator() = default;
+  intrusive_list_const_iterator(base_ptr x)
+    :node_(x) {}
+  intrusive_list_const_iterator(const intrusive_list_iterator<T, Hook>& rhs)
+    :node_(rhs.node_) {}
+
+  reference operator*()  const { return *traits::to_value(static_cast<const list_hook*>(node_)); }
+  pointer   operator->() const { return &(operator*()); }
+
+  self& operator++()
+  {
+    MYSTL_DEBUG(node_ != nullptr);
+    node_ = node_->next;
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp = *this;
+    ++*this;
+    return tmp;
+  }
+  self& operator--()
+  {
+    MYSTL_DEBUG(node_ != nullptr);
+    node_ = node_->prev;
+    return *this;
+  }
+  self operator--(int)
+  {
+    self tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  bool operator==(const self& rhs) const { return node_ == rhs.node_; }
+  bool operator!=(const self& rhs) const { return node_ != rhs.node_; }
+};
+
+// 模板类: intrusive_list
+// 模板参数 T 代表元素类型，Hook 代表 T 中用于本链表的 list_hook 成员
+template <class T, list_hook T::*Hook>
+class intrusive_list
+{
+public:
+  // intrusive_list 的嵌套型别定义
+  typedef T                                           value_type;
+  typedef T*                                          pointer;
+  typedef const T*                                    const_pointer;
+  typedef T&                                          reference;
+  typedef const T&                                    const_reference;
+  typedef size_t                                      size_type;
+  typedef ptrdiff_t                                   difference_type;
+
+  typedef intrusive_list_iterator<T, Hook>            iterator;
+  typedef intrusive_list_const_iterator<T, Hook>      const_iterator;
+  typedef mystl::reverse_iterator<iterator>           reverse_iterator;
+  typedef mystl::reverse_iterator<const_iterator>     const_reverse_iterator;
+
+  typedef list_node_base<void>*                       base_ptr;
+  typedef intrusive_member_traits<T, list_hook, Hook> traits;
+
+private:
+  list_node_base<void> node_;  // 哨兵节点，直接嵌入容器中
+
+public:
+  // 构造、移动、析构函数，元素不属于链表，因此不能复制
+  intrusive_list() noexcept
+  { node_.unlink(); }
+
+  intrusive_list(const intrusive_list&) = delete;
+  intrusive_list& operator=(const intrusive_list&) = delete;
+
+  intrusive_list(intrusive_list&& rhs) noexcept
+  {
+    node_.unlink();
+    splice(end(), rhs);
+  }
+
+  intrusive_list& operator=(intrusive_list&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      clear();
+      splice(end(), rhs);
+    }
+    return *this;
+  }
+
+  ~intrusive_list()
+  { clear(); }
+
+public:
+  // 迭代器相关操作
+  iterator               begin()         noexcept
+  { return node_.next; }
+  const_iterator         begin()   const noexcept
+  { return node_.next; }
+  iterator               end()           noexcept
+  { return sentinel(); }
+  const_iterator         end()     const noexcept
+  { return sentinel(); }
+
+  reverse_iterator       rbegin()        noexcept
+  { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin()  const noexcept
+  { return const_reverse_iterator(end()); }
+  reverse_iterator       rend()          noexcept
+  { return reverse_iterator(begin()); }
+  const_reverse_iterator rend()    const noexcept
+  { return const_reverse_iterator(begin()); }
+
+  const_iterator         cbegin()  const noexcept
+  { return begin(); }
+  const_iterator         cend()    const noexcept
+  { return end(); }
+  const_reverse_iterator crbegin() const noexcept
+  { return rbegin(); }
+  const_reverse_iterator crend()   const noexcept
+  { return rend(); }
+
+  // 由元素本身得到指向它的迭代器，元素必须位于本链表中
+  iterator       iterator_to(reference value) noexcept
+  { return iterator(traits::to_hook(&value)); }
+  const_iterator iterator_to(const_reference value) const noexcept
+  { return const_iterator(const_cast<list_hook*>(traits::to_hook(&value))); }
+
+  // 容量相关操作
+  bool      empty()    const noexcept
+  { return node_.next == sentinel(); }
+
+  // 需要遍历链表
+  size_type size()     const noexcept
+  { return static_cast<size_type>(mystl::distance(begin(), end())); }
+
+  // 访问元素相关操作
+  reference       front()
+  {
+    MYSTL_DEBUG(!empty());
+    return *begin();
+  }
+  const_reference front() const
+  {
+    MYSTL_DEBUG(!empty());
+    return *begin();
+  }
+  reference       back()
+  {
+    MYSTL_DEBUG(!empty());
+    return *(--end());
+  }
+  const_reference back()  const
+  {
+    MYSTL_DEBUG(!empty());
+    return *(--end());
+  }
+
+  // 调整容器相关操作，都不会抛出异常
+
+  // 在 pos 之前链接 value，value 不能已经位于使用同一挂钩的链表中
+  iterator insert(const_iterator pos, reference value) noexcept
+  {
+    list_hook* h = traits::to_hook(&value);
+    MYSTL_DEBUG(!h->is_linked());
+    base_ptr p = pos.node_;
+    h->prev = p->prev;
+    h->next = p;
+    p->prev->next = h;
+    p->prev = h;
+    return iterator(h);
+  }
+
+  void push_front(reference value) noexcept
+  { insert(begin(), value); }
+  void push_back(reference value) noexcept
+  { insert(end(), value); }
+
+  void pop_front() noexcept
+  {
+    MYSTL_DEBUG(!empty());
+    erase(begin());
+  }
+  void pop_back() noexcept
+  {
+    MYSTL_DEBUG(!empty());
+    erase(--end());
+  }
+
+  // 摘下元素，不销毁元素，返回下一个位置
+  iterator erase(const_iterator pos) noexcept
+  {
+    MYSTL_DEBUG(pos != cend());
+    base_ptr next = pos.node_->next;
+    static_cast<list_hook*>(pos.node_)->unlink();
+    return iterator(next);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) noexcept
+  {
+    while (first != last)
+      first = erase(first);
+    return iterator(last.node_);
+  }
+
+  void erase(reference value) noexcept
+  { erase(iterator_to(value)); }
+
+  // 摘下所有元素
+  void clear() noexcept
+  {
+    while (!empty())
+      erase(begin());
+  }
+
+  void swap(intrusive_list& rhs) noexcept;
+
+  // intrusive_list 相关操作
+
+  // 把 other 的全部或部分元素移到 pos 之前，other 可以是 *this（仅限后两种形式）
+  void splice(const_iterator pos, intrusive_list& other) noexcept
+  {
+    if (!other.empty())
+      transfer(pos.node_, other.node_.next, other.sentinel());
+  }
+  void splice(const_iterator pos, intrusive_list&, const_iterator it) noexcept
+  {
+    base_ptr next = it.node_->next;
+    if (pos.node_ != it.node_ && pos.node_ != next)
+      transfer(pos.node_, it.node_, next);
+  }
+  void splice(const_iterator pos, intrusive_list&,
+              const_iterator first, const_iterator last) noexcept
+  {
+    if (first != last && pos != last)
+      transfer(pos.node_, first.node_, last.node_);
+  }
+
+  template <class UnaryPredicate>
+  void remove_if(UnaryPredicate pred);
+
+  void reverse() noexcept;
+
+private:
+  // 哨兵节点的地址，const 成员函数中也需要非 const 的指针构造迭代器
+  base_ptr sentinel() const noexcept
+  { return const_cast<base_ptr>(&node_); }
+
+  // 把 [first, last) 移到 p 之前
+  static void transfer(base_ptr p, base_ptr first, base_ptr last) noexcept
+  {
+    base_ptr tail = last->prev;
+    first->prev->next = last;
+    last->prev = first->prev;
+    first->prev = p->prev;
+    tail->next = p;
+    p->prev->next = first;
+    p->prev = tail;
+  }
+};
+
+/*****************************************************************************************/
+
+// 交换两个链表的元素，哨兵嵌在容器中，需要借助临时链表
+template <class T, list_hook T::*Hook>
+void intrusive_list<T, Hook>::swap(intrusive_list& rhs) noexcept
+{
+  if (this == &rhs)
+    return;
+  intrusive_list tmp;
+  tmp.splice(tmp.end(), rhs);
+  rhs.splice(rhs.end(), *this);
+  splice(end(), tmp);
+}
+
+// 摘下所有令一元操作 pred 为 true 的元素
+template <class T, list_hook T::*Hook>
+template <class UnaryPredicate>
+void intrusive_list<T, Hook>::remove_if(UnaryPredicate pred)
+{
+  for (auto i = begin(); i != end(); )
+  {
+    if (pred(*i))
+      i = erase(i);
+    else
+      ++i;
+  }
+}
+
+// 将链表反转
+template <class T, list_hook T::*Hook>
+void intrusive_list<T, Hook>::reverse() noexcept
+{
+  base_ptr p = sentinel();
+  do
+  {
+    mystl::swap(p->prev, p->next);
+    p = p->prev;
+  } while (p != sentinel());
+}
+
+// 重载 mystl 的 swap
+template <class T, list_hook T::*Hook>
+void swap(intrusive_list<T, Hook>& lhs, intrusive_list<T, Hook>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_INTRUSIVE_LIST_H_
+
@@ -0,0 +1,543 @@
+﻿#ifndef MYTINYSTL_INTRUSIVE_UNORDERED_SET_H_
+#define MYTINYSTL_INTRUSIVE_UNORDERED_SET_H_
+
+// 这个头文件包含一个模板类 intrusive_unordered_set
+// intrusive_unordered_set : 侵入式哈希集合，链接用户对象中嵌入的挂钩（hash_hook），键值不允许重复
+
+// notes:
+//
+// 与 hashtable 使用相同的布局：所有元素串成一条单向链表，bucket 中保存指向该 bucket 第一个元素的链接，
+// 并使用相同的 bucket 大小序列与负载因子策略。与 hashtable 的区别在于：
+//   * 插入和删除元素不申请内存，只有 bucket 数组在 rehash 时重新申请
+//   * 元素的生命周期由使用者管理，元素必须在析构之前从集合中删除
+//   * 挂钩中保存元素的哈希值，rehash 时不需要重新计算
+//   * 元素的键值在集合中时不能被修改
+//
+// 使用方法：
+//   struct conn { int fd; hash_hook fd_hook; ... };
+//   struct conn_hash { size_t operator()(const conn& c) const { return mystl::hash<int>()(c.fd); } };
+//   struct conn_equal { bool operator()(const conn& a, const conn& b) const { return a.fd == b.fd; } };
+//   mystl::intrusive_unordered_set<conn, &conn::fd_hook, conn_hash, conn_equal> by_fd;
+
+#include "hashtable.h"
+#include "intrusive_list.h"
+#include "functional.h"
+#include "memory.h"
+#include "util.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// 侵入式哈希集合的挂钩
+struct hash_hook
+{
+  hash_hook* next;       // 指向链表中的下一个元素
+  size_t     hash_code;  // 元素的哈希值
+
+  hash_hook() noexcept
+    :next(nullptr), hash_code(0)
+  {
+  }
+
+  // 复制对象时不复制链接关系
+  hash_hook(const hash_hook&) noexcept
+    :hash_hook()
+  {
+  }
+
+  hash_hook& operator=(const hash_hook&) noexcept
+  {
+    return *this;
+  }
+};
+
+// intrusive_unordered_set 的迭代器设计
+template <class T, hash_hook T::*Hook>
+struct intrusive_hash_iterator : public mystl::iterator<mystl::forward_iterator_tag, T>
+{
+  typedef T                                           value_type;
+  typedef T*                                          pointer;
+  typedef T&                                          reference;
+  typedef intrusive_member_traits<T, hash_hook, Hook> traits;
+  typedef intrusive_hash_iterator<T, Hook>            self;
+
+  hash_hook* node_;  // 指向当前元素的挂钩，尾后为 nullptr
+
+  intrusive_hash_iterator() = default;
+  intrusive_hash_iterator(hash_hook* x)
+    :node_(x) {}
+
+  reference operator*()  const { return *traits::to_value(node_); }
+  pointer   operator->() const { return &(operator*()); }
+
+  self& operator++()
+  {
+    MYSTL_DEBUG(node_ != nullptr);
+    node_ = node_->next;
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const self& rhs) const { return node_ == rhs.node_; }
+  bool operator!=(const self& rhs) const { return node_ != rhs.node_; }
+};
+
+template <class T, hash_hook T::*Hook>
+struct intrusive_hash_const_iterator : public mystl::iterator<mystl::forward_iterator_tag, T>
+{
+  typedef T                                           value_type;
+  typedef const T*                                    pointer;
+  typedef const T&                                    reference;
+  typedef intrusive_member_traits<T, hash_hook, Hook> traits;
+  typedef intrusive_hash_const_iterator<T, Hook>      self;
+
+  hash_hook* node_;
+
+  intrusive_hash_const_iterator() = default;
+  intrusive_hash_const_iterator(hash_hook* x)
+    :node_(x) {}
+  intrusive_hash_const_iterator(const intrusive_hash_iterator<T, Hook>& rhs)
+    :node_(rhs.node_) {}
+
+  reference operator*()  const { return *traits::to_value(const_cast<const hash_hook*>(node_)); }
+  pointer   operator->() const { return &(operator*()); }
+
+  self& operator++()
+  {
+    MYSTL_DEBUG(node_ != nullptr);
+    node_ = node_->next;
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const self& rhs) const { return node_ == rhs.node_; }
+  bool operator!=(const self& rhs) const { return node_ != rhs.node_; }
+};
+
+// 模板类 intrusive_unordered_set
+// 参数一代表元素类型，参数二代表 T 中用于本集合的 hash_hook 成员，
+// 参数三代表哈希函数，缺省使用 mystl 的 hash，参数四代表元素相等的比较函数，缺省使用 mystl 的 equal_to
+template <class T, hash_hook T::*Hook,
+          class Hash = mystl::hash<T>, class KeyEqual = mystl::equal_to<T>>
+class intrusive_unordered_set
+{
+public:
+  // intrusive_unordered_set 的型别定义
+  typedef T                                           key_type;
+  typedef T                                           value_type;
+  typedef Hash                                        hasher;
+  typedef KeyEqual                                    key_equal;
+
+  typedef T*                                          pointer;
+  typedef const T*                                    const_pointer;
+  typedef T&                                          reference;
+  typedef const T&                                    const_reference;
+  typedef size_t                                      size_type;
+  typedef ptrdiff_t                                   difference_type;
+
+  typedef intrusive_hash_iterator<T, Hook>            iterator;
+  typedef intrusive_hash_const_iterator<T, Hook>      const_iterator;
+
+  typedef intrusive_member_traits<T, hash_hook, Hook> traits;
+  typedef hash_hook*                                  node_ptr;
+  typedef node_ptr*                                   link_ptr;
+  typedef mystl::allocator<link_ptr>                  bucket_allocator;
+
+private:
+  // 用以下七个参数来表现 intrusive_unordered_set，含义与 hashtable 相同
+  link_ptr*  buckets_;
+  size_type  bucket_size_;
+  size_type  size_;
+  float      mlf_;
+  hasher     hash_;
+  key_equal  equal_;
+  node_ptr   head_;
+
+public:
+  // 构造、移动、析构函数，元素不属于集合，因此不能复制
+  // 被移动的集合为空且没有 bucket，可以继续使用，第一次插入时分配 bucket
+  intrusive_unordered_set()
+    :intrusive_unordered_set(100)
+  {
+  }
+
+  explicit intrusive_unordered_set(size_type bucket_count,
+                                   const Hash& hash = Hash(),
+                                   const KeyEqual& equal = KeyEqual())
+    :buckets_(nullptr), bucket_size_(0), size_(0), mlf_(1.0f),
+     hash_(hash), equal_(equal), head_(nullptr)
+  {
+    bucket_size_ = ht_next_prime(bucket_count);
+    buckets_ = allocate_buckets(bucket_size_);
+  }
+
+  intrusive_unordered_set(const intrusive_unordered_set&) = delete;
+  intrusive_unordered_set& operator=(const intrusive_unordered_set&) = delete;
+
+  intrusive_unordered_set(intrusive_unordered_set&& rhs) noexcept
+    :buckets_(rhs.buckets_), bucket_size_(rhs.bucket_size_), size_(rhs.size_), mlf_(rhs.mlf_),
+     hash_(rhs.hash_), equal_(rhs.equal_), head_(rhs.head_)
+  {
+    rhs.buckets_ = nullptr;
+    rhs.bucket_size_ = 0;
+    rhs.size_ = 0;
+    rhs.head_ = nullptr;
+    update_head_bucket();
+  }
+
+  intrusive_unordered_set& operator=(intrusive_unordered_set&& rhs) noexcept
+  {
+    intrusive_unordered_set tmp(mystl::move(rhs));
+    swap(tmp);
+    return *this;
+  }
+
+  ~intrusive_unordered_set()
+  {
+    clear();
+    bucket_allocator::deallocate(buckets_);
+  }
+
+  // 迭代器相关操作
+  iterator       begin()        noexcept
+  { return iterator(head_); }
+  const_iterator begin()  const noexcept
+  { return const_iterator(head_); }
+  iterator       end()          noexcept
+  { return iterator(nullptr); }
+  const_iterator end()    const noexcept
+  { return const_iterator(nullptr); }
+
+  const_iterator cbegin() const noexcept
+  { return begin(); }
+  const_iterator cend()   const noexcept
+  { return end(); }
+
+  // 由元素本身得到指向它的迭代器，元素必须位于本集合中
+  iterator       iterator_to(reference value) noexcept
+  { return iterator(traits::to_hook(&value)); }
+  const_iterator iterator_to(const_reference value) const noexcept
+  { return const_iterator(const_cast<node_ptr>(traits::to_hook(&value))); }
+
+  // 容量相关操作
+  bool      empty()    const noexcept { return size_ == 0; }
+  size_type size()     const noexcept { return size_; }
+  size_type max_size() const noexcept { return static_cast<size_type>(-1); }
+
+  // 修改容器相关操作
+
+  // 插入元素，集合中已有相等的元素时不插入，返回该元素的位置
+  // 只有 rehash 申请 bucket 失败时抛出异常，此时集合不变
+  pair<iterator, bool> insert(reference value);
+
+  // 删除元素，不销毁元素，返回下一个位置
+  iterator  erase(const_iterator pos);
+  iterator  erase(const_iterator first, const_iterator last);
+
+  // 删除 value 本身，value 必须位于本集合中，与 erase(iterator_to(value)) 相同
+  void      erase(reference value)
+  { erase(iterator_to(value)); }
+
+  // 删除与 key 相等的元素，返回删除的个数
+  size_type erase_key(const key_type& key);
+
+  // 删除所有元素，保留 bucket
+  void      clear() noexcept;
+
+  void      swap(intrusive_unordered_set& rhs) noexcept;
+
+  // 查找相关操作
+  iterator       find(const key_type& key)
+  { return iterator(find_node(key, hash_(key), equal_)); }
+  const_iterator find(const key_type& key) const
+  { return const_iterator(find_node(key, hash_(key), equal_)); }
+
+  // 用另一种键值查找，khash 必须与 hasher 对相等的键值给出相同的哈希值，
+  // kequal(key, value) 判断 key 与元素 value 是否相等，查找时不需要构造一个元素
+  template <class K, class KHash, class KEqual>
+  iterator       find(const K& key, KHash khash, KEqual kequal)
+  { return iterator(find_node(key, khash(key), kequal)); }
+  template <class K, class KHash, class KEqual>
+  const_iterator find(const K& key, KHash khash, KEqual kequal) const
+  { return const_iterator(find_node(key, khash(key), kequal)); }
+
+  size_type count(const key_type& key) const
+  { return find(key) == end() ? 0 : 1; }
+
+  // bucket 相关操作
+  size_type bucket_count() const noexcept
+  { return bucket_size_; }
+  size_type bucket(const key_type& key) const
+  { return bucket_size_ != 0 ? hash_(key) % bucket_size_ : 0; }
+
+  // hash policy
+  float     load_factor() const noexcept
+  { return bucket_size_ != 0 ? (float)size_ / bucket_size_ : 0.0f; }
+
+  float     max_load_factor() const noexcept
+  { return mlf_; }
+  void      max_load_factor(float ml)
+  {
+    THROW_OUT_OF_RANGE_IF(ml != ml || ml < 0, "invalid hash load factor");
+    mlf_ = ml;
+  }
+
+  void      rehash(size_type count);
+
+  void      reserve(size_type count)
+  { rehash(static_cast<size_type>((float)count / max_load_factor() + 0.5f)); }
+
+  hasher    hash_fcn() const { return hash_; }
+  key_equal key_eq()   const { return equal_; }
+
+private:
+  // bucket
+  link_ptr& bucket_link(size_t code) const noexcept
+  { return buckets_[code % bucket_size_]; }
+
+  // 节点 node 在链表中的下一个节点，不在 bucket 中时返回 nullptr，bucket 是哈希值为 code 的 bucket
+  // bucket 由调用者求出一次，每一步最多对下一个节点的哈希值取一次模
+  node_ptr  bucket_next(node_ptr node, size_t code, const link_ptr* bucket) const noexcept
+  {
+    node_ptr next = node->next;
+    return next != nullptr && (next->hash_code == code || &bucket_link(next->hash_code) == bucket)
+      ? next : nullptr;
+  }
+
+  link_ptr* allocate_buckets(size_type n);
+  void      update_head_bucket() noexcept
+  {
+    if (head_ != nullptr)
+      bucket_link(head_->hash_code) = &head_;
+  }
+
+  template <class K, class KEqual>
+  node_ptr  find_node(const K& key, size_t code, const KEqual& kequal) const;
+
+  // 交给 ht_link_bucket_begin 等共用函数的访问器
+  struct hook_code_of
+  {
+    size_t operator()(node_ptr node) const noexcept { return node->hash_code; }
+  };
+  struct hook_bucket_of
+  {
+    const intrusive_unordered_set* set;
+    link_ptr& operator()(size_t code) const noexcept { return set->bucket_link(code); }
+  };
+
+  link_ptr  prev_link(node_ptr node) const noexcept;
+  void      link_bucket_begin(link_ptr& link, node_ptr np) noexcept;
+  node_ptr  unlink_node(link_ptr prev) noexcept;
+  void      replace_bucket(size_type bucket_count);
+};
+
+/*****************************************************************************************/
+
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+pair<typename intrusive_unordered_set<T, Hook, Hash, KeyEqual>::iterator, bool>
+intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+insert(reference value)
+{
+  const size_t code = hash_(value);
+  auto pos = find_node(value, code, equal_);
+  if (pos != nullptr)
+    return mystl::make_pair(iterator(pos), false);
+  if (static_cast<float>(size_ + 1) > (float)bucket_size_ * max_load_factor())
+    rehash(size_ + 1);
+  node_ptr np = traits::to_hook(&value);
+  np->hash_code = code;
+  link_bucket_begin(bucket_link(code), np);
+  ++size_;
+  return mystl::make_pair(iterator(np), true);
+}
+
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+typename intrusive_unordered_set<T, Hook, Hash, KeyEqual>::iterator
+intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+erase(const_iterator pos)
+{
+  MYSTL_DEBUG(pos != cend());
+  node_ptr p = pos.node_;
+  node_ptr next = p->next;
+  unlink_node(prev_link(p));
+  p->next = nullptr;
+  --size_;
+  return iterator(next);
+}
+
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+typename intrusive_unordered_set<T, Hook, Hash, KeyEqual>::iterator
+intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+erase(const_iterator first, const_iterator last)
+{
+  while (first != last)
+    first = erase(first);
+  return iterator(last.node_);
+}
+
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+typename intrusive_unordered_set<T, Hook, Hash, KeyEqual>::size_type
+intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+erase_key(const key_type& key)
+{
+  auto it = find(key);
+  if (it == end())
+    return 0;
+  erase(it);
+  return 1;
+}
+
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+void intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+clear() noexcept
+{
+  for (node_ptr p = head_; p != nullptr; )
+  {
+    node_ptr next = p->next;
+    p->next = nullptr;
+    p = next;
+  }
+  head_ = nullptr;
+  for (size_type i = 0; i < bucket_size_; ++i)
+    buckets_[i] = nullptr;
+  size_ = 0;
+}
+
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+void intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+swap(intrusive_unordered_set& rhs) noexcept
+{
+  if (this != &rhs)
+  {
+    mystl::swap(buckets_, rhs.buckets_);
+    mystl::swap(bucket_size_, rhs.bucket_size_);
+    mystl::swap(size_, rhs.size_);
+    mystl::swap(mlf_, rhs.mlf_);
+    mystl::swap(hash_, rhs.hash_);
+    mystl::swap(equal_, rhs.equal_);
+    mystl::swap(head_, rhs.head_);
+    update_head_bucket();
+    rhs.update_head_bucket();
+  }
+}
+
+// 重新分配 bucket，与 hashtable::rehash 的策略相同
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+void intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+rehash(size_type count)
+{
+  auto n = ht_next_prime(count);
+  if (n > bucket_size_)
+  {
+    replace_bucket(n);
+  }
+  else
+  {
+    if ((float)size_ / (float)n < max_load_factor() - 0.25f &&
+        (float)n < (float)bucket_size_ * 0.75)  // worth rehash
+    {
+      replace_bucket(n);
+    }
+  }
+}
+
+// helper function
+
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+typename intrusive_unordered_set<T, Hook, Hash, KeyEqual>::link_ptr*
+intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+allocate_buckets(size_type n)
+{
+  THROW_LENGTH_ERROR_IF(n > static_cast<size_type>(-1) / sizeof(link_ptr),
+                        "intrusive_unordered_set<T>'s bucket count too big");
+  link_ptr* buckets = bucket_allocator::allocate(n);
+  for (size_type i = 0; i < n; ++i)
+    buckets[i] = nullptr;
+  return buckets;
+}
+
+// 先比较保存在挂钩中的哈希值，再比较键值
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+template <class K, class KEqual>
+typename intrusive_unordered_set<T, Hook, Hash, KeyEqual>::node_ptr
+intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+find_node(const K& key, size_t code, const KEqual& kequal) const
+{
+  if (bucket_size_ == 0)  // 被移动后没有 bucket，插入时会重新分配
+    return nullptr;
+  const link_ptr* bucket = &bucket_link(code);
+  if (*bucket == nullptr)
+    return nullptr;
+  for (node_ptr p = **bucket; p != nullptr; p = bucket_next(p, code, bucket))
+  {
+    if (p->hash_code == code && kequal(key, *traits::to_value(p)))
+      return p;
+  }
+  return nullptr;
+}
+
+// 找到指向 node 的链接，即前一个节点的 next 成员或 head_ 的地址
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+typename intrusive_unordered_set<T, Hook, Hash, KeyEqual>::link_ptr
+intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+prev_link(node_ptr node) const noexcept
+{
+  link_ptr prev = bucket_link(node->hash_code);
+  MYSTL_DEBUG(prev != nullptr);
+  while (*prev != node)
+    prev = &(*prev)->next;
+  return prev;
+}
+
+// 以下两个函数及 replace_bucket 使用 hashtable 的链表算法，哈希值取自挂钩
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+void intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+link_bucket_begin(link_ptr& link, node_ptr np) noexcept
+{
+  ht_link_bucket_begin(head_, link, np, hook_code_of(), hook_bucket_of{ this });
+}
+
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+typename intrusive_unordered_set<T, Hook, Hash, KeyEqual>::node_ptr
+intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+unlink_node(link_ptr prev) noexcept
+{
+  return ht_unlink_node(prev, hook_code_of(), hook_bucket_of{ this });
+}
+
+// 把所有节点重新链接到新的 bucket 中，不调用哈希函数
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+void intrusive_unordered_set<T, Hook, Hash, KeyEqual>::
+replace_bucket(size_type bucket_count)
+{
+  auto buckets = allocate_buckets(bucket_count);
+  node_ptr first = head_;
+  head_ = nullptr;
+  bucket_allocator::deallocate(buckets_);
+  buckets_ = buckets;
+  bucket_size_ = bucket_count;
+  ht_relink_nodes(head_, first, hook_code_of(), hook_bucket_of{ this }, [](size_t) {});
+}
+
+// 重载 mystl 的 swap
+template <class T, hash_hook T::*Hook, class Hash, class KeyEqual>
+void swap(intrusive_unordered_set<T, Hook, Hash, KeyEqual>& lhs,
+          intrusive_unordered_set<T, Hook, Hash, KeyEqual>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_INTRUSIVE_UNORDERED_SET_H_
+
@@ -17,6 +17,7 @@
 
 #include <initializer_list>
 
+#include "algo.h"
 #include "iterator.h"
 #include "memory.h"
 #include "functional.h"
@@ -204,6 +205,12 @@ struct list_const_iterator : public iterator<bidirectional_iterator_tag, T>
   bool operator!=(const self& rhs) const { return node_ != rhs.node_; }
 };
 
+// 排序时先用插入排序把节点整理成长度为 list_sort_run 的有序段，再两两归并
+static constexpr size_t list_sort_run = 16;
+
+// 删除元素后，list 最多缓存 list_node_cache 个节点的空间，供之后插入元素时直接使用
+static constexpr size_t list_node_cache = 64;
+
 // 模板类: list
 // 模板参数 T 代表数据类型
 template <class T>
@@ -235,8 +242,11 @@ public:
   allocator_type get_allocator() { return node_allocator(); }
 
 private:
-  base_ptr  node_;  // 指向末尾节点
-  size_type size_;  // 大小
+  base_ptr  node_;        // 指向末尾节点
+  size_type size_;        // 大小
+  base_ptr  free_;        // 缓存的空闲节点，已析构元素，通过 next 串成单向链
+  size_type free_size_;   // 缓存的空闲节点个数
+  size_type free_limit_;  // 最多缓存的空闲节点个数
 
 public:
   // 构造、复制、移动、析构函数
@@ -261,10 +271,13 @@ public:
   { copy_init(rhs.cbegin(), rhs.cend()); }
 
   list(list&& rhs) noexcept
-    :node_(rhs.node_), size_(rhs.size_)
+    :node_(rhs.node_), size_(rhs.size_),
+     free_(rhs.free_), free_size_(rhs.free_size_), free_limit_(rhs.free_limit_)
   {
     rhs.node_ = nullptr;
     rhs.size_ = 0;
+    rhs.free_ = nullptr;
+    rhs.free_size_ = 0;
   }
 
   list& operator=(const list& rhs)
@@ -276,17 +289,23 @@ public:
     return *this;
   }
 
+  // 与移动构造函数一样带走 rhs 缓存的节点，本对象原有的缓存交给 rhs
   list& operator=(list&& rhs) noexcept
   {
-    clear();
-    splice(end(), rhs);
+    if (this != &rhs)
+    {
+      clear();
+      splice(end(), rhs);
+      mystl::swap(free_, rhs.free_);
+      mystl::swap(free_size_, rhs.free_size_);
+      mystl::swap(free_limit_, rhs.free_limit_);
+    }
     return *this;
   }
 
   list& operator=(std::initializer_list<T> ilist)
   {
-    list tmp(ilist.begin(), ilist.end());
-    swap(tmp);
+    copy_assign(ilist.begin(), ilist.end());
     return *this;
   }
 
@@ -299,6 +318,7 @@ public:
       node_ = nullptr;
       size_ = 0;
     }
+    release_node_cache();
   }
 
 public:
@@ -340,6 +360,30 @@ public:
   size_type max_size() const noexcept 
   { return static_cast<size_type>(-1); }
 
+  // 节点缓存相关操作
+  // 删除的节点不立即释放，而是缓存起来供之后的插入使用，
+  // 频繁删除又插入的 list（如 LRU 缓存、工作队列）因此不必每次都申请和释放内存
+
+  size_type node_cache_size()  const noexcept
+  { return free_size_; }
+
+  size_type node_cache_limit() const noexcept
+  { return free_limit_; }
+
+  // 设置最多缓存的节点个数，超出的缓存节点立即释放，设为 0 时不再缓存
+  void      node_cache_limit(size_type n) noexcept
+  {
+    free_limit_ = n;
+    trim_node_cache(n);
+  }
+
+  // 预先申请节点放入缓存，使缓存中至少有 n 个节点（不超过上限）
+  void      reserve_node_cache(size_type n);
+
+  // 释放所有缓存的节点
+  void      shrink_node_cache() noexcept
+  { trim_node_cache(0); }
+
   // 访问元素相关操作
   reference       front() 
   { 
@@ -507,6 +551,9 @@ public:
   {
     mystl::swap(node_, rhs.node_);
     mystl::swap(size_, rhs.size_);
+    mystl::swap(free_, rhs.free_);
+    mystl::swap(free_size_, rhs.free_size_);
+    mystl::swap(free_limit_, rhs.free_limit_);
   }
 
   // list 相关操作
@@ -530,11 +577,28 @@ public:
   template <class Compare>
   void merge(list& x, Compare comp);
 
+  // 稳定排序，自底向上地归并，不分配内存
   void sort()
-  { list_sort(begin(), end(), size(), mystl::less<T>()); }
+  { list_sort(mystl::less<T>(), false); }
   template <class Compared>
   void sort(Compared comp)
-  { list_sort(begin(), end(), size(), comp); }
+  { list_sort(comp, false); }
+
+  // 自然归并排序，与 sort 相同，但以原有的有序段（或严格递减段）为归并的单位，适合部分有序的 list
+  void sort_natural()
+  { list_sort(mystl::less<T>(), true); }
+  template <class Compared>
+  void sort_natural(Compared comp)
+  { list_sort(comp, true); }
+
+  // 间接排序，把节点指针收集到连续的数组中排序后再按顺序重新链接节点，
+  // 适合元素很多、遍历链表的缓存缺失占主导的 list，需要 2 * size() 个指针的临时空间，
+  // 申请不到时退化为 sort，比较操作抛出异常时 list 保持不变
+  void sort_indirect()
+  { list_sort_indirect(mystl::less<T>()); }
+  template <class Compared>
+  void sort_indirect(Compared comp)
+  { list_sort_indirect(comp); }
 
   void reverse();
 
@@ -546,6 +610,16 @@ private:
   node_ptr create_node(Args&& ...agrs);
   void     destroy_node(node_ptr p);
 
+  // node cache
+  node_ptr get_node();
+  void     put_node(node_ptr p) noexcept;
+  void     trim_node_cache(size_type n) noexcept;
+  void     release_node_cache() noexcept
+  {
+    trim_node_cache(0);
+    free_ = nullptr;
+  }
+
   // initialize
   void      fill_init(size_type n, const value_type& value);
   template <class Iter>
@@ -569,8 +643,17 @@ private:
   iterator  copy_insert(const_iterator pos, size_type n, Iter first);
 
   // sort
+  // 排序过程中的有序链以空结尾，首节点的 prev 指向尾节点，排序完成后再与 node_ 链接
+  template <class Compared>
+  static void sort_merge(base_ptr& a, base_ptr& b, Compared& comp);
+  template <class Compared>
+  static void sort_take_run(base_ptr& run, base_ptr& cur, size_type& len,
+                            Compared& comp, bool natural);
+  template <class Compared>
+  void      list_sort(Compared comp, bool natural);
   template <class Compared>
-  iterator  list_sort(iterator first, iterator last, size_type n, Compared comp);
+  void      list_sort_indirect(Compared comp);
+  void      relink_chain(base_ptr first);
 
 };
 
@@ -822,7 +905,7 @@ template <class ...Args>
 typename list<T>::node_ptr 
 list<T>::create_node(Args&& ...args)
 {
-  node_ptr p = node_allocator::allocate(1);
+  node_ptr p = get_node();
   try
   {
     data_allocator::construct(mystl::address_of(p->value), mystl::forward<Args>(args)...);
@@ -831,7 +914,7 @@ list<T>::create_node(Args&& ...args)
   }
   catch (...)
   {
-    node_allocator::deallocate(p);
+    put_node(p);
     throw;
   }
   return p;
@@ -842,13 +925,74 @@ template <class T>
 void list<T>::destroy_node(node_ptr p)
 {
   data_allocator::destroy(mystl::address_of(p->value));
-  node_allocator::deallocate(p);
+  put_node(p);
+}
+
+// 取得一个未构造元素的节点，优先使用缓存的节点
+template <class T>
+typename list<T>::node_ptr
+list<T>::get_node()
+{
+  if (free_ != nullptr)
+  {
+    node_ptr p = free_->as_node();
+    free_ = free_->next;
+    --free_size_;
+    return p;
+  }
+  return node_allocator::allocate(1);
+}
+
+// 归还一个已析构元素的节点，缓存未满时放入缓存，否则释放
+template <class T>
+void list<T>::put_node(node_ptr p) noexcept
+{
+  if (free_size_ < free_limit_)
+  {
+    p->next = free_;
+    free_ = p;
+    ++free_size_;
+  }
+  else
+  {
+    node_allocator::deallocate(p);
+  }
+}
+
+// 释放缓存的节点，直到只剩 n 个
+template <class T>
+void list<T>::trim_node_cache(size_type n) noexcept
+{
+  while (free_size_ > n)
+  {
+    node_ptr p = free_->as_node();
+    free_ = free_->next;
+    --free_size_;
+    node_allocator::deallocate(p);
+  }
+}
+
+// 预先申请节点放入缓存
+template <class T>
+void list<T>::reserve_node_cache(size_type n)
+{
+  n = mystl::min(n, free_limit_);
+  while (free_size_ < n)
+  {
+    node_ptr p = node_allocator::allocate(1);
+    p->next = free_;
+    free_ = p;
+    ++free_size_;
+  }
 }
 
 // 用 n 个元素初始化容器
 template <class T>
 void list<T>::fill_init(size_type n, const value_type& value)
 {
+  free_ = nullptr;
+  free_size_ = 0;
+  free_limit_ = list_node_cache;
   node_ = base_allocator::allocate(1);
   node_->unlink();
   size_ = n;
@@ -865,6 +1009,7 @@ void list<T>::fill_init(size_type n, const value_type& value)
     clear();
     base_allocator::deallocate(node_);
     node_ = nullptr;
+    release_node_cache();
     throw;
   }
 }
@@ -874,6 +1019,9 @@ template <class T>
 template <class Iter>
 void list<T>::copy_init(Iter first, Iter last)
 {
+  free_ = nullptr;
+  free_size_ = 0;
+  free_limit_ = list_node_cache;
   node_ = base_allocator::allocate(1);
   node_->unlink();
   size_type n = mystl::distance(first, last);
@@ -891,6 +1039,7 @@ void list<T>::copy_init(Iter first, Iter last)
     clear();
     base_allocator::deallocate(node_);
     node_ = nullptr;
+    release_node_cache();
     throw;
   }
 }
@@ -1078,81 +1227,313 @@ list<T>::copy_insert(const_iterator pos, size_type n, Iter first)
   return r;
 }
 
-// 对 list 进行归并排序，返回一个迭代器指向区间最小元素的位置
+// sort_merge 函数
+// 把有序链 b 合并到有序链 a 中，结果保存在 a 中，b 置为空，相等的元素 a 中的在前
+// 比较操作抛出异常时，所有节点仍然串在 a 上，但 prev 不再有效
 template <class T>
 template <class Compared>
-typename list<T>::iterator 
-list<T>::list_sort(iterator f1, iterator l2, size_type n, Compared comp)
+void list<T>::sort_merge(base_ptr& a, base_ptr& b, Compared& comp)
 {
-  if (n < 2)
-    return f1;
-
-  if (n == 2)
+  if (a == nullptr || b == nullptr)
   {
-    if (comp(*--l2, *f1))
+    if (a == nullptr)
+      a = b;
+    b = nullptr;
+    return;
+  }
+  const base_ptr a_tail = a->prev;
+  const base_ptr b_tail = b->prev;
+  base_ptr result = nullptr;
+  base_ptr* tail = &result;
+  base_ptr last = nullptr;
+  base_ptr x = a, y = b;
+  try
+  {
+    while (x != nullptr && y != nullptr)
     {
-      auto ln = l2.node_;
-      unlink_nodes(ln, ln);
-      link_nodes(f1.node_, ln, ln);
-      return l2;
+      if (comp(y->as_node()->value, x->as_node()->value))
+      {
+        *tail = y;
+        y->prev = last;
+        last = y;
+        y = y->next;
+      }
+      else
+      {
+        *tail = x;
+        x->prev = last;
+        last = x;
+        x = x->next;
+      }
+      tail = &last->next;
     }
-    return f1;
-  }
-
-  auto n2 = n / 2;
-  auto l1 = f1;
-  mystl::advance(l1, n2);
-  auto result = f1 = list_sort(f1, l1, n2, comp);  // 前半段的最小位置
-  auto f2 = l1 = list_sort(l1, l2, n - n2, comp);  // 后半段的最小位置
-
-  // 把较小的一段区间移到前面
-  if (comp(*f2, *f1))
-  {
-    auto m = f2;
-    ++m;
-    for (; m != l2 && comp(*m, *f1); ++m)
-      ;
-    auto f = f2.node_;
-    auto l = m.node_->prev;
-    result = f2;
-    l1 = f2 = m;
-    unlink_nodes(f, l);
-    m = f1;
-    ++m;
-    link_nodes(f1.node_, f, l);
-    f1 = m;
+  }
+  catch (...)
+  {
+    *tail = x;
+    while (*tail != nullptr)
+      tail = &(*tail)->next;
+    *tail = y;
+    a = result;
+    b = nullptr;
+    throw;
+  }
+  if (x != nullptr)
+  {
+    *tail = x;
+    x->prev = last;
+    result->prev = a_tail;
   }
   else
   {
-    ++f1;
+    *tail = y;
+    y->prev = last;
+    result->prev = b_tail;
   }
+  a = result;
+  b = nullptr;
+}
 
-  // 合并两段有序区间
-  while (f1 != l1 && f2 != l2)
+// sort_take_run 函数
+// 从链 cur 的头部取下一段节点，整理成有序链 run，len 为它的长度
+// natural 为 true 时先取下原有的非递减段或严格递减段（反转后仍然稳定），
+// 不足 list_sort_run 个节点时再用插入排序补足
+template <class T>
+template <class Compared>
+void list<T>::sort_take_run(base_ptr& run, base_ptr& cur, size_type& len,
+                            Compared& comp, bool natural)
+{
+  base_ptr tail = cur;
+  run = cur;
+  cur = cur->next;
+  run->next = nullptr;
+  run->prev = run;
+  len = 1;
+  if (natural && cur != nullptr)
+  {
+    if (comp(cur->as_node()->value, run->as_node()->value))
+    { // 严格递减段，逐个接在 run 的头部
+      while (cur != nullptr && comp(cur->as_node()->value, run->as_node()->value))
+      {
+        auto x = cur;
+        cur = cur->next;
+        x->next = run;
+        run->prev = x;
+        run = x;
+        ++len;
+      }
+    }
+    else
+    {
+      while (cur != nullptr && !comp(cur->as_node()->value, tail->as_node()->value))
+      {
+        tail->next = cur;
+        cur->prev = tail;
+        tail = cur;
+        cur = cur->next;
+        tail->next = nullptr;
+        ++len;
+      }
+    }
+    run->prev = tail;
+  }
+  // 插入排序，先与尾部比较，有序的输入只需要一次比较
+  while (cur != nullptr && len < list_sort_run)
   {
-    if (comp(*f2, *f1))
+    auto x = cur;
+    base_ptr pos = tail;  // x 插入在 pos 之后，pos 为空时插入在头部
+    if (comp(x->as_node()->value, tail->as_node()->value))
     {
-      auto m = f2;
-      ++m;
-      for (; m != l2 && comp(*m, *f1); ++m)
-        ;
-      auto f = f2.node_;
-      auto l = m.node_->prev;
-      if (l1 == f2)
-        l1 = m;
-      f2 = m;
-      unlink_nodes(f, l);
-      m = f1;
-      ++m;
-      link_nodes(f1.node_, f, l);
-      f1 = m;
+      if (comp(x->as_node()->value, run->as_node()->value))
+      {
+        pos = nullptr;
+      }
+      else
+      {
+        pos = run;
+        while (!comp(x->as_node()->value, pos->next->as_node()->value))
+          pos = pos->next;
+      }
+    }
+    // 比较完成之后才把 x 从 cur 上取下
+    cur = cur->next;
+    if (pos == nullptr)
+    {
+      x->next = run;
+      x->prev = tail;
+      run->prev = x;
+      run = x;
     }
     else
     {
-      ++f1;
+      x->next = pos->next;
+      x->prev = pos;
+      pos->next = x;
+      if (x->next != nullptr)
+        x->next->prev = x;
+      else
+        tail = run->prev = x;
+    }
+    ++len;
+  }
+}
+
+// list_sort 函数
+// 自底向上的归并排序，bins[i] 保存约 list_sort_run * 2^i 个节点的有序链，
+// 编号越大的 bin 中的节点在原来的 list 中越靠前，新的有序段依次与 bins[0], bins[1]... 合并，
+// 与二进制计数器的进位相同
+// 自然归并时较长的有序段直接放入与其长度相当的 bin，在此之前先把更小的 bin 合并到它的前面
+template <class T>
+template <class Compared>
+void list<T>::list_sort(Compared comp, bool natural)
+{
+  if (size_ < 2)
+    return;
+  base_ptr bins[sizeof(size_type) * 8] = {};
+  size_type max_bin = 0;  // 使用过的 bin 的个数
+  base_ptr run = nullptr;
+  base_ptr acc = nullptr;
+  base_ptr cur = node_->next;
+  node_->prev->next = nullptr;
+  try
+  {
+    while (cur != nullptr)
+    {
+      size_type len = 0;
+      sort_take_run(run, cur, len, comp, natural);
+      size_type level = 0;
+      for (len /= list_sort_run; len > 1; len >>= 1)
+        ++level;
+      for (size_type i = 0; i < level && i < max_bin; ++i)
+      {
+        if (bins[i] != nullptr)
+        {
+          sort_merge(bins[i], acc, comp);
+          mystl::swap(acc, bins[i]);
+        }
+      }
+      if (acc != nullptr)
+      {
+        sort_merge(acc, run, comp);
+        mystl::swap(run, acc);
+      }
+      size_type i = level;
+      for (; i < max_bin && bins[i] != nullptr; ++i)
+      {
+        sort_merge(bins[i], run, comp);
+        mystl::swap(run, bins[i]);
+      }
+      bins[i] = run;
+      run = nullptr;
+      if (i >= max_bin)
+        max_bin = i + 1;
     }
+    for (size_type i = 0; i < max_bin; ++i)
+    {
+      if (bins[i] != nullptr)
+      {
+        sort_merge(bins[i], run, comp);
+        mystl::swap(run, bins[i]);
+      }
+    }
+  }
+  catch (...)
+  { // 把所有的链接在一起，恢复成一个完整的 list，元素的顺序不确定
+    base_ptr* tail = &run;
+    auto append = [&tail](base_ptr chain)
+    {
+      while (*tail != nullptr)
+        tail = &(*tail)->next;
+      *tail = chain;
+    };
+    append(acc);
+    append(cur);
+    for (size_type i = 0; i < max_bin; ++i)
+      append(bins[i]);
+    relink_chain(run);
+    throw;
+  }
+  // 有序链中的 prev 已经有效，只需要链接头尾
+  const base_ptr last = run->prev;
+  node_->next = run;
+  run->prev = node_;
+  last->next = node_;
+  node_->prev = last;
+}
+
+// list_sort_indirect 函数
+// 在指针数组上做自底向上的归并排序，先对每 list_sort_run 个指针做插入排序，
+// 再在两个数组之间来回归并，最后按数组的顺序重新链接节点
+template <class T>
+template <class Compared>
+void list<T>::list_sort_indirect(Compared comp)
+{
+  if (size_ < 2)
+    return;
+  const auto n = static_cast<ptrdiff_t>(size_);
+  auto buf = mystl::get_temporary_buffer<base_ptr>(n * 2);
+  if (buf.second < n * 2)
+  {
+    mystl::release_temporary_buffer(buf.first);
+    list_sort(comp, false);
+    return;
+  }
+  base_ptr* a = buf.first;
+  base_ptr* b = buf.first + n;
+  {
+    ptrdiff_t i = 0;
+    for (auto cur = node_->next; cur != node_; cur = cur->next)
+      a[i++] = cur;
+  }
+  auto node_less = [&comp](base_ptr x, base_ptr y)
+  { return comp(x->as_node()->value, y->as_node()->value); };
+  const auto run = static_cast<ptrdiff_t>(list_sort_run);
+  try
+  {
+    for (ptrdiff_t i = 0; i < n; i += run)
+      mystl::insertion_sort(a + i, a + mystl::min(i + run, n), node_less);
+    for (ptrdiff_t width = run; width < n; width *= 2)
+    {
+      for (ptrdiff_t i = 0; i < n; i += width * 2)
+      {
+        const auto mid = mystl::min(i + width, n);
+        const auto last = mystl::min(i + width * 2, n);
+        mystl::merge(a + i, a + mid, a + mid, a + last, b + i, node_less);
+      }
+      mystl::swap(a, b);
+    }
+  }
+  catch (...)
+  { // 还没有改变任何链接
+    mystl::release_temporary_buffer(buf.first);
+    throw;
+  }
+  base_ptr prev = node_;
+  for (ptrdiff_t i = 0; i < n; ++i)
+  {
+    prev->next = a[i];
+    a[i]->prev = prev;
+    prev = a[i];
+  }
+  prev->next = node_;
+  node_->prev = prev;
+  mystl::release_temporary_buffer(buf.first);
+}
+
+// relink_chain 函数
+// 把以 first 开头、以空结尾的单向链重新链接成完整的 list，并恢复 prev
+template <class T>
+void list<T>::relink_chain(base_ptr first)
+{
+  base_ptr prev = node_;
+  for (; first != nullptr; first = first->next)
+  {
+    prev->next = first;
+    first->prev = prev;
+    prev = first;
   }
-  return result;
+  prev->next = node_;
+  node_->prev = prev;
 }
 
 // 重载比较操作符
@@ -18,6 +18,9 @@
 namespace mystl
 {
 
+template <class Key, class T, class Compare>
+class multimap;
+
 // 模板类 map，键值不允许重复
 // 参数一代表键值类型，参数二代表实值类型，参数三代表键值的比较方式，缺省使用 mystl::less
 template <class Key, class T, class Compare = mystl::less<Key>>
@@ -49,9 +52,15 @@ private:
   typedef mystl::rb_tree<value_type, key_compare>  base_type;
   base_type tree_;
 
+  // 不同比较方式的 map 与 multimap 之间可以相互转移节点
+  template <class, class, class> friend class map;
+  template <class, class, class> friend class multimap;
+
 public:
   // 使用 rb_tree 的型别
-  typedef typename base_type::node_type              node_type;
+  typedef mystl::node_handle<value_type, typename base_type::node_type, true> node_type;
+  typedef mystl::node_insert_return<typename base_type::iterator, node_type>
+                                                     insert_return_type;
   typedef typename base_type::pointer                pointer;
   typedef typename base_type::const_pointer          const_pointer;
   typedef typename base_type::reference              reference;
@@ -73,6 +82,11 @@ public:
   map(InputIterator first, InputIterator last)
     :tree_()
   { tree_.insert_unique(first, last); }
+  // 区间已经有序时，以线性时间构造
+  template <class InputIterator>
+  map(mystl::sorted_unique_tag tag, InputIterator first, InputIterator last)
+    :tree_()
+  { tree_.insert_unique(tag, first, last); }
 
   map(std::initializer_list<value_type> ilist) 
     :tree_()
@@ -196,6 +210,73 @@ public:
     return tree_.emplace_unique_use_hint(hint, mystl::forward<Args>(args)...);
   }
 
+  // try_emplace / insert_or_assign，键值已经存在时不会构造元素
+
+  template <class ...Args>
+  pair<iterator, bool> try_emplace(const key_type& key, Args&& ...args)
+  {
+    iterator it = lower_bound(key);
+    // it->first >= key
+    if (it != end() && !key_comp()(key, it->first))
+      return mystl::make_pair(it, false);
+    return mystl::make_pair(emplace_hint(it, mystl::piecewise_second, key,
+                                         mystl::forward<Args>(args)...), true);
+  }
+  template <class ...Args>
+  pair<iterator, bool> try_emplace(key_type&& key, Args&& ...args)
+  {
+    iterator it = lower_bound(key);
+    if (it != end() && !key_comp()(key, it->first))
+      return mystl::make_pair(it, false);
+    return mystl::make_pair(emplace_hint(it, mystl::piecewise_second, mystl::move(key),
+                                         mystl::forward<Args>(args)...), true);
+  }
+
+  template <class ...Args>
+  iterator try_emplace(iterator /*hint*/, const key_type& key, Args&& ...args)
+  {
+    return try_emplace(key, mystl::forward<Args>(args)...).first;
+  }
+  template <class ...Args>
+  iterator try_emplace(iterator /*hint*/, key_type&& key, Args&& ...args)
+  {
+    return try_emplace(mystl::move(key), mystl::forward<Args>(args)...).first;
+  }
+
+  template <class M>
+  pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+  {
+    iterator it = lower_bound(key);
+    if (it != end() && !key_comp()(key, it->first))
+    {
+      it->second = mystl::forward<M>(obj);
+      return mystl::make_pair(it, false);
+    }
+    return mystl::make_pair(emplace_hint(it, key, mystl::forward<M>(obj)), true);
+  }
+  template <class M>
+  pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
+  {
+    iterator it = lower_bound(key);
+    if (it != end() && !key_comp()(key, it->first))
+    {
+      it->second = mystl::forward<M>(obj);
+      return mystl::make_pair(it, false);
+    }
+    return mystl::make_pair(emplace_hint(it, mystl::move(key), mystl::forward<M>(obj)), true);
+  }
+
+  template <class M>
+  iterator insert_or_assign(iterator /*hint*/, const key_type& key, M&& obj)
+  {
+    return insert_or_assign(key, mystl::forward<M>(obj)).first;
+  }
+  template <class M>
+  iterator insert_or_assign(iterator /*hint*/, key_type&& key, M&& obj)
+  {
+    return insert_or_assign(mystl::move(key), mystl::forward<M>(obj)).first;
+  }
+
   pair<iterator, bool> insert(const value_type& value)
   {
     return tree_.insert_unique(value);
@@ -219,6 +300,11 @@ public:
   {
     tree_.insert_unique(first, last);
   }
+  template <class InputIterator>
+  void insert(mystl::sorted_unique_tag tag, InputIterator first, InputIterator last)
+  {
+    tree_.insert_unique(tag, first, last);
+  }
 
   void      erase(iterator position)             { tree_.erase(position); }
   size_type erase(const key_type& key)           { return tree_.erase_unique(key); }
@@ -226,6 +312,40 @@ public:
 
   void      clear()                              { tree_.clear(); }
 
+  // 节点的摘取与接合
+
+  node_type extract(const_iterator position)
+  { return node_type(tree_.extract_node(position)); }
+  node_type extract(const key_type& key)
+  {
+    auto it = tree_.find(key);
+    return it == tree_.end() ? node_type() : node_type(tree_.extract_node(it));
+  }
+
+  insert_return_type insert(node_type&& nh)
+  {
+    if (nh.empty())
+      return insert_return_type{end(), false, node_type()};
+    auto res = tree_.reinsert_node_unique(nh.get());
+    if (!res.second)
+      return insert_return_type{res.first, false, mystl::move(nh)};
+    nh.release();
+    return insert_return_type{res.first, true, node_type()};
+  }
+
+  template <class Compare2>
+  void      merge(map<Key, T, Compare2>& source)
+  { tree_.merge_unique(source.tree_); }
+  template <class Compare2>
+  void      merge(map<Key, T, Compare2>&& source)
+  { tree_.merge_unique(source.tree_); }
+  template <class Compare2>
+  void      merge(multimap<Key, T, Compare2>& source)
+  { tree_.merge_unique(source.tree_); }
+  template <class Compare2>
+  void      merge(multimap<Key, T, Compare2>&& source)
+  { tree_.merge_unique(source.tree_); }
+
   // map 相关操作
 
   iterator       find(const key_type& key)              { return tree_.find(key); }
@@ -247,6 +367,16 @@ public:
     equal_range(const key_type& key) const 
   { return tree_.equal_range_unique(key); }
 
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计相关操作，以 O(logn) 的时间完成
+
+  iterator       nth(size_type k)                       { return tree_.nth(k); }
+  const_iterator nth(size_type k)                 const { return tree_.nth(k); }
+
+  size_type      rank(const key_type& key)        const { return tree_.rank(key); }
+  size_type      index_of(const_iterator it)      const { return tree_.index_of(it); }
+#endif
+
   void           swap(map& rhs) noexcept
   { tree_.swap(rhs.tree_); }
 
@@ -332,9 +462,13 @@ private:
   typedef mystl::rb_tree<value_type, key_compare>  base_type;
   base_type tree_;
 
+  // 不同比较方式的 map 与 multimap 之间可以相互转移节点
+  template <class, class, class> friend class map;
+  template <class, class, class> friend class multimap;
+
 public:
   // 使用 rb_tree 的型别
-  typedef typename base_type::node_type              node_type;
+  typedef mystl::node_handle<value_type, typename base_type::node_type, true> node_type;
   typedef typename base_type::pointer                pointer;
   typedef typename base_type::const_pointer          const_pointer;
   typedef typename base_type::reference              reference;
@@ -356,6 +490,11 @@ public:
   multimap(InputIterator first, InputIterator last) 
     :tree_() 
   { tree_.insert_multi(first, last); }
+  // 区间已经有序时，以线性时间构造
+  template <class InputIterator>
+  multimap(mystl::sorted_equivalent_tag tag, InputIterator first, InputIterator last)
+    :tree_()
+  { tree_.insert_multi(tag, first, last); }
   multimap(std::initializer_list<value_type> ilist) 
     :tree_() 
   { tree_.insert_multi(ilist.begin(), ilist.end()); }
@@ -464,6 +603,11 @@ public:
   {
     tree_.insert_multi(first, last);
   }
+  template <class InputIterator>
+  void insert(mystl::sorted_equivalent_tag tag, InputIterator first, InputIterator last)
+  {
+    tree_.insert_multi(tag, first, last);
+  }
 
   void           erase(iterator position)             { tree_.erase(position); }
   size_type      erase(const key_type& key)           { return tree_.erase_multi(key); }
@@ -471,6 +615,38 @@ public:
 
   void           clear() { tree_.clear(); }
 
+  // 节点的摘取与接合
+
+  node_type extract(const_iterator position)
+  { return node_type(tree_.extract_node(position)); }
+  node_type extract(const key_type& key)
+  {
+    auto it = tree_.find(key);
+    return it == tree_.end() ? node_type() : node_type(tree_.extract_node(it));
+  }
+
+  iterator  insert(node_type&& nh)
+  {
+    if (nh.empty())
+      return end();
+    auto it = tree_.reinsert_node_multi(nh.get());
+    nh.release();
+    return it;
+  }
+
+  template <class Compare2>
+  void      merge(map<Key, T, Compare2>& source)
+  { tree_.merge_multi(source.tree_); }
+  template <class Compare2>
+  void      merge(map<Key, T, Compare2>&& source)
+  { tree_.merge_multi(source.tree_); }
+  template <class Compare2>
+  void      merge(multimap<Key, T, Compare2>& source)
+  { tree_.merge_multi(source.tree_); }
+  template <class Compare2>
+  void      merge(multimap<Key, T, Compare2>&& source)
+  { tree_.merge_multi(source.tree_); }
+
   // multimap 相关操作
 
   iterator       find(const key_type& key)              { return tree_.find(key); }
@@ -492,6 +668,16 @@ public:
     equal_range(const key_type& key) const 
   { return tree_.equal_range_multi(key); }
 
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计相关操作，以 O(logn) 的时间完成
+
+  iterator       nth(size_type k)                       { return tree_.nth(k); }
+  const_iterator nth(size_type k)                 const { return tree_.nth(k); }
+
+  size_type      rank(const key_type& key)        const { return tree_.rank(key); }
+  size_type      index_of(const_iterator it)      const { return tree_.index_of(it); }
+#endif
+
   void swap(multimap& rhs) noexcept
   { tree_.swap(rhs.tree_); }
 
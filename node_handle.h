@@ -0,0 +1,176 @@
+﻿#ifndef MYTINYSTL_NODE_HANDLE_H_
+#define MYTINYSTL_NODE_HANDLE_H_
+
+// 这个头文件包含两个模板类 node_handle 和 node_insert_return
+// node_handle        : 节点句柄，持有从关联式容器中摘取出来的节点，
+//                      用于在容器之间转移元素，不需要重新分配节点或移动元素
+// node_insert_return : 以节点句柄插入时的返回值类型
+
+#include "util.h"
+#include "type_traits.h"
+#include "allocator.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// node_handle 的基类，负责管理节点的所有权
+// 参数一代表数据类型，参数二代表节点类型
+template <class T, class Node>
+class node_handle_base
+{
+public:
+  typedef mystl::allocator<T>    allocator_type;
+  typedef mystl::allocator<T>    data_allocator;
+  typedef mystl::allocator<Node> node_allocator;
+  typedef Node*                  node_ptr;
+
+protected:
+  node_ptr node_;  // 持有的节点，为空表示句柄为空
+
+public:
+  // 构造、移动、析构函数
+  constexpr node_handle_base() noexcept
+    :node_(nullptr)
+  {
+  }
+  explicit node_handle_base(node_ptr node) noexcept
+    :node_(node)
+  {
+  }
+
+  node_handle_base(node_handle_base&& rhs) noexcept
+    :node_(rhs.node_)
+  {
+    rhs.node_ = nullptr;
+  }
+
+  node_handle_base& operator=(node_handle_base&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      reset();
+      node_ = rhs.node_;
+      rhs.node_ = nullptr;
+    }
+    return *this;
+  }
+
+  node_handle_base(const node_handle_base&) = delete;
+  node_handle_base& operator=(const node_handle_base&) = delete;
+
+  ~node_handle_base() { reset(); }
+
+public:
+  bool           empty()         const noexcept { return node_ == nullptr; }
+  explicit       operator bool() const noexcept { return node_ != nullptr; }
+  allocator_type get_allocator() const          { return allocator_type(); }
+
+  // 返回持有的节点，不改变所有权
+  node_ptr get() const noexcept { return node_; }
+
+  // 放弃节点的所有权，交给容器接管
+  node_ptr release() noexcept
+  {
+    auto p = node_;
+    node_ = nullptr;
+    return p;
+  }
+
+  void swap(node_handle_base& rhs) noexcept
+  {
+    mystl::swap(node_, rhs.node_);
+  }
+
+protected:
+  // 句柄不为空时，销毁节点
+  void reset()
+  {
+    if (node_ != nullptr)
+    {
+      data_allocator::destroy(&node_->value);
+      node_allocator::deallocate(node_);
+      node_ = nullptr;
+    }
+  }
+};
+
+// 模板类 node_handle
+// 参数一代表数据类型，参数二代表节点类型，参数三表示是否为 map 类容器的节点
+// set 类容器的句柄通过 value 访问元素，map 类容器的句柄通过 key 和 mapped 访问元素
+template <class T, class Node, bool IsMap = mystl::is_pair<T>::value>
+class node_handle :public node_handle_base<T, Node>
+{
+public:
+  typedef node_handle_base<T, Node>      base;
+  typedef typename base::node_ptr        node_ptr;
+  typedef T                              value_type;
+
+public:
+  node_handle() = default;
+  explicit node_handle(node_ptr node) noexcept
+    :base(node)
+  {
+  }
+  node_handle(node_handle&&) = default;
+  node_handle& operator=(node_handle&&) = default;
+
+  value_type& value() const
+  {
+    MYSTL_DEBUG(!this->empty());
+    return this->node_->value;
+  }
+};
+
+template <class T, class Node>
+class node_handle<T, Node, true> :public node_handle_base<T, Node>
+{
+public:
+  typedef node_handle_base<T, Node>                             base;
+  typedef typename base::node_ptr                               node_ptr;
+  typedef typename std::remove_cv<typename T::first_type>::type key_type;
+  typedef typename T::second_type                               mapped_type;
+
+public:
+  node_handle() = default;
+  explicit node_handle(node_ptr node) noexcept
+    :base(node)
+  {
+  }
+  node_handle(node_handle&&) = default;
+  node_handle& operator=(node_handle&&) = default;
+
+  // 节点不在容器中，可以修改键值
+  key_type& key() const
+  {
+    MYSTL_DEBUG(!this->empty());
+    return const_cast<key_type&>(this->node_->value.first);
+  }
+
+  mapped_type& mapped() const
+  {
+    MYSTL_DEBUG(!this->empty());
+    return this->node_->value.second;
+  }
+};
+
+// 重载 mystl 的 swap
+template <class T, class Node, bool IsMap>
+void swap(node_handle<T, Node, IsMap>& lhs, node_handle<T, Node, IsMap>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+// 以节点句柄插入到键值不允许重复的容器时的返回值
+// position 指向插入的元素或者与之键值相等的元素，inserted 表示是否插入成功，
+// 插入失败时 node 持有原来的节点
+template <class Iterator, class NodeHandle>
+struct node_insert_return
+{
+  Iterator   position;
+  bool       inserted;
+  NodeHandle node;
+};
+
+} // namespace mystl
+#endif // !MYTINYSTL_NODE_HANDLE_H_
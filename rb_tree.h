@@ -3,16 +3,25 @@
 
 // 这个头文件包含一个模板类 rb_tree
 // rb_tree : 红黑树
+//
+// 在包含此头文件之前定义 MYSTL_RB_TREE_ORDER_STATISTICS，每个节点会额外记录以它为根的子树的节点数，
+// 从而以 O(logn) 的时间支持 nth、rank 以及 rb tree 迭代器之间的 distance
+//
+// 在包含此头文件之前定义 MYSTL_RB_TREE_COMPACT，节点颜色会存放在父节点指针的最低位，
+// 64 位平台上每个节点的头部由 32 字节缩减为 24 字节
 
 #include <initializer_list>
 
 #include <cassert>
+#include <cstdint>
 
 #include "functional.h"
 #include "iterator.h"
 #include "memory.h"
+#include "vector.h"
 #include "type_traits.h"
 #include "exceptdef.h"
+#include "node_handle.h"
 
 namespace mystl
 {
@@ -123,10 +132,21 @@ struct rb_tree_node_base
   typedef rb_tree_node_base<T>* base_ptr;
   typedef rb_tree_node<T>*      node_ptr;
 
+#ifdef MYSTL_RB_TREE_COMPACT
+  static_assert(alignof(base_ptr) >= 2, "the lowest bit of a node pointer must be zero");
+
+  uintptr_t  parent_color;  // 父节点指针，最低位存放节点颜色
+  base_ptr   left;          // 左子节点
+  base_ptr   right;         // 右子节点
+#else
   base_ptr   parent;  // 父节点
   base_ptr   left;    // 左子节点
   base_ptr   right;   // 右子节点
   color_type color;   // 节点颜色
+#endif
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  size_t     size;    // 以该节点为根的子树的节点数
+#endif
 
   base_ptr get_base_ptr()
   {
@@ -144,6 +164,79 @@ struct rb_tree_node_base
   }
 };
 
+// 节点的父节点与颜色只通过以下函数访问，以便在两种节点布局下共用同一套算法
+
+#ifdef MYSTL_RB_TREE_COMPACT
+template <class T>
+rb_tree_node_base<T>* rb_tree_parent(const rb_tree_node_base<T>* node) noexcept
+{
+  return reinterpret_cast<rb_tree_node_base<T>*>(node->parent_color & ~static_cast<uintptr_t>(1));
+}
+
+template <class T>
+void rb_tree_set_parent(rb_tree_node_base<T>* node,
+                        typename rb_tree_node_base<T>::base_ptr parent) noexcept
+{
+  node->parent_color = reinterpret_cast<uintptr_t>(parent) | (node->parent_color & 1);
+}
+
+template <class T>
+rb_tree_color_type rb_tree_color(const rb_tree_node_base<T>* node) noexcept
+{
+  return (node->parent_color & 1) != 0;
+}
+
+template <class T>
+void rb_tree_set_color(rb_tree_node_base<T>* node, rb_tree_color_type color) noexcept
+{
+  node->parent_color = (node->parent_color & ~static_cast<uintptr_t>(1)) |
+                       static_cast<uintptr_t>(color);
+}
+
+// 同时设置父节点与颜色，用于初始化尚未设置过这两项的节点
+template <class T>
+void rb_tree_init_parent_color(rb_tree_node_base<T>* node,
+                               typename rb_tree_node_base<T>::base_ptr parent,
+                               rb_tree_color_type color) noexcept
+{
+  node->parent_color = reinterpret_cast<uintptr_t>(parent) | static_cast<uintptr_t>(color);
+}
+#else
+template <class T>
+rb_tree_node_base<T>* rb_tree_parent(const rb_tree_node_base<T>* node) noexcept
+{
+  return node->parent;
+}
+
+template <class T>
+void rb_tree_set_parent(rb_tree_node_base<T>* node,
+                        typename rb_tree_node_base<T>::base_ptr parent) noexcept
+{
+  node->parent = parent;
+}
+
+template <class T>
+rb_tree_color_type rb_tree_color(const rb_tree_node_base<T>* node) noexcept
+{
+  return node->color;
+}
+
+template <class T>
+void rb_tree_set_color(rb_tree_node_base<T>* node, rb_tree_color_type color) noexcept
+{
+  node->color = color;
+}
+
+template <class T>
+void rb_tree_init_parent_color(rb_tree_node_base<T>* node,
+                               typename rb_tree_node_base<T>::base_ptr parent,
+                               rb_tree_color_type color) noexcept
+{
+  node->parent = parent;
+  node->color = color;
+}
+#endif
+
 template <class T>
 struct rb_tree_node :public rb_tree_node_base<T>
 {
@@ -206,11 +299,11 @@ struct rb_tree_iterator_base :public mystl::iterator<mystl::bidirectional_iterat
     }
     else
     {  // 如果没有右子节点
-      auto y = node->parent;
+      auto y = rb_tree_parent(node);
       while (y->right == node)
       {
         node = y;
-        y = y->parent;
+        y = rb_tree_parent(y);
       }
       if (node->right != y)  // 应对“寻找根节点的下一节点，而根节点没有右子节点”的特殊情况
         node = y;
@@ -220,7 +313,7 @@ struct rb_tree_iterator_base :public mystl::iterator<mystl::bidirectional_iterat
   // 使迭代器后退
   void dec()
   {
-    if (node->parent->parent == node && rb_tree_is_red(node))
+    if (rb_tree_parent(rb_tree_parent(node)) == node && rb_tree_is_red(node))
     { // 如果 node 为 header
       node = node->right;  // 指向整棵树的 max 节点
     }
@@ -230,11 +323,11 @@ struct rb_tree_iterator_base :public mystl::iterator<mystl::bidirectional_iterat
     }
     else
     {  // 非 header 节点，也无左子节点
-      auto y = node->parent;
+      auto y = rb_tree_parent(node);
       while (node == y->left)
       {
         node = y;
-        y = y->parent;
+        y = rb_tree_parent(y);
       }
       node = y;
     }
@@ -369,25 +462,25 @@ NodePtr rb_tree_max(NodePtr x) noexcept
 template <class NodePtr>
 bool rb_tree_is_lchild(NodePtr node) noexcept
 {
-  return node == node->parent->left;
+  return node == rb_tree_parent(node)->left;
 }
 
 template <class NodePtr>
 bool rb_tree_is_red(NodePtr node) noexcept
 {
-  return node->color == rb_tree_red;
+  return rb_tree_color(node) == rb_tree_red;
 }
 
 template <class NodePtr>
-void rb_tree_set_black(NodePtr& node) noexcept
+void rb_tree_set_black(NodePtr node) noexcept
 {
-  node->color = rb_tree_black;
+  rb_tree_set_color(node, rb_tree_black);
 }
 
 template <class NodePtr>
-void rb_tree_set_red(NodePtr& node) noexcept
+void rb_tree_set_red(NodePtr node) noexcept
 {
-  node->color = rb_tree_red;
+  rb_tree_set_color(node, rb_tree_red);
 }
 
 template <class NodePtr>
@@ -396,10 +489,91 @@ NodePtr rb_tree_next(NodePtr node) noexcept
   if (node->right != nullptr)
     return rb_tree_min(node->right);
   while (!rb_tree_is_lchild(node))
-    node = node->parent;
-  return node->parent;
+    node = rb_tree_parent(node);
+  return rb_tree_parent(node);
+}
+
+// 子树大小的维护
+// 未定义 MYSTL_RB_TREE_ORDER_STATISTICS 时，以下函数为空操作
+
+template <class NodePtr>
+size_t rb_tree_subtree_size(NodePtr x) noexcept
+{
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  return x == nullptr ? 0 : x->size;
+#else
+  (void)x;
+  return 0;
+#endif
+}
+
+template <class NodePtr>
+void rb_tree_set_size(NodePtr x, size_t n) noexcept
+{
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  x->size = n;
+#else
+  (void)x;
+  (void)n;
+#endif
+}
+
+// 根据左右子树重新计算 x 的子树大小
+template <class NodePtr>
+void rb_tree_update_size(NodePtr x) noexcept
+{
+  rb_tree_set_size(x, rb_tree_subtree_size(x->left) + rb_tree_subtree_size(x->right) + 1);
 }
 
+// 把 x 的所有祖先（不含 header）的子树大小加上 delta
+template <class NodePtr>
+void rb_tree_add_size_upward(NodePtr x, NodePtr root, int delta) noexcept
+{
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  for (; x != root; x = rb_tree_parent(x))
+    rb_tree_parent(x)->size += delta;
+#else
+  (void)x;
+  (void)root;
+  (void)delta;
+#endif
+}
+
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+// 返回节点 x 在中序中的位置，x 为 header 时返回节点总数
+template <class NodePtr>
+size_t rb_tree_index(NodePtr x) noexcept
+{
+  if (rb_tree_parent(x) == nullptr)  // 空树的 header
+    return 0;
+  if (rb_tree_parent(rb_tree_parent(x)) == x && rb_tree_is_red(x))  // 非空树的 header
+    return rb_tree_parent(x)->size;
+  size_t index = rb_tree_subtree_size(x->left);
+  while (rb_tree_parent(rb_tree_parent(x)) != x)  // x 不是根节点
+  {
+    if (!rb_tree_is_lchild(x))
+      index += rb_tree_subtree_size(rb_tree_parent(x)->left) + 1;
+    x = rb_tree_parent(x);
+  }
+  return index;
+}
+
+// 重载 mystl 的 distance，rb tree 迭代器之间的距离可以在 O(logn) 时间内求出
+template <class T>
+ptrdiff_t distance(rb_tree_iterator<T> first, rb_tree_iterator<T> last)
+{
+  return static_cast<ptrdiff_t>(rb_tree_index(last.node)) -
+         static_cast<ptrdiff_t>(rb_tree_index(first.node));
+}
+
+template <class T>
+ptrdiff_t distance(rb_tree_const_iterator<T> first, rb_tree_const_iterator<T> last)
+{
+  return static_cast<ptrdiff_t>(rb_tree_index(last.node)) -
+         static_cast<ptrdiff_t>(rb_tree_index(first.node));
+}
+#endif
+
 /*---------------------------------------*\
 |       p                         p       |
 |      / \                       / \      |
@@ -416,8 +590,8 @@ void rb_tree_rotate_left(NodePtr x, NodePtr& root) noexcept
   auto y = x->right;  // y 为 x 的右子节点
   x->right = y->left;
   if (y->left != nullptr)
-    y->left->parent = x;
-  y->parent = x->parent;
+    rb_tree_set_parent(y->left, x);
+  rb_tree_set_parent(y, rb_tree_parent(x));
 
   if (x == root)
   { // 如果 x 为根节点，让 y 顶替 x 成为根节点
@@ -425,15 +599,17 @@ void rb_tree_rotate_left(NodePtr x, NodePtr& root) noexcept
   }
   else if (rb_tree_is_lchild(x))
   { // 如果 x 是左子节点
-    x->parent->left = y;
+    rb_tree_parent(x)->left = y;
   }
   else
   { // 如果 x 是右子节点
-    x->parent->right = y;
+    rb_tree_parent(x)->right = y;
   }
   // 调整 x 与 y 的关系
   y->left = x;  
-  x->parent = y;
+  rb_tree_set_parent(x, y);
+  rb_tree_update_size(x);
+  rb_tree_update_size(y);
 }
 
 /*----------------------------------------*\
@@ -452,8 +628,8 @@ void rb_tree_rotate_right(NodePtr x, NodePtr& root) noexcept
   auto y = x->left;
   x->left = y->right;
   if (y->right)
-    y->right->parent = x;
-  y->parent = x->parent;
+    rb_tree_set_parent(y->right, x);
+  rb_tree_set_parent(y, rb_tree_parent(x));
 
   if (x == root)
   { // 如果 x 为根节点，让 y 顶替 x 成为根节点
@@ -461,15 +637,17 @@ void rb_tree_rotate_right(NodePtr x, NodePtr& root) noexcept
   }
   else if (rb_tree_is_lchild(x))
   { // 如果 x 是右子节点
-    x->parent->left = y;
+    rb_tree_parent(x)->left = y;
   }
   else
   { // 如果 x 是左子节点
-    x->parent->right = y;
+    rb_tree_parent(x)->right = y;
   }
   // 调整 x 与 y 的关系
   y->right = x;                      
-  x->parent = y;
+  rb_tree_set_parent(x, y);
+  rb_tree_update_size(x);
+  rb_tree_update_size(y);
 }
 
 // 插入节点后使 rb tree 重新平衡，参数一为新增节点，参数二为根节点
@@ -488,41 +666,43 @@ void rb_tree_rotate_right(NodePtr x, NodePtr& root) noexcept
 template <class NodePtr>
 void rb_tree_insert_rebalance(NodePtr x, NodePtr& root) noexcept
 {
+  rb_tree_set_size(x, 1);
+  rb_tree_add_size_upward(x, root, 1);
   rb_tree_set_red(x);  // 新增节点为红色
-  while (x != root && rb_tree_is_red(x->parent))
+  while (x != root && rb_tree_is_red(rb_tree_parent(x)))
   {
-    if (rb_tree_is_lchild(x->parent))
+    if (rb_tree_is_lchild(rb_tree_parent(x)))
     { // 如果父节点是左子节点
-      auto uncle = x->parent->parent->right;
+      auto uncle = rb_tree_parent(rb_tree_parent(x))->right;
       if (uncle != nullptr && rb_tree_is_red(uncle))
       { // case 3: 父节点和叔叔节点都为红
-        rb_tree_set_black(x->parent);
+        rb_tree_set_black(rb_tree_parent(x));
         rb_tree_set_black(uncle);
-        x = x->parent->parent;
+        x = rb_tree_parent(rb_tree_parent(x));
         rb_tree_set_red(x);
       }
       else
       { // 无叔叔节点或叔叔节点为黑
         if (!rb_tree_is_lchild(x))
         { // case 4: 当前节点 x 为右子节点
-          x = x->parent;
+          x = rb_tree_parent(x);
           rb_tree_rotate_left(x, root);
         }
         // 都转换成 case 5： 当前节点为左子节点
-        rb_tree_set_black(x->parent);
-        rb_tree_set_red(x->parent->parent);
-        rb_tree_rotate_right(x->parent->parent, root);
+        rb_tree_set_black(rb_tree_parent(x));
+        rb_tree_set_red(rb_tree_parent(rb_tree_parent(x)));
+        rb_tree_rotate_right(rb_tree_parent(rb_tree_parent(x)), root);
         break;
       }
     }
     else  // 如果父节点是右子节点，对称处理
     { 
-      auto uncle = x->parent->parent->left;
+      auto uncle = rb_tree_parent(rb_tree_parent(x))->left;
       if (uncle != nullptr && rb_tree_is_red(uncle))
       { // case 3: 父节点和叔叔节点都为红
-        rb_tree_set_black(x->parent);
+        rb_tree_set_black(rb_tree_parent(x));
         rb_tree_set_black(uncle);
-        x = x->parent->parent;
+        x = rb_tree_parent(rb_tree_parent(x));
         rb_tree_set_red(x);
         // 此时祖父节点为红，可能会破坏红黑树的性质，令当前节点为祖父节点，继续处理
       }
@@ -530,13 +710,13 @@ void rb_tree_insert_rebalance(NodePtr x, NodePtr& root) noexcept
       { // 无叔叔节点或叔叔节点为黑
         if (rb_tree_is_lchild(x))
         { // case 4: 当前节点 x 为左子节点
-          x = x->parent;
+          x = rb_tree_parent(x);
           rb_tree_rotate_right(x, root);
         }
         // 都转换成 case 5： 当前节点为左子节点
-        rb_tree_set_black(x->parent);
-        rb_tree_set_red(x->parent->parent);
-        rb_tree_rotate_left(x->parent->parent, root);
+        rb_tree_set_black(rb_tree_parent(x));
+        rb_tree_set_red(rb_tree_parent(rb_tree_parent(x)));
+        rb_tree_rotate_left(rb_tree_parent(rb_tree_parent(x)), root);
         break;
       }
     }
@@ -557,24 +737,26 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
   auto x = y->left != nullptr ? y->left : y->right;
   // xp 为 x 的父节点
   NodePtr xp = nullptr;
+  // y 将被摘下，其所有祖先的子树大小减一
+  rb_tree_add_size_upward(y, root, -1);
 
   // y != z 说明 z 有两个非空子节点，此时 y 指向 z 右子树的最左节点，x 指向 y 的右子节点。
   // 用 y 顶替 z 的位置，用 x 顶替 y 的位置，最后用 y 指向 z
   if (y != z)
   {
-    z->left->parent = y;
+    rb_tree_set_parent(z->left, y);
     y->left = z->left;
 
     // 如果 y 不是 z 的右子节点，那么 z 的右子节点一定有左孩子
     if (y != z->right)
     { // x 替换 y 的位置
-      xp = y->parent;
+      xp = rb_tree_parent(y);
       if (x != nullptr)
-        x->parent = y->parent;
+        rb_tree_set_parent(x, rb_tree_parent(y));
 
-      y->parent->left = x;
+      rb_tree_parent(y)->left = x;
       y->right = z->right;
-      z->right->parent = y;
+      rb_tree_set_parent(z->right, y);
     }
     else
     {
@@ -585,27 +767,30 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
     if (root == z)
       root = y;
     else if (rb_tree_is_lchild(z))
-      z->parent->left = y;
+      rb_tree_parent(z)->left = y;
     else
-      z->parent->right = y;
-    y->parent = z->parent;
-    mystl::swap(y->color, z->color);
+      rb_tree_parent(z)->right = y;
+    rb_tree_set_parent(y, rb_tree_parent(z));
+    auto color = rb_tree_color(y);
+    rb_tree_set_color(y, rb_tree_color(z));
+    rb_tree_set_color(z, color);
+    rb_tree_set_size(y, rb_tree_subtree_size(z));
     y = z;
   }
   // y == z 说明 z 至多只有一个孩子
   else
   { 
-    xp = y->parent;
+    xp = rb_tree_parent(y);
     if (x)  
-      x->parent = y->parent;
+      rb_tree_set_parent(x, rb_tree_parent(y));
 
     // 连接 x 与 z 的父节点
     if (root == z)
       root = x;
     else if (rb_tree_is_lchild(z))
-      z->parent->left = x;
+      rb_tree_parent(z)->left = x;
     else
-      z->parent->right = x;
+      rb_tree_parent(z)->right = x;
 
     // 此时 z 有可能是最左节点或最右节点，更新数据
     if (leftmost == z)
@@ -642,7 +827,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
         { // case 2
           rb_tree_set_red(brother);
           x = xp;
-          xp = xp->parent;
+          xp = rb_tree_parent(xp);
         }
         else
         { 
@@ -655,7 +840,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
             brother = xp->right;
           }
           // 转为 case 4
-          brother->color = xp->color;
+          rb_tree_set_color(brother, rb_tree_color(xp));
           rb_tree_set_black(xp);
           if (brother->right != nullptr)  
             rb_tree_set_black(brother->right);
@@ -678,7 +863,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
         { // case 2
           rb_tree_set_red(brother);
           x = xp;
-          xp = xp->parent;
+          xp = rb_tree_parent(xp);
         }
         else
         {
@@ -691,7 +876,7 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
             brother = xp->left;
           }
           // 转为 case 4
-          brother->color = xp->color;
+          rb_tree_set_color(brother, rb_tree_color(xp));
           rb_tree_set_black(xp);
           if (brother->left != nullptr)  
             rb_tree_set_black(brother->left);
@@ -711,6 +896,9 @@ NodePtr rb_tree_erase_rebalance(NodePtr z, NodePtr& root, NodePtr& leftmost, Nod
 template <class T, class Compare>
 class rb_tree
 {
+  // 不同比较方式的 rb_tree 之间可以相互转移节点
+  template <class, class> friend class rb_tree;
+
 public:
   // rb_tree 的嵌套型别定义 
   
@@ -754,10 +942,13 @@ private:
 
 private:
   // 以下三个函数用于取得根节点，最小节点和最大节点
-  base_ptr& root()      const { return header_->parent; }
+  base_ptr  root()      const { return rb_tree_parent(header_); }
   base_ptr& leftmost()  const { return header_->left; }
   base_ptr& rightmost() const { return header_->right; }
 
+  // 根节点存放在 header_ 的父节点中，紧凑布局下无法取得其引用，需通过此函数修改
+  void      set_root(base_ptr x) { rb_tree_set_parent(header_, x); }
+
 public:
   // 构造、复制、析构函数
   rb_tree() { rb_tree_init(); }
@@ -768,7 +959,7 @@ public:
   rb_tree& operator=(const rb_tree& rhs);
   rb_tree& operator=(rb_tree&& rhs);
 
-  ~rb_tree() { clear(); }
+  ~rb_tree() { clear(); base_allocator::deallocate(header_); }
 
 public:
   // 迭代器相关操作
@@ -839,13 +1030,17 @@ public:
     return emplace_multi_use_hint(hint, mystl::move(value));
   }
 
+  // 批量插入，区间较大时先排序，再与已有节点归并，以线性时间重建平衡的 rb tree
   template <class InputIterator>
   void      insert_multi(InputIterator first, InputIterator last)
   {
-    size_type n = mystl::distance(first, last);
-    THROW_LENGTH_ERROR_IF(node_count_ > max_size() - n, "rb_tree<T, Comp>'s size too big");
-    for (; n > 0; --n, ++first)
-      insert_multi(end(), *first);
+    bulk_insert(first, last, false, false, iterator_category(first));
+  }
+  // 区间已按键值非递减排列
+  template <class InputIterator>
+  void      insert_multi(mystl::sorted_equivalent_tag, InputIterator first, InputIterator last)
+  {
+    bulk_insert(first, last, false, true, iterator_category(first));
   }
 
   mystl::pair<iterator, bool> insert_unique(const value_type& value);
@@ -866,10 +1061,13 @@ public:
   template <class InputIterator>
   void      insert_unique(InputIterator first, InputIterator last)
   {
-    size_type n = mystl::distance(first, last);
-    THROW_LENGTH_ERROR_IF(node_count_ > max_size() - n, "rb_tree<T, Comp>'s size too big");
-    for (; n > 0; --n, ++first)
-      insert_unique(end(), *first);
+    bulk_insert(first, last, true, false, iterator_category(first));
+  }
+  // 区间已按键值严格递增排列
+  template <class InputIterator>
+  void      insert_unique(mystl::sorted_unique_tag, InputIterator first, InputIterator last)
+  {
+    bulk_insert(first, last, true, true, iterator_category(first));
   }
 
   // erase
@@ -883,6 +1081,22 @@ public:
 
   void      clear();
 
+  // 节点的摘取与接合，只改变节点的链接关系，不分配或销毁节点
+
+  node_ptr  extract_node(iterator pos);
+
+  mystl::pair<iterator, bool> reinsert_node_unique(node_ptr np);
+  iterator  reinsert_node_multi(node_ptr np);
+
+  template <class Compare2>
+  void      merge_unique(rb_tree<T, Compare2>& source);
+  template <class Compare2>
+  void      merge_multi(rb_tree<T, Compare2>& source);
+
+  // 比较方式相同时，以线性时间归并两棵 rb tree
+  void      merge_unique(rb_tree& source);
+  void      merge_multi(rb_tree& source);
+
   // rb_tree 相关操作
 
   iterator       find(const key_type& key);
@@ -930,6 +1144,23 @@ public:
     return it == end() ? mystl::make_pair(it, it) : mystl::make_pair(it, ++next);
   }
 
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计相关操作
+
+  // 返回中序第 k 个（从 0 开始）元素，k 不小于 size() 时返回 end()
+  iterator       nth(size_type k)
+  { return iterator(nth_node(k)); }
+  const_iterator nth(size_type k) const
+  { return const_iterator(nth_node(k)); }
+
+  // 返回键值小于 key 的元素个数，即 lower_bound(key) 的位置
+  size_type      rank(const key_type& key) const;
+
+  // 返回迭代器在中序中的位置，end() 的位置为 size()
+  size_type      index_of(const_iterator it) const
+  { return rb_tree_index(it.node); }
+#endif
+
   void swap(rb_tree& rhs) noexcept;
 
 private:
@@ -943,6 +1174,9 @@ private:
   // init / reset
   void     rb_tree_init();
   void     reset();
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  base_ptr nth_node(size_type k) const;
+#endif
 
   // get insert pos
   mystl::pair<base_ptr, bool> 
@@ -950,6 +1184,20 @@ private:
   mystl::pair<mystl::pair<base_ptr, bool>, bool> 
            get_insert_unique_pos(const key_type& key);
 
+  // emplace unique
+  template <class ...Args>
+  mystl::pair<iterator, bool> emplace_unique_key(mystl::m_true_type, Args&& ...args);
+  template <class ...Args>
+  mystl::pair<iterator, bool> emplace_unique_key(mystl::m_false_type, Args&& ...args);
+
+  // 从 emplace 的参数中取得键值
+  template <class Arg>
+  static const key_type& extract_key(const Arg& arg)
+  { return value_traits::get_key(arg); }
+  template <class Arg1, class Arg2>
+  static const key_type& extract_key(const Arg1& key, const Arg2&)
+  { return key; }
+
   // insert value / insert node
   iterator insert_value_at(base_ptr x, const value_type& value, bool add_to_left);
   iterator insert_node_at(base_ptr x, node_ptr node, bool add_to_left);
@@ -961,6 +1209,44 @@ private:
   // copy tree / erase tree
   base_ptr copy_from(base_ptr x, base_ptr p);
   void     erase_since(base_ptr x);
+
+  // bulk insert / bulk build
+  typedef mystl::vector<base_ptr> base_ptr_vector;
+
+  template <class InputIter>
+  void      bulk_insert(InputIter first, InputIter last, bool unique, bool sorted,
+                        mystl::input_iterator_tag);
+  template <class ForwardIter>
+  void      bulk_insert(ForwardIter first, ForwardIter last, bool unique, bool sorted,
+                        mystl::forward_iterator_tag);
+
+  bool      node_less(base_ptr x, base_ptr y) const
+  {
+    return key_comp_(value_traits::get_key(x->get_node_ptr()->value),
+                     value_traits::get_key(y->get_node_ptr()->value));
+  }
+  void      sort_nodes(base_ptr* first, base_ptr* last, base_ptr* buf) const;
+  size_type unique_nodes(base_ptr* first, size_type n) const;
+  void      destroy_nodes(base_ptr* first, size_type n);
+  size_type bulk_merge(base_ptr_vector& nodes, base_ptr_vector& buffer, bool unique);
+  void      build_from_sorted(base_ptr* first, size_type n);
+  static base_ptr build_subtree(base_ptr* first, size_type n, base_ptr parent,
+                                size_type depth, size_type red_depth);
+
+  template <class ForwardIter>
+  bool      is_sorted_range(ForwardIter first, ForwardIter last, bool unique) const;
+  template <class ForwardIter>
+  void      build_from_range(ForwardIter first, size_type n);
+  template <class ForwardIter>
+  base_ptr  build_subtree_from(ForwardIter& first, size_type n, base_ptr parent,
+                               size_type depth, size_type red_depth);
+  static size_type red_depth_of(size_type n)
+  { // 完全平衡时最深一层的深度
+    size_type depth = 1;
+    while ((static_cast<size_type>(1) << (depth + 1)) - 1 <= n)
+      ++depth;
+    return depth;
+  }
 };
 
 /*****************************************************************************************/
@@ -973,7 +1259,7 @@ rb_tree(const rb_tree& rhs)
   rb_tree_init();
   if (rhs.node_count_ != 0)
   {
-    root() = copy_from(rhs.root(), header_);
+    set_root(copy_from(rhs.root(), header_));
     leftmost() = rb_tree_min(root());
     rightmost() = rb_tree_max(root());
   }
@@ -1004,7 +1290,7 @@ operator=(const rb_tree& rhs)
 
     if (rhs.node_count_ != 0)
     {
-      root() = copy_from(rhs.root(), header_);
+      set_root(copy_from(rhs.root(), header_));
       leftmost() = rb_tree_min(root());
       rightmost() = rb_tree_max(root());
     }
@@ -1022,6 +1308,7 @@ rb_tree<T, Compare>::
 operator=(rb_tree&& rhs)
 {
   clear();
+  base_allocator::deallocate(header_);
   header_ = mystl::move(rhs.header_);
   node_count_ = rhs.node_count_;
   key_comp_ = rhs.key_comp_;
@@ -1043,6 +1330,7 @@ emplace_multi(Args&& ...args)
 }
 
 // 就地插入元素，键值不允许重复
+// 能够直接从参数中取得键值时，先查找插入位置，键值已经存在时不会构造节点
 template <class T, class Compare>
 template <class ...Args>
 mystl::pair<typename rb_tree<T, Compare>::iterator, bool> 
@@ -1050,6 +1338,30 @@ rb_tree<T, Compare>::
 emplace_unique(Args&& ...args)
 {
   THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
+  return emplace_unique_key(mystl::can_extract_key<key_type, value_type, Args...>{},
+                            mystl::forward<Args>(args)...);
+}
+
+// emplace_unique_key 函数
+template <class T, class Compare>
+template <class ...Args>
+mystl::pair<typename rb_tree<T, Compare>::iterator, bool> 
+rb_tree<T, Compare>::
+emplace_unique_key(mystl::m_true_type, Args&& ...args)
+{
+  auto res = get_insert_unique_pos(extract_key(args...));
+  if (!res.second)
+    return mystl::make_pair(iterator(res.first.first), false);
+  node_ptr np = create_node(mystl::forward<Args>(args)...);
+  return mystl::make_pair(insert_node_at(res.first.first, np, res.first.second), true);
+}
+
+template <class T, class Compare>
+template <class ...Args>
+mystl::pair<typename rb_tree<T, Compare>::iterator, bool> 
+rb_tree<T, Compare>::
+emplace_unique_key(mystl::m_false_type, Args&& ...args)
+{
   node_ptr np = create_node(mystl::forward<Args>(args)...);
   auto res = get_insert_unique_pos(value_traits::get_key(np->value));
   if (res.second)
@@ -1188,7 +1500,9 @@ erase(iterator hint)
   iterator next(node);
   ++next;
   
-  rb_tree_erase_rebalance(hint.node, root(), leftmost(), rightmost());
+  auto r = root();
+  rb_tree_erase_rebalance(hint.node, r, leftmost(), rightmost());
+  set_root(r);
   destroy_node(node);
   --node_count_;
   return next;
@@ -1246,12 +1560,97 @@ clear()
   {
     erase_since(root());
     leftmost() = header_;
-    root() = nullptr;
+    set_root(nullptr);
     rightmost() = header_;
     node_count_ = 0;
   }
 }
 
+// 摘取 pos 所指的节点，节点脱离 rb tree 但不会被销毁
+template <class T, class Compare>
+typename rb_tree<T, Compare>::node_ptr
+rb_tree<T, Compare>::
+extract_node(iterator pos)
+{
+  auto node = pos.node->get_node_ptr();
+  auto r = root();
+  rb_tree_erase_rebalance(pos.node, r, leftmost(), rightmost());
+  set_root(r);
+  --node_count_;
+  rb_tree_set_parent(node, nullptr);
+  node->left = nullptr;
+  node->right = nullptr;
+  return node;
+}
+
+// 接合一个已经存在的节点，键值不允许重复，插入失败时不改变该节点，
+// 返回的迭代器指向插入的节点或者与之键值相等的节点
+template <class T, class Compare>
+mystl::pair<typename rb_tree<T, Compare>::iterator, bool>
+rb_tree<T, Compare>::
+reinsert_node_unique(node_ptr np)
+{
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
+  auto res = get_insert_unique_pos(value_traits::get_key(np->value));
+  if (res.second)
+  { // 插入成功
+    return mystl::make_pair(insert_node_at(res.first.first, np, res.first.second), true);
+  }
+  return mystl::make_pair(iterator(res.first.first), false);
+}
+
+// 接合一个已经存在的节点，键值允许重复
+template <class T, class Compare>
+typename rb_tree<T, Compare>::iterator
+rb_tree<T, Compare>::
+reinsert_node_multi(node_ptr np)
+{
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - 1, "rb_tree<T, Comp>'s size too big");
+  auto res = get_insert_multi_pos(value_traits::get_key(np->value));
+  return insert_node_at(res.first, np, res.second);
+}
+
+// 把 source 中的节点转移过来，键值不允许重复，与已有元素键值重复的节点留在 source 中
+template <class T, class Compare>
+template <class Compare2>
+void rb_tree<T, Compare>::
+merge_unique(rb_tree<T, Compare2>& source)
+{
+  if (static_cast<void*>(this) == static_cast<void*>(&source))
+    return;
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - source.node_count_,
+                        "rb_tree<T, Comp>'s size too big");
+  auto first = source.begin();
+  auto last = source.end();
+  while (first != last)
+  {
+    auto cur = first++;
+    auto res = get_insert_unique_pos(value_traits::get_key(*cur));
+    if (res.second)
+      insert_node_at(res.first.first, source.extract_node(cur), res.first.second);
+  }
+}
+
+// 把 source 中的节点全部转移过来，键值允许重复
+template <class T, class Compare>
+template <class Compare2>
+void rb_tree<T, Compare>::
+merge_multi(rb_tree<T, Compare2>& source)
+{
+  if (static_cast<void*>(this) == static_cast<void*>(&source))
+    return;
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - source.node_count_,
+                        "rb_tree<T, Comp>'s size too big");
+  auto first = source.begin();
+  auto last = source.end();
+  while (first != last)
+  {
+    auto cur = first++;
+    auto res = get_insert_multi_pos(value_traits::get_key(*cur));
+    insert_node_at(res.first, source.extract_node(cur), res.second);
+  }
+}
+
 // 查找键值为 k 的节点，返回指向它的迭代器
 template <class T, class Compare>
 typename rb_tree<T, Compare>::iterator
@@ -1383,6 +1782,59 @@ upper_bound(const key_type& key) const
   return const_iterator(y);
 }
 
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+// nth_node 函数
+template <class T, class Compare>
+typename rb_tree<T, Compare>::base_ptr
+rb_tree<T, Compare>::
+nth_node(size_type k) const
+{
+  if (k >= node_count_)
+    return header_;
+  auto x = root();
+  while (true)
+  {
+    const size_type left_size = rb_tree_subtree_size(x->left);
+    if (k < left_size)
+    {
+      x = x->left;
+    }
+    else if (k == left_size)
+    {
+      return x;
+    }
+    else
+    {
+      k -= left_size + 1;
+      x = x->right;
+    }
+  }
+}
+
+// rank 函数
+template <class T, class Compare>
+typename rb_tree<T, Compare>::size_type
+rb_tree<T, Compare>::
+rank(const key_type& key) const
+{
+  size_type result = 0;
+  auto x = root();
+  while (x != nullptr)
+  {
+    if (key_comp_(value_traits::get_key(x->get_node_ptr()->value), key))
+    { // x 以及它的左子树都小于 key
+      result += rb_tree_subtree_size(x->left) + 1;
+      x = x->right;
+    }
+    else
+    {
+      x = x->left;
+    }
+  }
+  return result;
+}
+#endif
+
 // 交换 rb tree
 template <class T, class Compare>
 void rb_tree<T, Compare>::
@@ -1412,7 +1864,7 @@ create_node(Args&&... args)
     data_allocator::construct(mystl::address_of(tmp->value), mystl::forward<Args>(args)...);
     tmp->left = nullptr;
     tmp->right = nullptr;
-    tmp->parent = nullptr;
+    rb_tree_init_parent_color(tmp, nullptr, rb_tree_red);
   }
   catch (...)
   {
@@ -1429,7 +1881,8 @@ rb_tree<T, Compare>::
 clone_node(base_ptr x)
 {
   node_ptr tmp = create_node(x->get_node_ptr()->value);
-  tmp->color = x->color;
+  rb_tree_set_color(tmp, rb_tree_color(x));
+  rb_tree_set_size(tmp, rb_tree_subtree_size(x));
   tmp->left = nullptr;
   tmp->right = nullptr;
   return tmp;
@@ -1450,8 +1903,7 @@ void rb_tree<T, Compare>::
 rb_tree_init()
 {
   header_ = base_allocator::allocate(1);
-  header_->color = rb_tree_red;  // header_ 节点颜色为红，与 root 区分
-  root() = nullptr;
+  rb_tree_init_parent_color(header_, nullptr, rb_tree_red);  // header_ 节点颜色为红，与 root 区分
   leftmost() = header_;
   rightmost() = header_;
   node_count_ = 0;
@@ -1513,8 +1965,8 @@ rb_tree<T, Compare>::get_insert_unique_pos(const key_type& key)
   { // 表明新节点没有重复
     return mystl::make_pair(mystl::make_pair(y, add_to_left), true);
   }
-  // 进行至此，表示新节点与现有节点键值重复
-  return mystl::make_pair(mystl::make_pair(y, add_to_left), false);
+  // 进行至此，表示新节点与现有节点键值重复，返回键值重复的节点
+  return mystl::make_pair(mystl::make_pair(j.node, add_to_left), false);
 }
 
 // insert_value_at 函数
@@ -1525,11 +1977,11 @@ rb_tree<T, Compare>::
 insert_value_at(base_ptr x, const value_type& value, bool add_to_left)
 {
   node_ptr node = create_node(value);
-  node->parent = x;
+  rb_tree_set_parent(node, x);
   auto base_node = node->get_base_ptr();
   if (x == header_)
   {
-    root() = base_node;
+    set_root(base_node);
     leftmost() = base_node;
     rightmost() = base_node;
   }
@@ -1545,7 +1997,9 @@ insert_value_at(base_ptr x, const value_type& value, bool add_to_left)
     if (rightmost() == x)
       rightmost() = base_node;
   }
-  rb_tree_insert_rebalance(base_node, root());
+  auto r = root();
+  rb_tree_insert_rebalance(base_node, r);
+  set_root(r);
   ++node_count_;
   return iterator(node);
 }
@@ -1557,11 +2011,11 @@ typename rb_tree<T, Compare>::iterator
 rb_tree<T, Compare>::
 insert_node_at(base_ptr x, node_ptr node, bool add_to_left)
 {
-  node->parent = x;
+  rb_tree_set_parent(node, x);
   auto base_node = node->get_base_ptr();
   if (x == header_)
   {
-    root() = base_node;
+    set_root(base_node);
     leftmost() = base_node;
     rightmost() = base_node;
   }
@@ -1577,7 +2031,9 @@ insert_node_at(base_ptr x, node_ptr node, bool add_to_left)
     if (rightmost() == x)
       rightmost() = base_node;
   }
-  rb_tree_insert_rebalance(base_node, root());
+  auto r = root();
+  rb_tree_insert_rebalance(base_node, r);
+  set_root(r);
   ++node_count_;
   return iterator(node);
 }
@@ -1648,7 +2104,7 @@ typename rb_tree<T, Compare>::base_ptr
 rb_tree<T, Compare>::copy_from(base_ptr x, base_ptr p)
 {
   auto top = clone_node(x);
-  top->parent = p;
+  rb_tree_set_parent(top, p);
   try
   {
     if (x->right)
@@ -1659,7 +2115,7 @@ rb_tree<T, Compare>::copy_from(base_ptr x, base_ptr p)
     {
       auto y = clone_node(x);
       p->left = y;
-      y->parent = p;
+      rb_tree_set_parent(y, p);
       if (x->right)
         y->right = copy_from(x->right, y);
       p = y;
@@ -1689,6 +2145,372 @@ erase_since(base_ptr x)
   }
 }
 
+// bulk_insert 函数
+// 输入迭代器只能遍历一次，逐个插入
+template <class T, class Compare>
+template <class InputIter>
+void rb_tree<T, Compare>::
+bulk_insert(InputIter first, InputIter last, bool unique, bool, mystl::input_iterator_tag)
+{
+  for (; first != last; ++first)
+  {
+    if (unique)
+      emplace_unique_use_hint(end(), *first);
+    else
+      emplace_multi_use_hint(end(), *first);
+  }
+}
+
+// 区间较小时逐个插入，否则先构造所有节点并排序，再与已有节点归并后重建整棵树
+// 逐个插入时为基本异常安全保证；其余情况下节点的构造和所有比较都在修改树之前完成，
+// 构造或比较抛出异常时销毁所有新节点，树保持不变，为强异常安全保证
+template <class T, class Compare>
+template <class ForwardIter>
+void rb_tree<T, Compare>::
+bulk_insert(ForwardIter first, ForwardIter last, bool unique, bool sorted,
+            mystl::forward_iterator_tag)
+{
+  const size_type n = mystl::distance(first, last);
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - n, "rb_tree<T, Comp>'s size too big");
+  if (n == 0)
+    return;
+  if (n < (node_count_ >> 3))
+  { // 相对于已有元素很少，逐个插入的代价更低
+    bulk_insert(first, last, unique, sorted, mystl::input_iterator_tag());
+    return;
+  }
+  if (node_count_ == 0 && (sorted || is_sorted_range(first, last, unique)))
+  { // 空树且区间有序，按中序直接构造节点并建树
+    build_from_range(first, n);
+    return;
+  }
+  base_ptr_vector nodes;
+  base_ptr_vector buffer;
+  nodes.reserve(n);
+  if (node_count_ != 0)
+    buffer.reserve(node_count_ + n);
+  else if (!sorted)
+    buffer.reserve(n / 2 + 1);
+  try
+  {
+    for (; first != last; ++first)
+      nodes.push_back(create_node(*first));
+    if (!sorted)
+    {
+      buffer.resize(n / 2 + 1);
+      sort_nodes(nodes.begin(), nodes.end(), buffer.begin());
+    }
+    MYSTL_DEBUG(mystl::is_sorted(nodes.begin(), nodes.end(),
+                                 [this](base_ptr x, base_ptr y) { return node_less(x, y); }));
+    if (unique)
+    { // 重复的节点被换到尾部，比较函数抛出异常时 nodes 中仍是全部新节点
+      const size_type kept = unique_nodes(nodes.begin(), nodes.size());
+      destroy_nodes(nodes.begin() + kept, nodes.size() - kept);
+      nodes.erase(nodes.begin() + kept, nodes.end());
+    }
+    if (node_count_ == 0)
+    {
+      build_from_sorted(nodes.begin(), nodes.size());
+      return;
+    }
+    // bulk_merge 在所有比较完成之后才修改树，比较函数抛出异常时树保持不变
+    const size_type rejected = bulk_merge(nodes, buffer, unique);
+    destroy_nodes(nodes.begin(), rejected);
+  }
+  catch (...)
+  {
+    destroy_nodes(nodes.begin(), nodes.size());
+    throw;
+  }
+}
+
+// 比较方式相同时，把 source 中的节点转移过来，键值不允许重复
+// source 较大时，两棵树中的节点都已有序，归并后以线性时间重建，与已有元素键值重复的节点留在 source 中
+template <class T, class Compare>
+void rb_tree<T, Compare>::
+merge_unique(rb_tree& source)
+{
+  if (this == &source || source.node_count_ == 0)
+    return;
+  if (source.node_count_ < (node_count_ >> 3))
+  {
+    merge_unique<Compare>(source);
+    return;
+  }
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - source.node_count_,
+                        "rb_tree<T, Comp>'s size too big");
+  base_ptr_vector nodes;
+  base_ptr_vector buffer;
+  nodes.reserve(source.node_count_);
+  buffer.reserve(node_count_ + source.node_count_);
+  for (auto it = source.begin(); it != source.end(); ++it)
+    nodes.push_back(it.node);
+  const size_type rejected = bulk_merge(nodes, buffer, true);
+  source.build_from_sorted(nodes.begin(), rejected);
+}
+
+// 比较方式相同时，把 source 中的节点全部转移过来，键值允许重复
+template <class T, class Compare>
+void rb_tree<T, Compare>::
+merge_multi(rb_tree& source)
+{
+  if (this == &source || source.node_count_ == 0)
+    return;
+  if (source.node_count_ < (node_count_ >> 3))
+  {
+    merge_multi<Compare>(source);
+    return;
+  }
+  THROW_LENGTH_ERROR_IF(node_count_ > max_size() - source.node_count_,
+                        "rb_tree<T, Comp>'s size too big");
+  base_ptr_vector nodes;
+  base_ptr_vector buffer;
+  nodes.reserve(source.node_count_);
+  buffer.reserve(node_count_ + source.node_count_);
+  for (auto it = source.begin(); it != source.end(); ++it)
+    nodes.push_back(it.node);
+  bulk_merge(nodes, buffer, false);
+  source.build_from_sorted(nullptr, 0);
+}
+
+// sort_nodes 函数
+// 按键值对节点进行稳定的归并排序，buf 至少能容纳一半的节点
+// 相邻的两段已经有序时跳过合并，输入本身有序时只需要线性次比较
+// 比较函数抛出异常时，[first, last) 中仍是原来的全部节点（顺序未定），调用者可以据此销毁它们
+template <class T, class Compare>
+void rb_tree<T, Compare>::
+sort_nodes(base_ptr* first, base_ptr* last, base_ptr* buf) const
+{
+  const size_type n = static_cast<size_type>(last - first);
+  if (n <= 16)
+  { // 插入排序
+    for (auto i = first + 1; i < last; ++i)
+    {
+      auto value = *i;
+      auto j = i;
+      try
+      {
+        for (; j != first && node_less(value, *(j - 1)); --j)
+          *j = *(j - 1);
+      }
+      catch (...)
+      {
+        *j = value;
+        throw;
+      }
+      *j = value;
+    }
+    return;
+  }
+  auto mid = first + n / 2;
+  sort_nodes(first, mid, buf);
+  sort_nodes(mid, last, buf);
+  if (!node_less(*mid, *(mid - 1)))
+    return;
+  // 把前半段移到 buf 中，再合并回原区间
+  auto buf_last = mystl::copy(first, mid, buf);
+  auto b = buf;
+  auto cur = first;
+  try
+  {
+    while (b != buf_last && mid != last)
+    {
+      if (node_less(*mid, *b))
+        *cur++ = *mid++;
+      else
+        *cur++ = *b++;
+    }
+  }
+  catch (...)
+  { // [cur, mid) 恰好是 buf 中尚未写回的节点的位置
+    mystl::copy(b, buf_last, cur);
+    throw;
+  }
+  mystl::copy(b, buf_last, cur);
+}
+
+// unique_nodes 函数
+// 对有序的节点去重，每组键值相等的节点只保留第一个，保留的节点按序移到前部，返回其个数
+// 重复的节点被交换到尾部而不是销毁，任何时候 [first, first + n) 中都是原来的全部节点
+template <class T, class Compare>
+typename rb_tree<T, Compare>::size_type
+rb_tree<T, Compare>::
+unique_nodes(base_ptr* first, size_type n) const
+{
+  if (n == 0)
+    return 0;
+  size_type result = 1;
+  for (size_type i = 1; i < n; ++i)
+  {
+    if (node_less(first[result - 1], first[i]))
+      mystl::swap(first[result++], first[i]);
+  }
+  return result;
+}
+
+// destroy_nodes 函数
+template <class T, class Compare>
+void rb_tree<T, Compare>::
+destroy_nodes(base_ptr* first, size_type n)
+{
+  for (size_type i = 0; i < n; ++i)
+    destroy_node(first[i]->get_node_ptr());
+}
+
+// bulk_merge 函数
+// 把有序的 nodes 与已有节点按序归并到 buffer 中，再以 buffer 重建整棵树
+// unique 为 true 时，与已有元素键值重复的节点不会被接合，它们按序移到 nodes 的前部，返回其个数
+// buffer 需要预先分配足够的空间，此函数不会抛出异常（比较函数抛出的异常除外）
+// 所有比较都在重建之前完成，nodes 中始终是原来的全部节点，比较函数抛出异常时树和 nodes 都保持有效
+template <class T, class Compare>
+typename rb_tree<T, Compare>::size_type
+rb_tree<T, Compare>::
+bulk_merge(base_ptr_vector& nodes, base_ptr_vector& buffer, bool unique)
+{
+  MYSTL_DEBUG(buffer.capacity() >= node_count_ + nodes.size());
+  buffer.clear();
+  size_type rejected = 0;
+  size_type i = 0;
+  const size_type n = nodes.size();
+  auto it = begin();
+  const auto last = end();
+  while (it != last && i < n)
+  {
+    if (node_less(nodes[i], it.node))
+    {
+      buffer.push_back(nodes[i++]);
+    }
+    else if (unique && !node_less(it.node, nodes[i]))
+    { // 键值重复，与前面已归并的节点交换位置
+      mystl::swap(nodes[rejected++], nodes[i++]);
+    }
+    else
+    { // 键值相等时，已有元素排在前面
+      buffer.push_back(it.node);
+      ++it;
+    }
+  }
+  for (; it != last; ++it)
+    buffer.push_back(it.node);
+  for (; i < n; ++i)
+    buffer.push_back(nodes[i]);
+  build_from_sorted(buffer.begin(), buffer.size());
+  return rejected;
+}
+
+// build_from_sorted 函数
+// 以有序的 n 个节点构造一棵平衡的 rb tree，不需要任何旋转
+// 除最深的一层外每层都是满的，最深一层的节点为红色，其余为黑色，每条路径的黑色节点数相同
+template <class T, class Compare>
+void rb_tree<T, Compare>::
+build_from_sorted(base_ptr* first, size_type n)
+{
+  if (n == 0)
+  {
+    set_root(nullptr);
+    leftmost() = header_;
+    rightmost() = header_;
+    node_count_ = 0;
+    return;
+  }
+  set_root(build_subtree(first, n, header_, 0, red_depth_of(n)));
+  leftmost() = first[0];
+  rightmost() = first[n - 1];
+  node_count_ = n;
+}
+
+// build_subtree 函数
+// 以中间的节点为根，递归构造左右子树，返回子树的根
+template <class T, class Compare>
+typename rb_tree<T, Compare>::base_ptr
+rb_tree<T, Compare>::
+build_subtree(base_ptr* first, size_type n, base_ptr parent,
+              size_type depth, size_type red_depth)
+{
+  if (n == 0)
+    return nullptr;
+  const size_type mid = n / 2;
+  base_ptr x = first[mid];
+  rb_tree_set_parent(x, parent);
+  rb_tree_set_color(x, depth == red_depth ? rb_tree_red : rb_tree_black);
+  x->left = build_subtree(first, mid, x, depth + 1, red_depth);
+  x->right = build_subtree(first + mid + 1, n - mid - 1, x, depth + 1, red_depth);
+  rb_tree_set_size(x, n);
+  return x;
+}
+
+// is_sorted_range 函数
+// 检查区间是否已按键值排序，unique 为 true 时要求严格递增
+template <class T, class Compare>
+template <class ForwardIter>
+bool rb_tree<T, Compare>::
+is_sorted_range(ForwardIter first, ForwardIter last, bool unique) const
+{
+  if (first == last)
+    return true;
+  auto next = first;
+  for (++next; next != last; ++first, ++next)
+  {
+    const auto& prev_key = value_traits::get_key(*first);
+    const auto& key = value_traits::get_key(*next);
+    if (unique ? !key_comp_(prev_key, key) : key_comp_(key, prev_key))
+      return false;
+  }
+  return true;
+}
+
+// build_from_range 函数
+// 以有序区间中的 n 个元素构造一棵平衡的空 rb tree，节点按中序依次构造，不需要额外的空间
+// 强异常安全保证
+template <class T, class Compare>
+template <class ForwardIter>
+void rb_tree<T, Compare>::
+build_from_range(ForwardIter first, size_type n)
+{
+  MYSTL_DEBUG(node_count_ == 0);
+  set_root(build_subtree_from(first, n, header_, 0, red_depth_of(n)));
+  leftmost() = rb_tree_min(root());
+  rightmost() = rb_tree_max(root());
+  node_count_ = n;
+}
+
+// build_subtree_from 函数
+// 与 build_subtree 相同，但节点在构造左子树之后才被创建，创建失败时销毁已经构造的部分
+template <class T, class Compare>
+template <class ForwardIter>
+typename rb_tree<T, Compare>::base_ptr
+rb_tree<T, Compare>::
+build_subtree_from(ForwardIter& first, size_type n, base_ptr parent,
+                   size_type depth, size_type red_depth)
+{
+  if (n == 0)
+    return nullptr;
+  const size_type mid = n / 2;
+  base_ptr left = build_subtree_from(first, mid, nullptr, depth + 1, red_depth);
+  base_ptr x = nullptr;
+  try
+  {
+    x = create_node(*first);
+    ++first;
+    x->left = left;
+    x->right = nullptr;
+    if (left != nullptr)
+      rb_tree_set_parent(left, x);
+    x->right = build_subtree_from(first, n - mid - 1, x, depth + 1, red_depth);
+  }
+  catch (...)
+  {
+    erase_since(left);
+    if (x != nullptr)
+      destroy_node(x->get_node_ptr());
+    throw;
+  }
+  rb_tree_set_parent(x, parent);
+  rb_tree_set_color(x, depth == red_depth ? rb_tree_red : rb_tree_black);
+  rb_tree_set_size(x, n);
+  return x;
+}
+
 // 重载比较操作符
 template <class T, class Compare>
 bool operator==(const rb_tree<T, Compare>& lhs, const rb_tree<T, Compare>& rhs)
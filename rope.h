@@ -0,0 +1,1096 @@
+﻿#ifndef MYTINYSTL_ROPE_H_
+#define MYTINYSTL_ROPE_H_
+
+// 这个头文件包含一个模板类 rope
+// rope : 由共享的不可变字符串块组成的平衡树，适合频繁拼接的大段文本
+
+// notes:
+//
+// rope 的每个叶节点保存一段字符，内部节点表示左右两棵子树的拼接，整棵树满足 AVL 平衡条件：
+//   * 共享的节点不再修改，多个 rope 之间通过引用计数共享节点，复制 rope 是 O(1)
+//   * 从根到最右叶节点都不被共享时，追加短字符串直接写入最右的叶节点
+//   * 拼接、substr、insert、erase 都只新建 O(log n) 个节点，不复制字符
+//   * 相邻的两个短叶节点在拼接时合并成一个，逐个追加小片段不会产生大量很小的叶节点
+//   * 以右值 basic_string 构造或追加时直接接管它的空间，不复制字符
+//   * 按下标访问是 O(log n)，迭代器缓存当前叶节点，顺序遍历均摊 O(1)
+//   * chunk_begin / chunk_end 与 for_each_chunk 按顺序给出每个叶节点的字符，输出时不需要先展开
+//   * str() 展开成一个 basic_string
+//
+// 引用计数是原子的，不同线程可以同时读取或复制共享节点的 rope，但同一个 rope 对象的修改需要外部同步
+
+#include <atomic>
+#include <iostream>
+#include <type_traits>
+
+#include "basic_string.h"
+#include "vector.h"
+#include "iterator.h"
+#include "memory.h"
+#include "util.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// 相邻两个叶节点的总长不超过 rope_short_leaf 时，拼接时合并为一个叶节点
+static constexpr size_t rope_short_leaf = 128;
+
+// rope 的节点设计
+// height 为 0 的是叶节点：
+//   * 拥有字符的叶节点在 storage 中保存一个 basic_string，data 指向它的字符
+//   * 子串叶节点不拥有字符，left 指向拥有字符的叶节点，data 指向其中的一段
+// height 大于 0 的是拼接节点，left 与 right 为两棵子树
+
+template <class CharType, class CharTraits>
+struct rope_rep
+{
+  typedef basic_string<CharType, CharTraits> string_type;
+  typedef typename std::aligned_storage<sizeof(string_type), alignof(string_type)>::type storage_type;
+  typedef std::atomic<size_t> count_type;
+
+  count_type          refs;    // 引用计数
+  size_t              size;    // 字符个数
+  unsigned            height;  // 叶节点为 0
+  bool                owner;   // 叶节点是否拥有 storage 中的字符串
+  rope_rep*           left;
+  rope_rep*           right;
+  const CharType*     data;
+  storage_type        storage;
+
+  bool         is_leaf() const noexcept { return height == 0; }
+  string_type* str() noexcept { return reinterpret_cast<string_type*>(&storage); }
+};
+
+template <class CharType, class CharTraits> class rope;
+
+// rope 的迭代器设计
+// 随机访问迭代器，保存当前位置并缓存该位置所在的叶节点，离开缓存的叶节点时从根重新查找
+
+template <class CharType, class CharTraits>
+struct rope_const_iterator
+  : public mystl::iterator<mystl::random_access_iterator_tag, CharType>
+{
+  typedef CharType                                   value_type;
+  typedef const CharType*                            pointer;
+  typedef const CharType&                            reference;
+  typedef ptrdiff_t                                  difference_type;
+  typedef rope_rep<CharType, CharTraits>             rep_type;
+  typedef rope_const_iterator<CharType, CharTraits>  self;
+
+  const rep_type*         root;        // 所在 rope 的根节点
+  size_t                  pos;         // 当前位置
+  mutable const CharType* leaf_data;   // 缓存的叶节点的字符
+  mutable size_t          leaf_begin;  // 缓存的叶节点在 rope 中的范围 [leaf_begin, leaf_end)
+  mutable size_t          leaf_end;
+
+  rope_const_iterator()
+    :root(nullptr), pos(0), leaf_data(nullptr), leaf_begin(0), leaf_end(0) {}
+  rope_const_iterator(const rep_type* r, size_t p)
+    :root(r), pos(p), leaf_data(nullptr), leaf_begin(0), leaf_end(0) {}
+
+  reference operator*() const
+  {
+    if (pos < leaf_begin || pos >= leaf_end)
+      locate();
+    return leaf_data[pos - leaf_begin];
+  }
+  pointer   operator->() const { return &(operator*()); }
+  reference operator[](difference_type n) const { return *(*this + n); }
+
+  self& operator++()    { ++pos; return *this; }
+  self  operator++(int) { self tmp = *this; ++pos; return tmp; }
+  self& operator--()    { --pos; return *this; }
+  self  operator--(int) { self tmp = *this; --pos; return tmp; }
+
+  self& operator+=(difference_type n) { pos += n; return *this; }
+  self& operator-=(difference_type n) { pos -= n; return *this; }
+  self  operator+(difference_type n) const { self tmp = *this; return tmp += n; }
+  self  operator-(difference_type n) const { self tmp = *this; return tmp -= n; }
+  difference_type operator-(const self& rhs) const
+  { return static_cast<difference_type>(pos) - static_cast<difference_type>(rhs.pos); }
+
+  bool operator==(const self& rhs) const { return pos == rhs.pos; }
+  bool operator!=(const self& rhs) const { return pos != rhs.pos; }
+  bool operator< (const self& rhs) const { return pos <  rhs.pos; }
+  bool operator> (const self& rhs) const { return pos >  rhs.pos; }
+  bool operator<=(const self& rhs) const { return pos <= rhs.pos; }
+  bool operator>=(const self& rhs) const { return pos >= rhs.pos; }
+
+  // 从根节点找到 pos 所在的叶节点
+  void locate() const
+  {
+    MYSTL_DEBUG(root != nullptr && pos < root->size);
+    const rep_type* t = root;
+    size_t base = 0;
+    while (!t->is_leaf())
+    {
+      if (pos - base < t->left->size)
+      {
+        t = t->left;
+      }
+      else
+      {
+        base += t->left->size;
+        t = t->right;
+      }
+    }
+    leaf_data = t->data;
+    leaf_begin = base;
+    leaf_end = base + t->size;
+  }
+};
+
+// 按顺序访问 rope 的每个叶节点，*it 为该叶节点的字符指针与长度
+template <class CharType, class CharTraits>
+struct rope_chunk_iterator
+  : public mystl::iterator<mystl::forward_iterator_tag, mystl::pair<const CharType*, size_t>>
+{
+  typedef mystl::pair<const CharType*, size_t>       value_type;
+  typedef rope_rep<CharType, CharTraits>             rep_type;
+  typedef rope_chunk_iterator<CharType, CharTraits>  self;
+
+  mystl::vector<const rep_type*> stack;  // 从根到当前叶节点的路径上，还没有访问右子树的节点
+
+  rope_chunk_iterator() = default;
+  explicit rope_chunk_iterator(const rep_type* root)
+  {
+    if (root != nullptr)
+      descend(root);
+  }
+
+  value_type operator*() const
+  {
+    MYSTL_DEBUG(!stack.empty());
+    return value_type(stack.back()->data, stack.back()->size);
+  }
+
+  self& operator++()
+  {
+    MYSTL_DEBUG(!stack.empty());
+    stack.pop_back();
+    if (!stack.empty())
+    {
+      const rep_type* t = stack.back();
+      stack.pop_back();
+      descend(t->right);
+    }
+    return *this;
+  }
+  self operator++(int)
+  {
+    self tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  // 两个迭代器都到达末尾或经过同一条路径到达同一个叶节点时相等，同一个节点可能在 rope 中出现多次
+  bool operator==(const self& rhs) const
+  {
+    if (stack.empty() || rhs.stack.empty())
+      return stack.empty() && rhs.stack.empty();
+    if (stack.size() != rhs.stack.size())
+      return false;
+    for (size_t i = 0; i < stack.size(); ++i)
+    {
+      if (stack[i] != rhs.stack[i])
+        return false;
+    }
+    return true;
+  }
+  bool operator!=(const self& rhs) const { return !(*this == rhs); }
+
+  // 沿左子树走到最左边的叶节点
+  void descend(const rep_type* t)
+  {
+    for (; !t->is_leaf(); t = t->left)
+      stack.push_back(t);
+    stack.push_back(t);
+  }
+};
+
+// 模板类 rope
+// 参数一代表字符类型，参数二代表萃取字符类型的方式，缺省使用 mystl 的 char_traits
+template <class CharType, class CharTraits = mystl::char_traits<CharType>>
+class rope
+{
+public:
+  typedef CharTraits                                   traits_type;
+  typedef CharTraits                                   char_traits;
+  typedef basic_string<CharType, CharTraits>           string_type;
+
+  typedef CharType                                     value_type;
+  typedef const CharType*                              const_pointer;
+  typedef const CharType&                              const_reference;
+  typedef size_t                                       size_type;
+  typedef ptrdiff_t                                    difference_type;
+
+  typedef rope_const_iterator<CharType, CharTraits>    const_iterator;
+  typedef const_iterator                               iterator;
+  typedef mystl::reverse_iterator<const_iterator>      const_reverse_iterator;
+  typedef rope_chunk_iterator<CharType, CharTraits>    chunk_iterator;
+
+  typedef rope_rep<CharType, CharTraits>               rep_type;
+  typedef mystl::allocator<rep_type>                   rep_allocator;
+
+  static constexpr size_type npos = static_cast<size_type>(-1);
+
+private:
+  rep_type* root_;  // 根节点，空 rope 为 nullptr
+
+public:
+  // 构造、复制、移动、析构函数
+  rope() noexcept
+    :root_(nullptr)
+  {
+  }
+
+  rope(const CharType* s)
+    :root_(new_leaf(s, char_traits::length(s)))
+  {
+  }
+
+  rope(const CharType* s, size_type n)
+    :root_(new_leaf(s, n))
+  {
+  }
+
+  rope(size_type n, CharType ch)
+    :root_(nullptr)
+  {
+    if (n != 0)
+      root_ = new_leaf(string_type(n, ch));
+  }
+
+  rope(const string_type& s)
+    :root_(new_leaf(s.begin(), s.size()))
+  {
+  }
+
+  // 接管 s 的空间
+  rope(string_type&& s)
+    :root_(s.empty() ? nullptr : new_leaf(mystl::move(s)))
+  {
+  }
+
+  rope(const rope& rhs) noexcept
+    :root_(rhs.root_)
+  {
+    ref(root_);
+  }
+
+  rope(rope&& rhs) noexcept
+    :root_(rhs.root_)
+  {
+    rhs.root_ = nullptr;
+  }
+
+  rope& operator=(const rope& rhs) noexcept
+  {
+    ref(rhs.root_);
+    unref(root_);
+    root_ = rhs.root_;
+    return *this;
+  }
+
+  rope& operator=(rope&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      unref(root_);
+      root_ = rhs.root_;
+      rhs.root_ = nullptr;
+    }
+    return *this;
+  }
+
+  ~rope()
+  { unref(root_); }
+
+public:
+  // 迭代器相关操作
+  const_iterator         begin()   const noexcept
+  { return const_iterator(root_, 0); }
+  const_iterator         end()     const noexcept
+  { return const_iterator(root_, size()); }
+  const_reverse_iterator rbegin()  const noexcept
+  { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend()    const noexcept
+  { return const_reverse_iterator(begin()); }
+
+  const_iterator         cbegin()  const noexcept
+  { return begin(); }
+  const_iterator         cend()    const noexcept
+  { return end(); }
+
+  chunk_iterator         chunk_begin() const
+  { return chunk_iterator(root_); }
+  chunk_iterator         chunk_end()   const
+  { return chunk_iterator(); }
+
+  // 容量相关操作
+  bool      empty()    const noexcept { return root_ == nullptr; }
+  size_type size()     const noexcept { return root_ != nullptr ? root_->size : 0; }
+  size_type length()   const noexcept { return size(); }
+  size_type max_size() const noexcept { return static_cast<size_type>(-1); }
+
+  // 树的高度，空 rope 与只有一个叶节点的 rope 为 0
+  size_type height()   const noexcept { return root_ != nullptr ? root_->height : 0; }
+
+  // 访问元素相关操作，都是 O(log n)
+  const_reference operator[](size_type n) const
+  {
+    MYSTL_DEBUG(n < size());
+    return char_at(n);
+  }
+
+  const_reference at(size_type n) const
+  {
+    THROW_OUT_OF_RANGE_IF(n >= size(), "rope<Char, Traits>::at() subscript out of range");
+    return char_at(n);
+  }
+
+  const_reference front() const
+  {
+    MYSTL_DEBUG(!empty());
+    return char_at(0);
+  }
+
+  const_reference back() const
+  {
+    MYSTL_DEBUG(!empty());
+    return char_at(size() - 1);
+  }
+
+  // 修改容器相关操作
+
+  // append，都是 O(log n)，与 rhs 共享节点
+  rope& append(const rope& rhs)
+  {
+    ref(rhs.root_);
+    append_rep(rhs.root_);
+    return *this;
+  }
+  rope& append(rope&& rhs)
+  {
+    rep_type* r = rhs.root_;
+    rhs.root_ = nullptr;
+    append_rep(r);
+    return *this;
+  }
+  // 最右侧的路径不与其他 rope 共享时，短字符串直接写入最右的叶节点
+  rope& append(const CharType* s, size_type n)
+  {
+    if (!append_in_place(s, n))
+      append_rep(new_leaf(s, n, rope_short_leaf));
+    return *this;
+  }
+  rope& append(const CharType* s)
+  { return append(s, char_traits::length(s)); }
+  rope& append(const string_type& s)
+  { return append(s.begin(), s.size()); }
+  rope& append(string_type&& s)
+  { return append(rope(mystl::move(s))); }
+  rope& append(size_type n, CharType ch)
+  { return append(rope(n, ch)); }
+
+  void  push_back(CharType ch)
+  { append(&ch, 1); }
+
+  rope& operator+=(const rope& rhs)         { return append(rhs); }
+  rope& operator+=(rope&& rhs)              { return append(mystl::move(rhs)); }
+  rope& operator+=(const CharType* s)       { return append(s); }
+  rope& operator+=(const string_type& s)    { return append(s); }
+  rope& operator+=(string_type&& s)         { return append(mystl::move(s)); }
+  rope& operator+=(CharType ch)             { push_back(ch); return *this; }
+
+  // 在 pos 处插入 r，O(log n)
+  rope& insert(size_type pos, const rope& r);
+  rope& insert(size_type pos, const CharType* s)
+  { return insert(pos, rope(s)); }
+  rope& insert(size_type pos, const string_type& s)
+  { return insert(pos, rope(s)); }
+
+  // 删除从 pos 开始的 count 个字符，O(log n)
+  rope& erase(size_type pos = 0, size_type count = npos);
+
+  // 把从 pos 开始的 count 个字符替换为 r，O(log n)
+  rope& replace(size_type pos, size_type count, const rope& r);
+
+  void  clear() noexcept
+  {
+    unref(root_);
+    root_ = nullptr;
+  }
+
+  void  swap(rope& rhs) noexcept
+  { mystl::swap(root_, rhs.root_); }
+
+  // rope 相关操作
+
+  // 返回从 pos 开始的 count 个字符组成的 rope，O(log n)，与 *this 共享节点
+  rope  substr(size_type pos = 0, size_type count = npos) const;
+
+  // 展开成一个 basic_string
+  string_type str() const;
+
+  // 把从 pos 开始的 count 个字符复制到 dst，返回复制的字符个数
+  size_type copy(CharType* dst, size_type count, size_type pos = 0) const;
+
+  // 按顺序对每个叶节点调用 f(const CharType* data, size_t n)
+  template <class Function>
+  void for_each_chunk(Function f) const
+  {
+    for (auto it = chunk_begin(); it != chunk_end(); ++it)
+    {
+      auto c = *it;
+      f(c.first, c.second);
+    }
+  }
+
+  int compare(const rope& rhs) const;
+
+private:
+  // helper functions
+
+  static void ref(rep_type* t) noexcept
+  {
+    if (t != nullptr)
+      t->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  static void unref(rep_type* t) noexcept;
+
+  static unsigned height_of(const rep_type* t) noexcept
+  { return t->height; }
+
+  // 以下函数返回的节点引用计数为 1，参数中的节点引用都被消耗
+  static rep_type* alloc_rep();
+  static rep_type* new_leaf(const CharType* s, size_type n, size_type cap = 0);
+  static rep_type* new_leaf(string_type&& s);
+  static rep_type* new_sub(rep_type* leaf, size_type offset, size_type n);
+  static rep_type* new_concat(rep_type* l, rep_type* r);
+  static rep_type* make_node(rep_type* l, rep_type* r);
+  static rep_type* rotate_left(rep_type* t);
+  static rep_type* rotate_right(rep_type* t);
+  static rep_type* join(rep_type* l, rep_type* r);
+  static rep_type* join_right(rep_type* l, rep_type* r);
+  static rep_type* join_left(rep_type* l, rep_type* r);
+
+  // 返回 t 中 [first, last) 的部分，不消耗 t 的引用
+  static rep_type* sub(rep_type* t, size_type first, size_type last);
+
+  // 返回把 t 中 [first, last) 的部分替换为 mid 的结果，不消耗 t 的引用，消耗 mid 的引用
+  static rep_type* splice(rep_type* t, size_type first, size_type last, rep_type* mid);
+
+  // 把 r 接在末尾，消耗 r 的引用，失败时 *this 不变
+  void append_rep(rep_type* r)
+  {
+    ref(root_);
+    rep_type* t = join(root_, r);
+    unref(root_);
+    root_ = t;
+  }
+
+  bool append_in_place(const CharType* s, size_type n);
+
+  const_reference char_at(size_type n) const noexcept;
+};
+
+/*****************************************************************************************/
+
+template <class CharType, class CharTraits>
+constexpr typename rope<CharType, CharTraits>::size_type rope<CharType, CharTraits>::npos;
+
+// 在 pos 处插入 r
+template <class CharType, class CharTraits>
+rope<CharType, CharTraits>&
+rope<CharType, CharTraits>::insert(size_type pos, const rope& r)
+{
+  THROW_OUT_OF_RANGE_IF(pos > size(), "rope<Char, Traits>::insert() position out of range");
+  ref(r.root_);
+  rep_type* t = splice(root_, pos, pos, r.root_);
+  unref(root_);
+  root_ = t;
+  return *this;
+}
+
+// 删除从 pos 开始的 count 个字符
+template <class CharType, class CharTraits>
+rope<CharType, CharTraits>&
+rope<CharType, CharTraits>::erase(size_type pos, size_type count)
+{
+  THROW_OUT_OF_RANGE_IF(pos > size(), "rope<Char, Traits>::erase() position out of range");
+  const size_type n = size();
+  count = mystl::min(count, n - pos);
+  if (count == 0)
+    return *this;
+  rep_type* t = splice(root_, pos, pos + count, nullptr);
+  unref(root_);
+  root_ = t;
+  return *this;
+}
+
+// 替换从 pos 开始的 count 个字符
+template <class CharType, class CharTraits>
+rope<CharType, CharTraits>&
+rope<CharType, CharTraits>::replace(size_type pos, size_type count, const rope& r)
+{
+  THROW_OUT_OF_RANGE_IF(pos > size(), "rope<Char, Traits>::replace() position out of range");
+  const size_type n = size();
+  count = mystl::min(count, n - pos);
+  ref(r.root_);
+  rep_type* t = splice(root_, pos, pos + count, r.root_);
+  unref(root_);
+  root_ = t;
+  return *this;
+}
+
+// 返回从 pos 开始的 count 个字符组成的 rope
+template <class CharType, class CharTraits>
+rope<CharType, CharTraits>
+rope<CharType, CharTraits>::substr(size_type pos, size_type count) const
+{
+  THROW_OUT_OF_RANGE_IF(pos > size(), "rope<Char, Traits>::substr() position out of range");
+  count = mystl::min(count, size() - pos);
+  rope r;
+  r.root_ = sub(root_, pos, pos + count);
+  return r;
+}
+
+// 展开成一个 basic_string
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::string_type
+rope<CharType, CharTraits>::str() const
+{
+  string_type s;
+  s.reserve(size());
+  for_each_chunk([&s](const CharType* p, size_t n) { s.append(p, n); });
+  return s;
+}
+
+// 把从 pos 开始的 count 个字符复制到 dst
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::size_type
+rope<CharType, CharTraits>::copy(CharType* dst, size_type count, size_type pos) const
+{
+  THROW_OUT_OF_RANGE_IF(pos > size(), "rope<Char, Traits>::copy() position out of range");
+  count = mystl::min(count, size() - pos);
+  rope part = substr(pos, count);
+  part.for_each_chunk([&dst](const CharType* p, size_t n)
+  {
+    char_traits::copy(dst, p, n);
+    dst += n;
+  });
+  return count;
+}
+
+// 按字典序比较两个 rope
+template <class CharType, class CharTraits>
+int rope<CharType, CharTraits>::compare(const rope& rhs) const
+{
+  if (root_ == rhs.root_)
+    return 0;
+  auto i = chunk_begin(), j = rhs.chunk_begin();
+  const CharType* p = nullptr;
+  const CharType* q = nullptr;
+  size_t m = 0, n = 0;
+  while (true)
+  {
+    if (m == 0 && i != chunk_end())
+    {
+      auto c = *i++;
+      p = c.first;
+      m = c.second;
+    }
+    if (n == 0 && j != rhs.chunk_end())
+    {
+      auto c = *j++;
+      q = c.first;
+      n = c.second;
+    }
+    if (m == 0 || n == 0)
+      return m != 0 ? 1 : (n != 0 ? -1 : 0);
+    const size_t k = mystl::min(m, n);
+    const int r = char_traits::compare(p, q, k);
+    if (r != 0)
+      return r;
+    p += k;
+    q += k;
+    m -= k;
+    n -= k;
+  }
+}
+
+/*****************************************************************************************/
+// helper function
+
+// 释放一个引用，计数为 0 时销毁节点并释放它对子节点的引用
+template <class CharType, class CharTraits>
+void rope<CharType, CharTraits>::unref(rep_type* t) noexcept
+{
+  while (t != nullptr && t->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    rep_type* next = nullptr;
+    if (t->is_leaf())
+    {
+      if (t->owner)
+        mystl::destroy(t->str());
+      else
+        next = t->left;
+    }
+    else
+    {
+      unref(t->left);
+      next = t->right;
+    }
+    typedef typename rep_type::count_type count_type;
+    t->refs.~count_type();
+    rep_allocator::deallocate(t);
+    t = next;  // 沿右子树循环，避免递归过深
+  }
+}
+
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::alloc_rep()
+{
+  rep_type* t = rep_allocator::allocate(1);
+  ::new (static_cast<void*>(&t->refs)) typename rep_type::count_type(1);
+  t->owner = false;
+  t->left = nullptr;
+  t->right = nullptr;
+  t->data = nullptr;
+  t->height = 0;
+  t->size = 0;
+  return t;
+}
+
+// 复制 [s, s + n) 到一个新的叶节点，至少预留 cap 个字符的空间，n 为 0 时返回 nullptr
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::new_leaf(const CharType* s, size_type n, size_type cap)
+{
+  if (n == 0)
+    return nullptr;
+  string_type str;
+  str.reserve(n < cap ? cap : n);
+  str.append(s, n);
+  return new_leaf(mystl::move(str));
+}
+
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::new_leaf(string_type&& s)
+{
+  rep_type* t = alloc_rep();
+  mystl::construct(t->str(), mystl::move(s));
+  t->owner = true;
+  t->size = t->str()->size();
+  t->data = t->str()->begin();
+  return t;
+}
+
+// 叶节点 leaf 中从 offset 开始的 n 个字符，与 leaf 共享字符
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::new_sub(rep_type* leaf, size_type offset, size_type n)
+{
+  rep_type* owner = leaf->owner ? leaf : leaf->left;
+  rep_type* t = alloc_rep();
+  ref(owner);
+  t->left = owner;
+  t->size = n;
+  t->data = leaf->data + offset;
+  return t;
+}
+
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::new_concat(rep_type* l, rep_type* r)
+{
+  rep_type* t;
+  try
+  {
+    t = alloc_rep();
+  }
+  catch (...)
+  {
+    unref(l);
+    unref(r);
+    throw;
+  }
+  t->left = l;
+  t->right = r;
+  t->size = l->size + r->size;
+  t->height = mystl::max(l->height, r->height) + 1;
+  return t;
+}
+
+// 两个短叶节点合并为一个叶节点，否则新建拼接节点
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::make_node(rep_type* l, rep_type* r)
+{
+  if (l->is_leaf() && r->is_leaf() && l->size + r->size <= rope_short_leaf)
+  {
+    rep_type* t;
+    try
+    {
+      string_type s;
+      s.reserve(l->size + r->size);
+      s.append(l->data, l->size);
+      s.append(r->data, r->size);
+      t = new_leaf(mystl::move(s));
+    }
+    catch (...)
+    {
+      unref(l);
+      unref(r);
+      throw;
+    }
+    unref(l);
+    unref(r);
+    return t;
+  }
+  return new_concat(l, r);
+}
+
+// 左旋：(a, (b, c)) => ((a, b), c)
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::rotate_left(rep_type* t)
+{
+  rep_type* a = t->left;
+  rep_type* b = t->right->left;
+  rep_type* c = t->right->right;
+  ref(a);
+  ref(b);
+  ref(c);
+  unref(t);
+  rep_type* ab;
+  try
+  {
+    ab = new_concat(a, b);
+  }
+  catch (...)
+  {
+    unref(c);
+    throw;
+  }
+  return new_concat(ab, c);
+}
+
+// 右旋：((a, b), c) => (a, (b, c))
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::rotate_right(rep_type* t)
+{
+  rep_type* a = t->left->left;
+  rep_type* b = t->left->right;
+  rep_type* c = t->right;
+  ref(a);
+  ref(b);
+  ref(c);
+  unref(t);
+  rep_type* bc;
+  try
+  {
+    bc = new_concat(b, c);
+  }
+  catch (...)
+  {
+    unref(a);
+    throw;
+  }
+  return new_concat(a, bc);
+}
+
+// 拼接两棵树，高度相差超过 1 时沿较高一棵的边缘向下找到合适的位置，并在返回途中旋转恢复平衡
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::join(rep_type* l, rep_type* r)
+{
+  if (l == nullptr)
+    return r;
+  if (r == nullptr)
+    return l;
+  if (l->height > r->height + 1)
+    return join_right(l, r);
+  if (r->height > l->height + 1)
+    return join_left(l, r);
+  return make_node(l, r);
+}
+
+// l 比 r 高 2 以上
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::join_right(rep_type* l, rep_type* r)
+{
+  rep_type* a = l->left;
+  rep_type* c = l->right;
+  ref(a);
+  ref(c);
+  unref(l);
+  rep_type* t;
+  try
+  {
+    if (c->height <= r->height + 1)
+    {
+      t = make_node(c, r);
+      if (t->height > a->height + 1)
+        t = rotate_right(t);
+    }
+    else
+    {
+      t = join_right(c, r);
+    }
+  }
+  catch (...)
+  {
+    unref(a);
+    throw;
+  }
+  if (t->height <= a->height + 1)
+    return new_concat(a, t);
+  return rotate_left(new_concat(a, t));
+}
+
+// r 比 l 高 2 以上
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::join_left(rep_type* l, rep_type* r)
+{
+  rep_type* c = r->left;
+  rep_type* b = r->right;
+  ref(c);
+  ref(b);
+  unref(r);
+  rep_type* t;
+  try
+  {
+    if (c->height <= l->height + 1)
+    {
+      t = make_node(l, c);
+      if (t->height > b->height + 1)
+        t = rotate_left(t);
+    }
+    else
+    {
+      t = join_left(l, c);
+    }
+  }
+  catch (...)
+  {
+    unref(b);
+    throw;
+  }
+  if (t->height <= b->height + 1)
+    return new_concat(t, b);
+  return rotate_right(new_concat(t, b));
+}
+
+// 返回 t 中 [first, last) 的部分
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::sub(rep_type* t, size_type first, size_type last)
+{
+  if (first >= last)
+    return nullptr;
+  if (first == 0 && last == t->size)
+  {
+    ref(t);
+    return t;
+  }
+  if (t->is_leaf())
+    return new_sub(t, first, last - first);
+  const size_type ls = t->left->size;
+  if (last <= ls)
+    return sub(t->left, first, last);
+  if (first >= ls)
+    return sub(t->right, first - ls, last - ls);
+  rep_type* l = sub(t->left, first, ls);
+  rep_type* r;
+  try
+  {
+    r = sub(t->right, 0, last - ls);
+  }
+  catch (...)
+  {
+    unref(l);
+    throw;
+  }
+  return join(l, r);
+}
+
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::rep_type*
+rope<CharType, CharTraits>::splice(rep_type* t, size_type first, size_type last, rep_type* mid)
+{
+  const size_type n = t != nullptr ? t->size : 0;
+  rep_type* left = nullptr;
+  rep_type* right = nullptr;
+  try
+  {
+    left = sub(t, 0, first);
+  }
+  catch (...)
+  {
+    unref(mid);
+    throw;
+  }
+  left = join(left, mid);
+  try
+  {
+    right = sub(t, last, n);
+  }
+  catch (...)
+  {
+    unref(left);
+    throw;
+  }
+  return join(left, right);
+}
+
+// 从根到最右叶节点的路径上引用计数都为 1，且该叶节点拥有字符、追加后不超过 rope_short_leaf 时，
+// 直接把 [s, s + n) 写到叶节点末尾并更新路径上的长度，高度不变。否则返回 false，*this 不变
+template <class CharType, class CharTraits>
+bool rope<CharType, CharTraits>::append_in_place(const CharType* s, size_type n)
+{
+  if (root_ == nullptr || n == 0)
+    return n == 0;
+  rep_type* t = root_;
+  for (;;)
+  {
+    if (t->refs.load(std::memory_order_acquire) != 1)
+      return false;
+    if (t->is_leaf())
+      break;
+    t = t->right;
+  }
+  if (!t->owner || t->size + n > rope_short_leaf)
+    return false;
+  t->str()->append(s, n);
+  t->data = t->str()->begin();
+  for (rep_type* p = root_; p != t; p = p->right)
+    p->size += n;
+  t->size += n;
+  return true;
+}
+
+template <class CharType, class CharTraits>
+typename rope<CharType, CharTraits>::const_reference
+rope<CharType, CharTraits>::char_at(size_type n) const noexcept
+{
+  const rep_type* t = root_;
+  while (!t->is_leaf())
+  {
+    if (n < t->left->size)
+    {
+      t = t->left;
+    }
+    else
+    {
+      n -= t->left->size;
+      t = t->right;
+    }
+  }
+  return t->data[n];
+}
+
+/*****************************************************************************************/
+
+// 拼接，结果与参数共享节点
+template <class CharType, class CharTraits>
+rope<CharType, CharTraits>
+operator+(const rope<CharType, CharTraits>& lhs, const rope<CharType, CharTraits>& rhs)
+{
+  rope<CharType, CharTraits> tmp(lhs);
+  tmp.append(rhs);
+  return tmp;
+}
+
+template <class CharType, class CharTraits>
+rope<CharType, CharTraits>
+operator+(rope<CharType, CharTraits>&& lhs, const rope<CharType, CharTraits>& rhs)
+{
+  rope<CharType, CharTraits> tmp(mystl::move(lhs));
+  tmp.append(rhs);
+  return tmp;
+}
+
+template <class CharType, class CharTraits>
+rope<CharType, CharTraits>
+operator+(const rope<CharType, CharTraits>& lhs, const CharType* rhs)
+{
+  rope<CharType, CharTraits> tmp(lhs);
+  tmp.append(rhs);
+  return tmp;
+}
+
+template <class CharType, class CharTraits>
+rope<CharType, CharTraits>
+operator+(rope<CharType, CharTraits>&& lhs, const CharType* rhs)
+{
+  rope<CharType, CharTraits> tmp(mystl::move(lhs));
+  tmp.append(rhs);
+  return tmp;
+}
+
+// 重载比较操作符
+template <class CharType, class CharTraits>
+bool operator==(const rope<CharType, CharTraits>& lhs, const rope<CharType, CharTraits>& rhs)
+{
+  return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const rope<CharType, CharTraits>& lhs, const rope<CharType, CharTraits>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator<(const rope<CharType, CharTraits>& lhs, const rope<CharType, CharTraits>& rhs)
+{
+  return lhs.compare(rhs) < 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>(const rope<CharType, CharTraits>& lhs, const rope<CharType, CharTraits>& rhs)
+{
+  return rhs < lhs;
+}
+
+template <class CharType, class CharTraits>
+bool operator<=(const rope<CharType, CharTraits>& lhs, const rope<CharType, CharTraits>& rhs)
+{
+  return !(rhs < lhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator>=(const rope<CharType, CharTraits>& lhs, const rope<CharType, CharTraits>& rhs)
+{
+  return !(lhs < rhs);
+}
+
+// 按叶节点输出，不展开
+template <class CharType, class CharTraits>
+std::basic_ostream<CharType>&
+operator<<(std::basic_ostream<CharType>& os, const rope<CharType, CharTraits>& r)
+{
+  r.for_each_chunk([&os](const CharType* p, size_t n)
+  {
+    os.write(p, static_cast<std::streamsize>(n));
+  });
+  return os;
+}
+
+// 重载 mystl 的 swap
+template <class CharType, class CharTraits>
+void swap(rope<CharType, CharTraits>& lhs, rope<CharType, CharTraits>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_ROPE_H_
+
@@ -18,6 +18,9 @@
 namespace mystl
 {
 
+template <class Key, class Compare>
+class multiset;
+
 // 模板类 set，键值不允许重复
 // 参数一代表键值类型，参数二代表键值比较方式，缺省使用 mystl::less 
 template <class Key, class Compare = mystl::less<Key>>
@@ -34,9 +37,15 @@ private:
   typedef mystl::rb_tree<value_type, key_compare>  base_type;
   base_type tree_;
 
+  // 不同比较方式的 set 与 multiset 之间可以相互转移节点
+  template <class, class> friend class set;
+  template <class, class> friend class multiset;
+
 public:
   // 使用 rb_tree 定义的型别
-  typedef typename base_type::node_type              node_type;
+  typedef mystl::node_handle<value_type, typename base_type::node_type, false> node_type;
+  typedef mystl::node_insert_return<typename base_type::const_iterator, node_type>
+                                                     insert_return_type;
   typedef typename base_type::const_pointer          pointer;
   typedef typename base_type::const_pointer          const_pointer;
   typedef typename base_type::const_reference        reference;
@@ -57,6 +66,11 @@ public:
   set(InputIterator first, InputIterator last) 
     :tree_() 
   { tree_.insert_unique(first, last); }
+  // 区间已经有序时，以线性时间构造
+  template <class InputIterator>
+  set(mystl::sorted_unique_tag tag, InputIterator first, InputIterator last)
+    :tree_()
+  { tree_.insert_unique(tag, first, last); }
   set(std::initializer_list<value_type> ilist)
     :tree_()
   { tree_.insert_unique(ilist.begin(), ilist.end()); }
@@ -164,6 +178,11 @@ public:
   {
     tree_.insert_unique(first, last);
   }
+  template <class InputIterator>
+  void insert(mystl::sorted_unique_tag tag, InputIterator first, InputIterator last)
+  {
+    tree_.insert_unique(tag, first, last);
+  }
 
   void      erase(iterator position)             { tree_.erase(position); }
   size_type erase(const key_type& key)           { return tree_.erase_unique(key); }
@@ -171,6 +190,40 @@ public:
 
   void      clear() { tree_.clear(); }
 
+  // 节点的摘取与接合
+
+  node_type extract(const_iterator position)
+  { return node_type(tree_.extract_node(position)); }
+  node_type extract(const key_type& key)
+  {
+    auto it = tree_.find(key);
+    return it == tree_.end() ? node_type() : node_type(tree_.extract_node(it));
+  }
+
+  insert_return_type insert(node_type&& nh)
+  {
+    if (nh.empty())
+      return insert_return_type{end(), false, node_type()};
+    auto res = tree_.reinsert_node_unique(nh.get());
+    if (!res.second)
+      return insert_return_type{res.first, false, mystl::move(nh)};
+    nh.release();
+    return insert_return_type{res.first, true, node_type()};
+  }
+
+  template <class Compare2>
+  void      merge(set<Key, Compare2>& source)
+  { tree_.merge_unique(source.tree_); }
+  template <class Compare2>
+  void      merge(set<Key, Compare2>&& source)
+  { tree_.merge_unique(source.tree_); }
+  template <class Compare2>
+  void      merge(multiset<Key, Compare2>& source)
+  { tree_.merge_unique(source.tree_); }
+  template <class Compare2>
+  void      merge(multiset<Key, Compare2>&& source)
+  { tree_.merge_unique(source.tree_); }
+
   // set 相关操作
 
   iterator       find(const key_type& key)              { return tree_.find(key); }
@@ -192,6 +245,15 @@ public:
     equal_range(const key_type& key) const
   { return tree_.equal_range_unique(key); }
 
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计相关操作，以 O(logn) 的时间完成
+
+  iterator       nth(size_type k)                 const { return tree_.nth(k); }
+
+  size_type      rank(const key_type& key)        const { return tree_.rank(key); }
+  size_type      index_of(const_iterator it)      const { return tree_.index_of(it); }
+#endif
+
   void swap(set& rhs) noexcept
   { tree_.swap(rhs.tree_); }
 
@@ -262,9 +324,13 @@ private:
   typedef mystl::rb_tree<value_type, key_compare>  base_type;
   base_type tree_;  // 以 rb_tree 表现 multiset
 
+  // 不同比较方式的 set 与 multiset 之间可以相互转移节点
+  template <class, class> friend class set;
+  template <class, class> friend class multiset;
+
 public:
   // 使用 rb_tree 定义的型别
-  typedef typename base_type::node_type              node_type;
+  typedef mystl::node_handle<value_type, typename base_type::node_type, false> node_type;
   typedef typename base_type::const_pointer          pointer;
   typedef typename base_type::const_pointer          const_pointer;
   typedef typename base_type::const_reference        reference;
@@ -285,6 +351,11 @@ public:
   multiset(InputIterator first, InputIterator last) 
     :tree_() 
   { tree_.insert_multi(first, last); }
+  // 区间已经有序时，以线性时间构造
+  template <class InputIterator>
+  multiset(mystl::sorted_equivalent_tag tag, InputIterator first, InputIterator last)
+    :tree_()
+  { tree_.insert_multi(tag, first, last); }
   multiset(std::initializer_list<value_type> ilist)
     :tree_() 
   { tree_.insert_multi(ilist.begin(), ilist.end()); }
@@ -392,6 +463,11 @@ public:
   {
     tree_.insert_multi(first, last);
   }
+  template <class InputIterator>
+  void insert(mystl::sorted_equivalent_tag tag, InputIterator first, InputIterator last)
+  {
+    tree_.insert_multi(tag, first, last);
+  }
 
   void           erase(iterator position)             { tree_.erase(position); }
   size_type      erase(const key_type& key)           { return tree_.erase_multi(key); }
@@ -399,6 +475,38 @@ public:
 
   void           clear() { tree_.clear(); }
 
+  // 节点的摘取与接合
+
+  node_type extract(const_iterator position)
+  { return node_type(tree_.extract_node(position)); }
+  node_type extract(const key_type& key)
+  {
+    auto it = tree_.find(key);
+    return it == tree_.end() ? node_type() : node_type(tree_.extract_node(it));
+  }
+
+  iterator  insert(node_type&& nh)
+  {
+    if (nh.empty())
+      return end();
+    auto it = tree_.reinsert_node_multi(nh.get());
+    nh.release();
+    return it;
+  }
+
+  template <class Compare2>
+  void      merge(set<Key, Compare2>& source)
+  { tree_.merge_multi(source.tree_); }
+  template <class Compare2>
+  void      merge(set<Key, Compare2>&& source)
+  { tree_.merge_multi(source.tree_); }
+  template <class Compare2>
+  void      merge(multiset<Key, Compare2>& source)
+  { tree_.merge_multi(source.tree_); }
+  template <class Compare2>
+  void      merge(multiset<Key, Compare2>&& source)
+  { tree_.merge_multi(source.tree_); }
+
   // multiset 相关操作
 
   iterator       find(const key_type& key)              { return tree_.find(key); }
@@ -420,6 +528,15 @@ public:
     equal_range(const key_type& key) const
   { return tree_.equal_range_multi(key); }
 
+#ifdef MYSTL_RB_TREE_ORDER_STATISTICS
+  // 顺序统计相关操作，以 O(logn) 的时间完成
+
+  iterator       nth(size_type k)                 const { return tree_.nth(k); }
+
+  size_type      rank(const key_type& key)        const { return tree_.rank(key); }
+  size_type      index_of(const_iterator it)      const { return tree_.index_of(it); }
+#endif
+
   void swap(multiset& rhs) noexcept
   { tree_.swap(rhs.tree_); }
 
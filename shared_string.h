@@ -0,0 +1,433 @@
+﻿#ifndef MYTINYSTL_SHARED_STRING_H_
+#define MYTINYSTL_SHARED_STRING_H_
+
+// 这个头文件包含一个模板类 basic_shared_string
+// basic_shared_string : 不可变的共享字符串，复制只增加引用计数
+
+// notes:
+//
+// 引用计数、长度、哈希值和字符放在同一块内存中，对象本身只有一个指针：
+//   * 复制和赋值是 O(1) 的，同样的内容被复制到大量记录中时只保存一份
+//   * 哈希值在构造时计算一次，与 mystl::hash<basic_string> 的结果相同，之后直接读取
+//   * 相等比较先比较是否共享同一块内存，再比较长度和哈希值，最后才比较字符
+//   * 内容不可修改，需要修改时用 str() 复制出一个 basic_string
+//   * 空字符串不分配内存
+//
+// 引用计数是原子的，不同线程可以同时复制、读取和销毁共享同一份内容的对象，但同一个对象的赋值需要外部同步
+
+#include <atomic>
+#include <iostream>
+#include <new>
+
+#include "basic_string.h"
+#include "functional.h"
+#include "iterator.h"
+#include "util.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// 共享内容的头部，字符紧跟在它后面，以空字符结尾
+template <class CharType>
+struct shared_string_rep
+{
+  std::atomic<size_t> refs;  // 引用计数
+  size_t              size;  // 字符个数
+  size_t              hash;  // 缓存的哈希值
+
+  CharType*       data() noexcept       { return reinterpret_cast<CharType*>(this + 1); }
+  const CharType* data() const noexcept { return reinterpret_cast<const CharType*>(this + 1); }
+};
+
+// 模板类 basic_shared_string
+// 参数一代表字符类型，参数二代表萃取字符类型的方式，缺省使用 mystl::char_traits
+template <class CharType, class CharTraits = mystl::char_traits<CharType>>
+class basic_shared_string
+{
+public:
+  typedef CharTraits                                    traits_type;
+  typedef CharTraits                                    char_traits;
+  typedef CharType                                      value_type;
+  typedef const CharType*                               pointer;
+  typedef const CharType*                               const_pointer;
+  typedef const CharType&                               reference;
+  typedef const CharType&                               const_reference;
+  typedef size_t                                        size_type;
+  typedef ptrdiff_t                                     difference_type;
+  typedef const CharType*                               iterator;
+  typedef const CharType*                               const_iterator;
+  typedef mystl::reverse_iterator<const_iterator>       reverse_iterator;
+  typedef mystl::reverse_iterator<const_iterator>       const_reverse_iterator;
+
+  typedef mystl::basic_string<CharType, CharTraits>     string_type;
+
+  static constexpr size_type npos = static_cast<size_type>(-1);
+
+private:
+  typedef shared_string_rep<CharType>                   rep_type;
+  typedef mystl::allocator<rep_type>                    rep_allocator;
+
+  rep_type* rep_;
+
+public:
+  // 构造、复制、移动、析构函数
+
+  basic_shared_string() noexcept
+    :rep_(nullptr)
+  {
+  }
+
+  basic_shared_string(const CharType* s)
+    :rep_(make_rep(s, char_traits::length(s)))
+  {
+  }
+
+  basic_shared_string(const CharType* s, size_type n)
+    :rep_(make_rep(s, n))
+  {
+  }
+
+  basic_shared_string(const string_type& s)
+    :rep_(make_rep(s.begin(), s.size()))
+  {
+  }
+
+  basic_shared_string(const basic_shared_string& rhs) noexcept
+    :rep_(rhs.rep_)
+  {
+    ref(rep_);
+  }
+
+  basic_shared_string(basic_shared_string&& rhs) noexcept
+    :rep_(rhs.rep_)
+  {
+    rhs.rep_ = nullptr;
+  }
+
+  basic_shared_string& operator=(const basic_shared_string& rhs) noexcept
+  {
+    ref(rhs.rep_);
+    unref(rep_);
+    rep_ = rhs.rep_;
+    return *this;
+  }
+
+  basic_shared_string& operator=(basic_shared_string&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      unref(rep_);
+      rep_ = rhs.rep_;
+      rhs.rep_ = nullptr;
+    }
+    return *this;
+  }
+
+  ~basic_shared_string()
+  {
+    unref(rep_);
+  }
+
+public:
+  // 迭代器相关操作
+  const_iterator         begin()   const noexcept { return data(); }
+  const_iterator         end()     const noexcept { return data() + size(); }
+  const_iterator         cbegin()  const noexcept { return begin(); }
+  const_iterator         cend()    const noexcept { return end(); }
+  const_reverse_iterator rbegin()  const noexcept { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend()    const noexcept { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+  const_reverse_iterator crend()   const noexcept { return rend(); }
+
+  // 容量相关操作
+  bool      empty()  const noexcept { return rep_ == nullptr; }
+  size_type size()   const noexcept { return rep_ == nullptr ? 0 : rep_->size; }
+  size_type length() const noexcept { return size(); }
+
+  // 共享同一份内容的对象个数，空字符串返回 0
+  size_type use_count() const noexcept
+  { return rep_ == nullptr ? 0 : rep_->refs.load(std::memory_order_relaxed); }
+
+  // 访问元素相关操作
+  const_reference operator[](size_type n) const noexcept
+  {
+    MYSTL_DEBUG(n <= size());
+    return data()[n];
+  }
+  const_reference at(size_type n) const
+  {
+    THROW_OUT_OF_RANGE_IF(n >= size(), "basic_shared_string<Char, Traits>::at()"
+                          "subscript out of range");
+    return data()[n];
+  }
+  const_reference front() const noexcept
+  {
+    MYSTL_DEBUG(!empty());
+    return data()[0];
+  }
+  const_reference back() const noexcept
+  {
+    MYSTL_DEBUG(!empty());
+    return data()[size() - 1];
+  }
+
+  // 总是以空字符结尾
+  const_pointer data()  const noexcept { return rep_ == nullptr ? empty_data() : rep_->data(); }
+  const_pointer c_str() const noexcept { return data(); }
+
+  // 缓存的哈希值，与 mystl::hash<basic_string> 对相同内容的结果相同
+  size_t hash() const noexcept
+  { return rep_ == nullptr ? empty_hash() : rep_->hash; }
+
+  // 是否与 rhs 共享同一份内容
+  bool shares_with(const basic_shared_string& rhs) const noexcept
+  { return rep_ == rhs.rep_; }
+
+  string_type str() const
+  { return string_type(data(), size()); }
+
+  basic_shared_string substr(size_type pos = 0, size_type count = npos) const
+  {
+    THROW_OUT_OF_RANGE_IF(pos > size(), "basic_shared_string<Char, Traits>::substr's pos out of range");
+    if (pos == 0 && count >= size())
+      return *this;
+    return basic_shared_string(data() + pos, mystl::min(count, size() - pos));
+  }
+
+  size_type copy(CharType* s, size_type count, size_type pos = 0) const
+  {
+    THROW_OUT_OF_RANGE_IF(pos > size(), "basic_shared_string<Char, Traits>::copy's pos out of range");
+    const size_type n = mystl::min(count, size() - pos);
+    char_traits::copy(s, data() + pos, n);
+    return n;
+  }
+
+  // 比较，与 basic_string::compare 的结果一致
+  int compare(const CharType* s, size_type n) const noexcept
+  {
+    const size_type len = size();
+    const int r = char_traits::compare(data(), s, mystl::min(len, n));
+    if (r != 0)
+      return r;
+    return len < n ? -1 : (len > n ? 1 : 0);
+  }
+  int compare(const basic_shared_string& rhs) const noexcept
+  { return rep_ == rhs.rep_ ? 0 : compare(rhs.data(), rhs.size()); }
+  int compare(const string_type& rhs) const noexcept
+  { return compare(rhs.begin(), rhs.size()); }
+  int compare(const CharType* s) const noexcept
+  { return compare(s, char_traits::length(s)); }
+
+  bool equals(const basic_shared_string& rhs) const noexcept
+  {
+    if (rep_ == rhs.rep_)
+      return true;
+    if (rep_ == nullptr || rhs.rep_ == nullptr)
+      return false;
+    return rep_->size == rhs.rep_->size && rep_->hash == rhs.rep_->hash &&
+           char_traits::compare(rep_->data(), rhs.rep_->data(), rep_->size) == 0;
+  }
+
+  void clear() noexcept
+  {
+    unref(rep_);
+    rep_ = nullptr;
+  }
+
+  void swap(basic_shared_string& rhs) noexcept
+  {
+    mystl::swap(rep_, rhs.rep_);
+  }
+
+private:
+  static const CharType* empty_data() noexcept
+  {
+    static const CharType zero = CharType();
+    return &zero;
+  }
+
+  static size_t empty_hash() noexcept
+  {
+    return mystl::hash_bytes(empty_data(), 0);
+  }
+
+  static void ref(rep_type* r) noexcept
+  {
+    if (r != nullptr)
+      r->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static void unref(rep_type* r) noexcept
+  {
+    typedef std::atomic<size_t> count_type;
+    if (r != nullptr && r->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      r->refs.~count_type();
+      rep_allocator::deallocate(r, rep_units(r->size));
+    }
+  }
+
+  // 头部加上 n 个字符与结尾空字符需要的 rep_type 个数
+  static size_type rep_units(size_type n) noexcept
+  {
+    return 1 + ((n + 1) * sizeof(CharType) + sizeof(rep_type) - 1) / sizeof(rep_type);
+  }
+
+  static rep_type* make_rep(const CharType* s, size_type n);
+};
+
+/*****************************************************************************************/
+
+template <class CharType, class CharTraits>
+constexpr typename basic_shared_string<CharType, CharTraits>::size_type
+basic_shared_string<CharType, CharTraits>::npos;
+
+// 复制 [s, s + n)，n 为 0 时返回 nullptr
+template <class CharType, class CharTraits>
+typename basic_shared_string<CharType, CharTraits>::rep_type*
+basic_shared_string<CharType, CharTraits>::make_rep(const CharType* s, size_type n)
+{
+  if (n == 0)
+    return nullptr;
+  THROW_LENGTH_ERROR_IF(n > (static_cast<size_type>(-1) / sizeof(rep_type) - 2) * sizeof(rep_type) / sizeof(CharType),
+                        "basic_shared_string<Char, Traits>'s size too big");
+  rep_type* r = rep_allocator::allocate(rep_units(n));
+  ::new (static_cast<void*>(&r->refs)) std::atomic<size_t>(1);
+  r->size = n;
+  char_traits::copy(r->data(), s, n);
+  r->data()[n] = CharType();
+  r->hash = mystl::hash_bytes(s, n * sizeof(CharType));
+  return r;
+}
+
+/*****************************************************************************************/
+// 重载比较操作符，可以与 basic_string 和字符串字面量比较
+
+template <class CharType, class CharTraits>
+bool operator==(const basic_shared_string<CharType, CharTraits>& lhs,
+                const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return lhs.equals(rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const basic_shared_string<CharType, CharTraits>& lhs,
+                const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return !lhs.equals(rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator<(const basic_shared_string<CharType, CharTraits>& lhs,
+               const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return lhs.compare(rhs) < 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>(const basic_shared_string<CharType, CharTraits>& lhs,
+               const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return lhs.compare(rhs) > 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator<=(const basic_shared_string<CharType, CharTraits>& lhs,
+                const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return lhs.compare(rhs) <= 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>=(const basic_shared_string<CharType, CharTraits>& lhs,
+                const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return lhs.compare(rhs) >= 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator==(const basic_shared_string<CharType, CharTraits>& lhs,
+                const basic_string<CharType, CharTraits>& rhs) noexcept
+{
+  return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator==(const basic_string<CharType, CharTraits>& lhs,
+                const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return rhs == lhs;
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const basic_shared_string<CharType, CharTraits>& lhs,
+                const basic_string<CharType, CharTraits>& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const basic_string<CharType, CharTraits>& lhs,
+                const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return !(rhs == lhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator==(const basic_shared_string<CharType, CharTraits>& lhs, const CharType* rhs) noexcept
+{
+  return lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator==(const CharType* lhs, const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return rhs.compare(lhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const basic_shared_string<CharType, CharTraits>& lhs, const CharType* rhs) noexcept
+{
+  return lhs.compare(rhs) != 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const CharType* lhs, const basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  return rhs.compare(lhs) != 0;
+}
+
+template <class CharType, class CharTraits>
+std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>& os,
+                                         const basic_shared_string<CharType, CharTraits>& s)
+{
+  return os.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+// 重载 mystl 的 swap
+template <class CharType, class CharTraits>
+void swap(basic_shared_string<CharType, CharTraits>& lhs,
+          basic_shared_string<CharType, CharTraits>& rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+// 特化 mystl::hash，直接返回缓存的哈希值
+template <class CharType, class CharTraits>
+struct hash<basic_shared_string<CharType, CharTraits>>
+{
+  typedef void is_avalanching;
+  size_t operator()(const basic_shared_string<CharType, CharTraits>& str) const noexcept
+  {
+    return str.hash();
+  }
+};
+
+using shared_string    = mystl::basic_shared_string<char>;
+using wshared_string   = mystl::basic_shared_string<wchar_t>;
+using u16shared_string = mystl::basic_shared_string<char16_t>;
+using u32shared_string = mystl::basic_shared_string<char32_t>;
+
+} // namespace mystl
+#endif // !MYTINYSTL_SHARED_STRING_H_
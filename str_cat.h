@@ -0,0 +1,151 @@
+﻿#ifndef MYTINYSTL_STR_CAT_H_
+#define MYTINYSTL_STR_CAT_H_
+
+// 这个头文件包含 str_cat 与 str_append，以及它们使用的 str_piece
+// str_cat    : 把任意多个字符串、字符、整数、浮点数拼接成一个 string
+// str_append : 把任意多个片段追加到已有的 string 末尾
+
+// notes:
+//
+// 每个参数先转换成一个 str_piece：字符串只记录起始位置和长度，字符、整数和浮点数格式化到 str_piece
+// 自带的缓冲区中，数值的格式与 to_chars 相同。所有片段的长度在拼接之前就已知道，因此：
+//   * str_cat 只申请一次空间，a + b + c + d 则会产生三个中间 string
+//   * str_append 至多重新分配一次空间，空间不足时按 1.5 倍增长，反复追加到同一个 string 是均摊 O(1) 的
+// str_piece 只在当前的完整表达式中有效，不要保存它
+
+#include <functional>
+#include <initializer_list>
+
+#include "astring.h"
+#include "charconv.h"
+#include "algobase.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// str_piece : 拼接的一个片段
+// 字符串直接引用原来的字符，其他类型格式化到 buf_ 中，此时 data_ 为 nullptr，
+// 这样复制 str_piece 不会使它指向另一个对象的缓冲区
+class str_piece
+{
+public:
+  str_piece(const char* s) noexcept
+    :data_(s == nullptr ? "" : s), size_(s == nullptr ? 0 : mystl::char_traits<char>::length(s))
+  {
+  }
+  str_piece(const char* s, size_t n) noexcept
+    :data_(s), size_(n)
+  {
+  }
+  str_piece(const mystl::string& s) noexcept
+    :data_(s.begin()), size_(s.size())
+  {
+  }
+  str_piece(char ch) noexcept
+    :data_(nullptr), size_(1)
+  {
+    buf_[0] = ch;
+  }
+
+  str_piece(int v) noexcept                { format(v); }
+  str_piece(long v) noexcept               { format(v); }
+  str_piece(long long v) noexcept          { format(v); }
+  str_piece(unsigned v) noexcept           { format(v); }
+  str_piece(unsigned long v) noexcept      { format(v); }
+  str_piece(unsigned long long v) noexcept { format(v); }
+  str_piece(float v) noexcept              { format(v); }
+  str_piece(double v) noexcept             { format(v); }
+
+  const char* data() const noexcept { return data_ == nullptr ? buf_ : data_; }
+  size_t      size() const noexcept { return size_; }
+
+private:
+  const char* data_;
+  size_t      size_;
+  char        buf_[32];
+
+  template <class T>
+  void format(T v) noexcept
+  {
+    size_ = static_cast<size_t>(mystl::to_chars(buf_, buf_ + sizeof(buf_), v).ptr - buf_);
+    data_ = nullptr;
+  }
+};
+
+/*****************************************************************************************/
+
+// 把 pieces 中的片段依次复制到 out 开始的位置，返回结尾位置
+inline char* str_copy_pieces(char* out, std::initializer_list<str_piece> pieces) noexcept
+{
+  for (const auto& p : pieces)
+  {
+    mystl::char_traits<char>::copy(out, p.data(), p.size());
+    out += p.size();
+  }
+  return out;
+}
+
+inline size_t str_pieces_size(std::initializer_list<str_piece> pieces) noexcept
+{
+  size_t n = 0;
+  for (const auto& p : pieces)
+    n += p.size();
+  return n;
+}
+
+inline mystl::string str_cat_pieces(std::initializer_list<str_piece> pieces)
+{
+  const size_t n = str_pieces_size(pieces);
+  mystl::string result(n, '\0');
+  str_copy_pieces(result.begin(), pieces);
+  return result;
+}
+
+inline void str_append_pieces(mystl::string& dst, std::initializer_list<str_piece> pieces)
+{
+  const size_t n = str_pieces_size(pieces);
+  THROW_LENGTH_ERROR_IF(dst.size() > dst.max_size() - n,
+                        "string's size too big in str_append");
+  const size_t need = dst.size() + n;
+  if (dst.capacity() < need)
+  {
+    const size_t cap = mystl::max(need, dst.capacity() + (dst.capacity() >> 1));
+    // 片段可能引用 dst 自身的字符，这时先在新的 string 中拼好再交换
+    std::less<const char*> less;
+    for (const auto& p : pieces)
+    {
+      if (p.size() != 0 && !less(p.data(), dst.begin()) && less(p.data(), dst.begin() + dst.capacity()))
+      {
+        mystl::string tmp;
+        tmp.reserve(cap);
+        tmp.append(dst.begin(), dst.size());
+        for (const auto& q : pieces)
+          tmp.append(q.data(), q.size());
+        dst.swap(tmp);
+        return;
+      }
+    }
+    dst.reserve(cap);
+  }
+  // 空间足够，append 不会重新分配
+  for (const auto& p : pieces)
+    dst.append(p.data(), p.size());
+}
+
+// str_cat(args...)：返回各参数拼接成的 string，只申请一次空间
+template <class... Args>
+mystl::string str_cat(const Args&... args)
+{
+  return str_cat_pieces({ str_piece(args)... });
+}
+
+// str_append(dst, args...)：把各参数依次追加到 dst 末尾，参数可以引用 dst 自身
+template <class... Args>
+void str_append(mystl::string& dst, const Args&... args)
+{
+  str_append_pieces(dst, { str_piece(args)... });
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_STR_CAT_H_
@@ -0,0 +1,278 @@
+﻿#ifndef MYTINYSTL_STRING_INTERNER_H_
+#define MYTINYSTL_STRING_INTERNER_H_
+
+// 这个头文件包含一个类 string_interner
+// string_interner : 字符串驻留表，把内容相同的字符串映射为同一个从 0 开始连续编号的 32 位 id
+
+// notes:
+//
+// 每个不同的字符串只保存一份，之后只需要保存和比较 id：
+//   * 两个 id 相等当且仅当字符串相等，id 可以直接用 == 比较、用 mystl::hash<uint32_t> 哈希
+//   * 字符保存在只追加的内存块中，以空字符结尾，在 string_interner 销毁或 clear 之前地址不变
+//   * 从字符串到 id 的索引是一个 hashtable，节点中缓存了哈希值，查找时只计算一次哈希
+//   * 从 id 到字符串的表分成大小按 2 倍增长的若干段，已有的段不会移动
+//
+// 线程安全：
+//   * intern 与 find 用互斥锁保护，可以在多个线程中同时调用
+//   * c_str、length、hash 这些按 id 读取的函数不加锁，可以与 intern 同时调用，
+//     只要 id 是本线程得到的，或者由其他线程通过带同步的方式传递过来
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "hashtable.h"
+#include "vector.h"
+#include "astring.h"
+#include "charconv.h"
+#include "functional.h"
+#include "allocator.h"
+#include "exceptdef.h"
+
+namespace mystl
+{
+
+// 字符块的大小，较长的字符串单独占用一块
+static constexpr size_t string_interner_block_size = 64 * 1024;
+
+// id 表第一段的大小为 2^string_interner_first_segment_bits，之后每段是前一段的两倍
+static constexpr unsigned string_interner_first_segment_bits = 8;
+static constexpr unsigned string_interner_segment_count = 32 - string_interner_first_segment_bits;
+
+// id 表中的一项
+struct string_interner_entry
+{
+  const char* data;  // 以空字符结尾的字符
+  size_t      size;  // 字符个数
+  size_t      hash;  // 与 mystl::hash<string> 的结果相同
+};
+
+// hashtable 中保存的键值，只用 data 和 size 计算哈希值和比较，id 不参与
+struct string_interner_key
+{
+  const char* data;
+  size_t      size;
+  uint32_t    id;
+};
+
+struct string_interner_key_hash
+{
+  typedef void is_avalanching;
+  size_t operator()(const string_interner_key& key) const noexcept
+  { return mystl::hash_bytes(key.data, key.size); }
+};
+
+struct string_interner_key_equal
+{
+  bool operator()(const string_interner_key& lhs, const string_interner_key& rhs) const noexcept
+  {
+    return lhs.size == rhs.size && mystl::char_traits<char>::compare(lhs.data, rhs.data, lhs.size) == 0;
+  }
+};
+
+class string_interner
+{
+public:
+  typedef uint32_t id_type;
+  typedef size_t   size_type;
+
+  // find 找不到时返回的 id
+  static constexpr id_type npos = static_cast<id_type>(-1);
+
+private:
+  typedef hashtable<string_interner_key, string_interner_key_hash, string_interner_key_equal> index_type;
+  typedef mystl::allocator<char>                  char_allocator;
+  typedef mystl::allocator<string_interner_entry> entry_allocator;
+
+  index_type                  index_;      // 字符串到 id 的索引
+  string_interner_entry*      segments_[string_interner_segment_count];  // id 到字符串的表
+  std::atomic<id_type>        size_;       // 已有的 id 个数
+  mystl::vector<char*>        blocks_;     // 所有的字符块
+  char*                       cur_;        // 当前块中未使用部分的起始位置
+  size_type                   left_;       // 当前块中未使用的字节数
+  size_type                   bytes_;      // 所有字符块的总字节数
+  mutable std::mutex          mutex_;
+
+public:
+  // 构造、析构函数，不可复制
+
+  explicit string_interner(size_type bucket_count = 100)
+    :index_(bucket_count), size_(0), cur_(nullptr), left_(0), bytes_(0)
+  {
+    for (auto& s : segments_)
+      s = nullptr;
+  }
+
+  string_interner(const string_interner&) = delete;
+  string_interner& operator=(const string_interner&) = delete;
+
+  ~string_interner()
+  {
+    release();
+  }
+
+public:
+  // 返回与 [s, s + n) 内容相同的字符串的 id，不存在时新建一个
+  id_type intern(const char* s, size_type n);
+  id_type intern(const char* s)       { return intern(s, mystl::char_traits<char>::length(s)); }
+  id_type intern(const string& s)     { return intern(s.begin(), s.size()); }
+
+  // 返回与 [s, s + n) 内容相同的字符串的 id，不存在时返回 npos
+  id_type find(const char* s, size_type n) const;
+  id_type find(const char* s) const   { return find(s, mystl::char_traits<char>::length(s)); }
+  id_type find(const string& s) const { return find(s.begin(), s.size()); }
+
+  bool    contains(const char* s, size_type n) const { return find(s, n) != npos; }
+  bool    contains(const string& s) const            { return find(s) != npos; }
+
+  // 按 id 读取，不加锁
+  const char* c_str(id_type id) const noexcept  { return entry(id).data; }
+  size_type   length(id_type id) const noexcept { return entry(id).size; }
+  size_t      hash(id_type id) const noexcept   { return entry(id).hash; }
+  string      str(id_type id) const             { return string(c_str(id), length(id)); }
+
+  size_type   size() const noexcept  { return size_.load(std::memory_order_acquire); }
+  size_type   max_size() const noexcept { return segment_begin(string_interner_segment_count); }
+  bool        empty() const noexcept { return size() == 0; }
+
+  // 字符块占用的字节数
+  size_type   arena_bytes() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+  }
+
+  void reserve(size_type count)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.reserve(count);
+  }
+
+  // 删除所有字符串，之前得到的 id 和指针都失效，不能与其他操作同时调用
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    release();
+  }
+
+private:
+  // id 所在的段和段内的位置
+  static unsigned segment_of(id_type id) noexcept
+  {
+    const uint64_t v = static_cast<uint64_t>(id) + (static_cast<uint64_t>(1) << string_interner_first_segment_bits);
+    return charconv_bit_width(v) - 1 - string_interner_first_segment_bits;
+  }
+
+  static size_type segment_begin(unsigned seg) noexcept
+  {
+    return ((static_cast<size_type>(1) << seg) - 1) << string_interner_first_segment_bits;
+  }
+
+  static size_type segment_length(unsigned seg) noexcept
+  {
+    return static_cast<size_type>(1) << (seg + string_interner_first_segment_bits);
+  }
+
+  const string_interner_entry& entry(id_type id) const noexcept
+  {
+    MYSTL_DEBUG(id < size());
+    const unsigned seg = segment_of(id);
+    return segments_[seg][id - segment_begin(seg)];
+  }
+
+  const char* store(const char* s, size_type n);
+  void        release() noexcept;
+};
+
+/*****************************************************************************************/
+
+constexpr string_interner::id_type string_interner::npos;
+
+inline string_interner::id_type string_interner::intern(const char* s, size_type n)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const string_interner_key probe = { s, n, 0 };
+  const auto it = index_.find(probe);
+  if (it != index_.end())
+    return it->id;
+
+  const id_type id = size_.load(std::memory_order_relaxed);
+  THROW_LENGTH_ERROR_IF(id >= max_size(), "string_interner has too many strings");
+  const unsigned seg = segment_of(id);
+  if (segments_[seg] == nullptr)
+    segments_[seg] = entry_allocator::allocate(segment_length(seg));
+
+  // 先放入字符和索引，全部成功后再发布新的 id
+  const char* data = store(s, n);
+  const string_interner_key key = { data, n, id };
+  index_.insert_unique(key);
+  string_interner_entry& e = segments_[seg][id - segment_begin(seg)];
+  e.data = data;
+  e.size = n;
+  e.hash = mystl::hash_bytes(data, n);
+  size_.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+inline string_interner::id_type string_interner::find(const char* s, size_type n) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const string_interner_key probe = { s, n, 0 };
+  const auto it = index_.find(probe);
+  return it != index_.end() ? it->id : npos;
+}
+
+// 把 [s, s + n) 复制到字符块中并加上结尾空字符
+inline const char* string_interner::store(const char* s, size_type n)
+{
+  const size_type need = n + 1;
+  if (need > left_)
+  {
+    // 长字符串单独占用一块，不浪费当前块的剩余空间
+    const bool own = need > string_interner_block_size / 4;
+    const size_type len = own ? need : string_interner_block_size;
+    // 先保证 push_back 不会失败，再分配字符块
+    if (blocks_.size() == blocks_.capacity())
+      blocks_.reserve(mystl::max(static_cast<size_type>(16), blocks_.size() * 2));
+    char* block = char_allocator::allocate(len);
+    blocks_.push_back(block);
+    bytes_ += len;
+    if (own)
+    {
+      mystl::char_traits<char>::copy(block, s, n);
+      block[n] = '\0';
+      return block;
+    }
+    cur_ = block;
+    left_ = len;
+  }
+  char* p = cur_;
+  mystl::char_traits<char>::copy(p, s, n);
+  p[n] = '\0';
+  cur_ += need;
+  left_ -= need;
+  return p;
+}
+
+inline void string_interner::release() noexcept
+{
+  for (auto block : blocks_)
+    char_allocator::deallocate(block);
+  blocks_.clear();
+  for (unsigned seg = 0; seg < string_interner_segment_count; ++seg)
+  {
+    if (segments_[seg] != nullptr)
+    {
+      entry_allocator::deallocate(segments_[seg], segment_length(seg));
+      segments_[seg] = nullptr;
+    }
+  }
+  cur_ = nullptr;
+  left_ = 0;
+  bytes_ = 0;
+  size_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace mystl
+#endif // !MYTINYSTL_STRING_INTERNER_H_
@@ -39,6 +39,33 @@ struct is_pair : mystl::m_false_type {};
 template <class T1, class T2>
 struct is_pair<mystl::pair<T1, T2>> : mystl::m_true_type {};
 
+// can_extract_key
+// 判断 emplace 的参数能否在构造元素之前直接取得键值，参数一代表键值类型，参数二代表元素类型
+// 满足以下情况之一时可以直接取得：
+//   * 只有一个参数，且参数的类型就是元素类型
+//   * 元素类型为 pair，只有一个参数且参数为 pair，其 first 的类型就是键值类型
+//   * 元素类型为 pair，有两个参数且第一个参数的类型就是键值类型
+
+template <class Key, class Value, class Arg>
+struct can_extract_key_from_pair : mystl::m_false_type {};
+
+template <class Key, class T1, class T2, class U1, class U2>
+struct can_extract_key_from_pair<Key, mystl::pair<T1, T2>, mystl::pair<U1, U2>>
+  : mystl::m_bool_constant<std::is_same<typename std::remove_cv<U1>::type, Key>::value> {};
+
+template <class Key, class Value, class ...Args>
+struct can_extract_key : mystl::m_false_type {};
+
+template <class Key, class Value, class Arg>
+struct can_extract_key<Key, Value, Arg>
+  : mystl::m_bool_constant<std::is_same<typename std::decay<Arg>::type, Value>::value ||
+                           can_extract_key_from_pair<Key, Value, typename std::decay<Arg>::type>::value> {};
+
+template <class Key, class Value, class Arg1, class Arg2>
+struct can_extract_key<Key, Value, Arg1, Arg2>
+  : mystl::m_bool_constant<is_pair<Value>::value &&
+                           std::is_same<typename std::decay<Arg1>::type, Key>::value> {};
+
 } // namespace mystl
 
 #endif // !MYTINYSTL_TYPE_TRAITS_H_
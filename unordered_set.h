@@ -17,6 +17,9 @@
 namespace mystl
 {
 
+template <class Key, class Hash, class KeyEqual>
+class unordered_multiset;
+
 // 模板类 unordered_set，键值不允许重复
 // 参数一代表键值类型，参数二代表哈希函数，缺省使用 mystl::hash，
 // 参数三代表键值比较方式，缺省使用 mystl::equal_to
@@ -28,6 +31,10 @@ private:
   typedef hashtable<Key, Hash, KeyEqual> base_type;
   base_type ht_;
 
+  // 不同哈希函数或比较函数的 unordered_set 与 unordered_multiset 之间可以相互转移节点
+  template <class, class, class> friend class unordered_set;
+  template <class, class, class> friend class unordered_multiset;
+
 public:
   // 使用 hashtable 的型别
   typedef typename base_type::allocator_type       allocator_type;
@@ -48,6 +55,10 @@ public:
   typedef typename base_type::const_local_iterator local_iterator;
   typedef typename base_type::const_local_iterator const_local_iterator;
 
+  typedef mystl::node_handle<value_type, typename base_type::node_type, false> node_type;
+  typedef mystl::node_insert_return<typename base_type::const_iterator, node_type>
+                                                   insert_return_type;
+
   allocator_type get_allocator() const { return ht_.get_allocator(); }
 
 public:
@@ -180,6 +191,40 @@ public:
   void      clear()
   { ht_.clear(); }
 
+  // 节点的摘取与接合
+
+  node_type extract(const_iterator position)
+  { return node_type(ht_.extract_node(position)); }
+  node_type extract(const key_type& key)
+  {
+    auto it = ht_.find(key);
+    return it == ht_.end() ? node_type() : node_type(ht_.extract_node(it));
+  }
+
+  insert_return_type insert(node_type&& nh)
+  {
+    if (nh.empty())
+      return insert_return_type{end(), false, node_type()};
+    auto res = ht_.reinsert_node_unique(nh.get());
+    if (!res.second)
+      return insert_return_type{res.first, false, mystl::move(nh)};
+    nh.release();
+    return insert_return_type{res.first, true, node_type()};
+  }
+
+  template <class Hash2, class KeyEqual2>
+  void      merge(unordered_set<Key, Hash2, KeyEqual2>& source)
+  { ht_.merge_unique(source.ht_); }
+  template <class Hash2, class KeyEqual2>
+  void      merge(unordered_set<Key, Hash2, KeyEqual2>&& source)
+  { ht_.merge_unique(source.ht_); }
+  template <class Hash2, class KeyEqual2>
+  void      merge(unordered_multiset<Key, Hash2, KeyEqual2>& source)
+  { ht_.merge_unique(source.ht_); }
+  template <class Hash2, class KeyEqual2>
+  void      merge(unordered_multiset<Key, Hash2, KeyEqual2>&& source)
+  { ht_.merge_unique(source.ht_); }
+
   void      swap(unordered_set& other) noexcept
   { ht_.swap(other.ht_); }
 
@@ -193,6 +238,18 @@ public:
   const_iterator find(const key_type& key)  const 
   { return ht_.find(key); }
 
+  // 批量查找 [first, last) 中的键值，依次把每个键值的查找结果写入 result 开始的位置，
+  // 一批键值的缓存缺失可以互相重叠，适合大量查找
+  template <class ForwardIter, class OutputIter>
+  OutputIter     find_batch(ForwardIter first, ForwardIter last, OutputIter result)
+  { return ht_.find_batch(first, last, result); }
+  template <class ForwardIter, class OutputIter>
+  OutputIter     find_batch(ForwardIter first, ForwardIter last, OutputIter result) const
+  { return ht_.find_batch(first, last, result); }
+  template <class ForwardIter, class OutputIter>
+  OutputIter     count_batch(ForwardIter first, ForwardIter last, OutputIter result) const
+  { return ht_.count_batch(first, last, result); }
+
   pair<iterator, iterator> equal_range(const key_type& key)
   { return ht_.equal_range_unique(key); }
   pair<const_iterator, const_iterator> equal_range(const key_type& key) const
@@ -234,6 +291,14 @@ public:
   void      rehash(size_type count)                 { ht_.rehash(count); }
   void      reserve(size_type count)                { ht_.reserve(count); }
 
+  bool      incremental_rehash()     const noexcept { return ht_.incremental_rehash(); }
+  void      incremental_rehash(bool on)             { ht_.incremental_rehash(on); }
+  void      rehash_step(size_type n)                { ht_.rehash_step(n); }
+
+  // 开启后查找不存在的键值时大多不需要访问 bucket，适合查找多数落空的场景
+  bool      use_bloom_filter()       const noexcept { return ht_.use_bloom_filter(); }
+  void      use_bloom_filter(bool on)               { ht_.use_bloom_filter(on); }
+
   hasher    hash_fcn()               const          { return ht_.hash_fcn(); }
   key_equal key_eq()                 const          { return ht_.key_eq(); }
 
@@ -285,6 +350,10 @@ private:
   typedef hashtable<Key, Hash, KeyEqual> base_type;
   base_type ht_;
 
+  // 不同哈希函数或比较函数的 unordered_set 与 unordered_multiset 之间可以相互转移节点
+  template <class, class, class> friend class unordered_set;
+  template <class, class, class> friend class unordered_multiset;
+
 public:
   // 使用 hashtable 的型别
   typedef typename base_type::allocator_type       allocator_type;
@@ -305,6 +374,8 @@ public:
   typedef typename base_type::const_local_iterator local_iterator;
   typedef typename base_type::const_local_iterator const_local_iterator;
 
+  typedef mystl::node_handle<value_type, typename base_type::node_type, false> node_type;
+
   allocator_type get_allocator() const { return ht_.get_allocator(); }
 
 public:
@@ -425,6 +496,11 @@ public:
   void     insert(InputIterator first, InputIterator last)
   { ht_.insert_multi(first, last); }
 
+  // 插入已经按键值分组的区间，键值相等的元素不需要重复计算哈希值和查找链表
+  template <class InputIterator>
+  void     insert_grouped(InputIterator first, InputIterator last)
+  { ht_.insert_multi_grouped(first, last); }
+
   // erase / clear
 
   void      erase(iterator it)
@@ -438,6 +514,38 @@ public:
   void      clear()
   { ht_.clear(); }
 
+  // 节点的摘取与接合
+
+  node_type extract(const_iterator position)
+  { return node_type(ht_.extract_node(position)); }
+  node_type extract(const key_type& key)
+  {
+    auto it = ht_.find(key);
+    return it == ht_.end() ? node_type() : node_type(ht_.extract_node(it));
+  }
+
+  iterator  insert(node_type&& nh)
+  {
+    if (nh.empty())
+      return end();
+    auto it = ht_.reinsert_node_multi(nh.get());
+    nh.release();
+    return it;
+  }
+
+  template <class Hash2, class KeyEqual2>
+  void      merge(unordered_set<Key, Hash2, KeyEqual2>& source)
+  { ht_.merge_multi(source.ht_); }
+  template <class Hash2, class KeyEqual2>
+  void      merge(unordered_set<Key, Hash2, KeyEqual2>&& source)
+  { ht_.merge_multi(source.ht_); }
+  template <class Hash2, class KeyEqual2>
+  void      merge(unordered_multiset<Key, Hash2, KeyEqual2>& source)
+  { ht_.merge_multi(source.ht_); }
+  template <class Hash2, class KeyEqual2>
+  void      merge(unordered_multiset<Key, Hash2, KeyEqual2>&& source)
+  { ht_.merge_multi(source.ht_); }
+
   void      swap(unordered_multiset& other) noexcept 
   { ht_.swap(other.ht_); }
 
@@ -451,6 +559,18 @@ public:
   const_iterator find(const key_type& key)  const 
   { return ht_.find(key); }
 
+  // 批量查找 [first, last) 中的键值，依次把每个键值的查找结果写入 result 开始的位置，
+  // 一批键值的缓存缺失可以互相重叠，适合大量查找
+  template <class ForwardIter, class OutputIter>
+  OutputIter     find_batch(ForwardIter first, ForwardIter last, OutputIter result)
+  { return ht_.find_batch(first, last, result); }
+  template <class ForwardIter, class OutputIter>
+  OutputIter     find_batch(ForwardIter first, ForwardIter last, OutputIter result) const
+  { return ht_.find_batch(first, last, result); }
+  template <class ForwardIter, class OutputIter>
+  OutputIter     count_batch(ForwardIter first, ForwardIter last, OutputIter result) const
+  { return ht_.count_batch(first, last, result); }
+
   pair<iterator, iterator> equal_range(const key_type& key)
   { return ht_.equal_range_multi(key); }
   pair<const_iterator, const_iterator> equal_range(const key_type& key) const
@@ -492,6 +612,14 @@ public:
   void      rehash(size_type count)                 { ht_.rehash(count); }
   void      reserve(size_type count)                { ht_.reserve(count); }
 
+  bool      incremental_rehash()     const noexcept { return ht_.incremental_rehash(); }
+  void      incremental_rehash(bool on)             { ht_.incremental_rehash(on); }
+  void      rehash_step(size_type n)                { ht_.rehash_step(n); }
+
+  // 开启后查找不存在的键值时大多不需要访问 bucket，适合查找多数落空的场景
+  bool      use_bloom_filter()       const noexcept { return ht_.use_bloom_filter(); }
+  void      use_bloom_filter(bool on)               { ht_.use_bloom_filter(on); }
+
   hasher    hash_fcn()               const          { return ht_.hash_fcn(); }
   key_equal key_eq()                 const          { return ht_.key_eq(); }
 
@@ -6,6 +6,14 @@
 #include <cstddef>
 
 #include "type_traits.h"
+#include "functional.h"
+
+// 软件预取，不支持的编译器上为空操作
+#if defined(__GNUC__) || defined(__clang__)
+#define MYSTL_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define MYSTL_PREFETCH(addr) ((void)0)
+#endif
 
 namespace mystl
 {
@@ -60,6 +68,12 @@ void swap(Tp(&a)[N], Tp(&b)[N])
 // --------------------------------------------------------------------------------------
 // pair
 
+// 分段构造标签：pair(piecewise_second, a, args...) 以 a 构造 first，以 args 直接构造 second
+// try_emplace 用它在节点中原地构造元素，实值不需要可移动
+struct piecewise_second_tag {};
+
+static constexpr piecewise_second_tag piecewise_second{};
+
 // 结构体模板 : pair
 // 两个模板参数分别表示两个数据的类型
 // 用 first 和 second 来分别取出第一个数据和第二个数据
@@ -109,6 +123,14 @@ struct pair
   pair(const pair& rhs) = default;
   pair(pair&& rhs) = default;
 
+  // piecewise construct
+  template <class Other1, class ...Args>
+    constexpr pair(piecewise_second_tag, Other1&& a, Args&& ...args)
+    : first(mystl::forward<Other1>(a)),
+    second(mystl::forward<Args>(args)...)
+  {
+  }
+
   // implicit constructiable for other type
   template <class Other1, class Other2,
     typename std::enable_if<
@@ -291,6 +313,24 @@ pair<Ty1, Ty2> make_pair(Ty1&& first, Ty2&& second)
   return pair<Ty1, Ty2>(mystl::forward<Ty1>(first), mystl::forward<Ty2>(second));
 }
 
+// 特化 mystl::hash，两个成员的哈希值按顺序组合
+template <class Ty1, class Ty2>
+struct hash<pair<Ty1, Ty2>>
+{
+  typedef void is_avalanching;
+  size_t operator()(const pair<Ty1, Ty2>& p) const
+  { return hash_values(p.first, p.second); }
+};
+
+// 有序区间标签，批量插入时表示输入区间已经按键值排好序，可以省去排序
+// sorted_unique     : 键值严格递增，没有重复
+// sorted_equivalent : 键值非递减，可以重复
+struct sorted_unique_tag {};
+struct sorted_equivalent_tag {};
+
+static constexpr sorted_unique_tag     sorted_unique{};
+static constexpr sorted_equivalent_tag sorted_equivalent{};
+
 }
 
 #endif // !MYTINYSTL_UTIL_H_